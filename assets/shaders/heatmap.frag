@@ -0,0 +1,33 @@
+#version 330 core
+
+// ------------------------------------------------------------------------- //
+// Input																	 //
+// ------------------------------------------------------------------------- //
+in vec4 inColor;
+in vec2 inTexCoords;
+
+out vec4 color;
+
+// What the instrumentation build of the compute shader counted
+// for each pixel: (visits, pushes, pops, iterations).
+uniform usampler2D costs;
+
+// Which of the four to show, and the count that gets the top
+// of the ramp.
+uniform int		channel;
+uniform float	scale;
+
+// ------------------------------------------------------------------------- //
+// Main																		 //
+// ------------------------------------------------------------------------- //
+// Black through blue, green and yellow to red as the count
+// goes from zero to scale. Anything over stays red.
+void main()
+{
+	vec3 ramp[5] = vec3[5](vec3(0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0), vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0));
+
+	float x = clamp(float(texture(costs, inTexCoords)[channel]) / scale, 0.0, 1.0) * 4.0;
+	int i = min(int(x), 3);
+
+	color = vec4(mix(ramp[i], ramp[i + 1], x - float(i)), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 330 core
+
+in vec4 inColor;
+in vec2 inTexCoords;
+
+out vec4 color;
+
+// The faces of the mesh renderer are flat colored, already
+// shaded by their type and which way they face (see FaceColor).
+void main()
+{
+	color = inColor;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#version 330 core
+
+// ------------------------------------------------------------------------- //
+// Input																	 //
+// ------------------------------------------------------------------------- //
+in vec4 inColor;
+in vec2 inTexCoords;
+
+out vec4 color;
+
+// What the compute shader traced, one packed uint per pixel:
+// bits 0 - 1 are the face we hit (0 for x, 1 for y, 2 for z),
+// bits 2 - 13 the voxel type and bits 14 - 31 the distance to
+// the hit in sixteenths of a voxel. Zero means we missed.
+uniform usampler2D gBuffer;
+
+// ------------------------------------------------------------------------- //
+// Main																		 //
+// ------------------------------------------------------------------------- //
+// A flat color per voxel type, darkened a little depending on
+// which face we hit so the edges of things stay readable.
+void main()
+{
+	vec3 palette[4] = vec3[4](vec3(1.0), vec3(0.5, 0.5, 0.52), vec3(0.86, 0.78, 0.55), vec3(0.12, 0.3, 0.55));
+	float faceShade[3] = float[3](0.8, 0.65, 1.0);
+
+	uint result = texture(gBuffer, inTexCoords).r;
+	if (result == 0u)
+	{
+		color = vec4(0.0);
+		return;
+	}
+
+	uint face = min(result & 3u, 2u);
+	uint type = (result >> 2) & 4095u;
+
+	color = inColor * vec4(palette[min(type, 3u)] * faceShade[face], 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 330 core
+
+in vec4 inColor;
+in vec2 inTexCoords;
+
+out vec4 color;
+
+uniform sampler2D atlas;
+
+void main()
+{
+	color = inColor * texture(atlas, inTexCoords);
+}
\ No newline at end of file
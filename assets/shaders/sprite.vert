@@ -0,0 +1,23 @@
+#version 330 core
+
+// ------------------------------------------------------------------------- //
+// Sprite																	 //
+// ------------------------------------------------------------------------- //
+// Corners come in as whole pixels from the bottom left of the screen (see
+// SpriteVertex in spritebatch.h); the texture coordinates and color are
+// normalized by the vertex fetch.
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoords;
+layout(location = 2) in vec4 color;
+
+out vec4 inColor;
+out vec2 inTexCoords;
+
+uniform vec2 screen;
+
+void main()
+{
+	inColor = color;
+	inTexCoords = texCoords;
+	gl_Position = vec4(position / screen * 2.0 - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
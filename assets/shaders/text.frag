@@ -0,0 +1,23 @@
+#version 330 core
+
+// ------------------------------------------------------------------------- //
+// Text																		 //
+// ------------------------------------------------------------------------- //
+// Glyphs are signed distance fields (see glyphcache.h): the edge is at 0.5,
+// inside is above it. However much the glyph's been scaled, we smooth the
+// edge over about a pixel on screen, which is how far the distance changes
+// across one (fwidth).
+in vec4 inColor;
+in vec2 inTexCoords;
+
+out vec4 color;
+
+uniform sampler2D atlas;
+
+void main()
+{
+	float distance = texture(atlas, inTexCoords).r;
+	float edge = max(fwidth(distance), 1e-4) * 0.5;
+
+	color = vec4(inColor.rgb, inColor.a * smoothstep(0.5 - edge, 0.5 + edge, distance));
+}
\ No newline at end of file
@@ -0,0 +1,271 @@
+// ------------------------------------------------------------------------- //
+// Traversal																 //
+// ------------------------------------------------------------------------- //
+// The octree traversal from Laine & Karras 2010 (see base.comp), shared by
+// the compute shader and the CPU. base.comp pulls it in with #include, which
+// ReadCode resolves, and src/world/traversal.cpp compiles it as C++ inside a
+// struct whose voxels member stands in for the voxel buffer. Either way, the
+// includer has to have declared Voxel and voxels first.
+//
+// So that the one file compiles as both, everything in here sticks to what
+// GLSL and glm have in common: no swizzles, no constructors for structs, no
+// out parameters (INOUT stands in for inout), float literals with an f, and
+// nothing but scalar maths on the components where glm and GLSL differ.
+#ifndef TRAVERSE_GLSL
+#define TRAVERSE_GLSL
+
+#ifdef __cplusplus
+typedef unsigned int uint;
+#define INOUT(type)	type&
+#else
+#define INOUT(type)	inout type
+#endif
+
+// ------------------------------------------------------------------------- //
+// Constants																 //
+// ------------------------------------------------------------------------- //
+// The traversal works in a copy of the octree scaled to [1, 2] on every
+// axis, where a cube's position is exactly the bits of its float (see Pop),
+// and the scale of a cube is the exponent of its size: 2^(scale - MAX_SCALE).
+// The root is at MAX_SCALE. The stack holds one entry per level below the
+// root, so MAX_DEPTH is the deepest octree we can trace, 2^16 on a side.
+#define MAX_SCALE	23
+#define MAX_DEPTH	16
+#define MAX_STEPS	4096
+#define NO_HIT		1e30f
+
+// The includer can count what each ray's traversal does (see base.comp).
+#ifndef COUNT
+#define COUNT(counter)
+#endif
+
+// ------------------------------------------------------------------------- //
+// Structs																	 //
+// ------------------------------------------------------------------------- //
+// ---------------------------------------------------------- //
+// Hit														  //
+// ---------------------------------------------------------- //
+// The first solid voxel a ray hits: how far along the ray it
+// is, its type, and the axis the ray entered it through (0
+// for x, 1 for y and 2 for z). A miss is NO_HIT away.
+struct Hit
+{
+	float	t;
+	uint	type;
+	uint	face;
+};
+
+// ------------------------------------------------------------------------- //
+// Functions																 //
+// ------------------------------------------------------------------------- //
+// Trace ---------------------------------------------------- //
+// Walks the octree of the given size (centered on the origin)
+// front to back and returns the first solid leaf the ray hits,
+// ignoring anything that ends before tStart.
+//
+// Rather than intersect every child with the ray, we keep the
+// ray's t at each axis's planes as t = x * coef - bias, and
+// mirror the octree so the ray's direction is negative on
+// every axis. Then the cube we're in is always left through
+// its lower corner, the sibling it crosses into is the one
+// whose index has that axis's bit cleared, and a bit going
+// from clear to set means we've left the parent. idx is the
+// child we're in, mirrored; idx ^ mirror is the real one.
+//
+// Descending pushes the parent's children and t_max at the
+// level we're leaving. Leaving a parent pops straight to the
+// level of the nearest common ancestor of where we were and
+// where we're going, which is the highest bit that differs
+// between the two positions, so we never walk back up level
+// by level and never revisit a node.
+Hit Trace(vec3 origin, vec3 direction, uint size, float tStart, INOUT(uint) steps)
+{
+	Hit hit;
+	hit.t = NO_HIT;
+	hit.type = 0u;
+	hit.face = 0u;
+
+	// Scaling by the size keeps t in world units, so the hit
+	// distance needs no converting back.
+	float s = float(size);
+	vec3 p = origin / s + vec3(1.5f);
+	vec3 d = direction;
+
+	// 1/0 would make NaNs of the planes. The camera already
+	// nudges its rays off the axes, and we do the same for
+	// anything else.
+	if (abs(d.x) < 1e-6f) d.x = (d.x < 0.0f) ? -1e-6f : 1e-6f;
+	if (abs(d.y) < 1e-6f) d.y = (d.y < 0.0f) ? -1e-6f : 1e-6f;
+	if (abs(d.z) < 1e-6f) d.z = (d.z < 0.0f) ? -1e-6f : 1e-6f;
+	d = d / s;
+
+	float txCoef = 1.0f / -abs(d.x);
+	float tyCoef = 1.0f / -abs(d.y);
+	float tzCoef = 1.0f / -abs(d.z);
+
+	float txBias = txCoef * p.x;
+	float tyBias = tyCoef * p.y;
+	float tzBias = tzCoef * p.z;
+
+	// Mirroring an axis is x -> 3 - x, which only changes the
+	// bias.
+	int mirror = 0;
+	if (d.x > 0.0f) { mirror ^= 1; txBias = 3.0f * txCoef - txBias; }
+	if (d.y > 0.0f) { mirror ^= 2; tyBias = 3.0f * tyCoef - tyBias; }
+	if (d.z > 0.0f) { mirror ^= 4; tzBias = 3.0f * tzCoef - tzBias; }
+
+	// Where the ray is inside the root. Mirrored, it comes in
+	// through the planes at 2 and leaves through the ones at 1.
+	float tMin = max(max(2.0f * txCoef - txBias, 2.0f * tyCoef - tyBias), 2.0f * tzCoef - tzBias);
+	float tMax = min(min(txCoef - txBias, tyCoef - tyBias), tzCoef - tzBias);
+	tMin = max(tMin, tStart);
+	if (tMin >= tMax) return hit;
+
+	Voxel root = voxels[0];
+	COUNT(cost.x);
+	if (root.children < 0) return hit;
+
+	int stackParent[MAX_DEPTH];
+	float stackTMax[MAX_DEPTH];
+
+	int parent = root.children;
+	int idx = 0;
+	vec3 pos = vec3(1.0f);
+	int scale = MAX_SCALE - 1;
+	float scaleExp2 = 0.5f;
+	float h = tMax;
+
+	// The child of the root the ray starts in is on the far
+	// side of whichever centre planes it's already crossed.
+	if (1.5f * txCoef - txBias > tMin) { idx ^= 1; pos.x = 1.5f; }
+	if (1.5f * tyCoef - tyBias > tMin) { idx ^= 2; pos.y = 1.5f; }
+	if (1.5f * tzCoef - tzBias > tMin) { idx ^= 4; pos.z = 1.5f; }
+
+	while (scale < MAX_SCALE && steps < MAX_STEPS)
+	{
+		steps++;
+		COUNT(cost.w);
+
+		// Where the ray leaves the child we're in.
+		float txCorner = pos.x * txCoef - txBias;
+		float tyCorner = pos.y * tyCoef - tyBias;
+		float tzCorner = pos.z * tzCoef - tzBias;
+		float tcMax = min(min(txCorner, tyCorner), tzCorner);
+
+		Voxel child = voxels[parent + (idx ^ mirror)];
+		COUNT(cost.x);
+
+		// Empty children (leaves of type 0) are stepped over.
+		if ((child.children >= 0 || child.type != 0u) && tMin <= tMax)
+		{
+			float tvMax = min(tMax, tcMax);
+
+			if (tMin <= tvMax)
+			{
+				// A solid leaf is the hit. The ray's at tMin, where
+				// it came into the leaf (or tStart, if later), and
+				// came in through whichever upper plane it crossed
+				// last.
+				if (child.children < 0)
+				{
+					float txEntry = (pos.x + scaleExp2) * txCoef - txBias;
+					float tyEntry = (pos.y + scaleExp2) * tyCoef - tyBias;
+					float tzEntry = (pos.z + scaleExp2) * tzCoef - tzBias;
+
+					hit.t = tMin;
+					hit.type = child.type;
+					hit.face = (txEntry >= tyEntry && txEntry >= tzEntry) ? 0u : ((tyEntry >= tzEntry) ? 1u : 2u);
+					break;
+				}
+
+				// Push ----------------------------------------- //
+				// If we've already pushed this level on the way to
+				// a sibling that ends later, the entry's still good.
+				if (tcMax < h)
+				{
+					stackParent[MAX_SCALE - 1 - scale] = parent;
+					stackTMax[MAX_SCALE - 1 - scale] = tMax;
+					COUNT(cost.y);
+				}
+				h = tcMax;
+
+				float halfScale = scaleExp2 * 0.5f;
+				float txCenter = halfScale * txCoef + txCorner;
+				float tyCenter = halfScale * tyCoef + tyCorner;
+				float tzCenter = halfScale * tzCoef + tzCorner;
+
+				parent = child.children;
+				idx = 0;
+				scale--;
+				scaleExp2 = halfScale;
+				if (txCenter > tMin) { idx ^= 1; pos.x += scaleExp2; }
+				if (tyCenter > tMin) { idx ^= 2; pos.y += scaleExp2; }
+				if (tzCenter > tMin) { idx ^= 4; pos.z += scaleExp2; }
+
+				tMax = tvMax;
+				continue;
+			}
+		}
+
+		// Advance ------------------------------------------ //
+		// Step across whichever planes the ray leaves through
+		// first (more than one, on an edge or a corner).
+		int stepMask = 0;
+		if (txCorner <= tcMax) { stepMask ^= 1; pos.x -= scaleExp2; }
+		if (tyCorner <= tcMax) { stepMask ^= 2; pos.y -= scaleExp2; }
+		if (tzCorner <= tcMax) { stepMask ^= 4; pos.z -= scaleExp2; }
+
+		tMin = tcMax;
+		idx ^= stepMask;
+
+		// Pop ---------------------------------------------- //
+		// A bit going from clear to set means we've stepped out
+		// of the parent.
+		if ((idx & stepMask) != 0)
+		{
+			COUNT(cost.z);
+
+			int differing = 0;
+			if ((stepMask & 1) != 0) differing |= floatBitsToInt(pos.x) ^ floatBitsToInt(pos.x + scaleExp2);
+			if ((stepMask & 2) != 0) differing |= floatBitsToInt(pos.y) ^ floatBitsToInt(pos.y + scaleExp2);
+			if ((stepMask & 4) != 0) differing |= floatBitsToInt(pos.z) ^ floatBitsToInt(pos.z + scaleExp2);
+
+			// Out of the root altogether.
+			scale = findMSB(differing);
+			if (scale >= MAX_SCALE) break;
+			scaleExp2 = intBitsToFloat((scale - MAX_SCALE + 127) << 23);
+
+			parent = stackParent[MAX_SCALE - 1 - scale];
+			tMax = stackTMax[MAX_SCALE - 1 - scale];
+
+			// Round the position down to the cube at that scale.
+			int shx = floatBitsToInt(pos.x) >> scale;
+			int shy = floatBitsToInt(pos.y) >> scale;
+			int shz = floatBitsToInt(pos.z) >> scale;
+			pos.x = intBitsToFloat(shx << scale);
+			pos.y = intBitsToFloat(shy << scale);
+			pos.z = intBitsToFloat(shz << scale);
+			idx = (shx & 1) | ((shy & 1) << 1) | ((shz & 1) << 2);
+
+			h = 0.0f;
+		}
+	}
+
+	return hit;
+}
+
+// Pack ----------------------------------------------------- //
+// What the trace writes to the G-buffer: the face in bits 0 -
+// 1, the voxel type in bits 2 - 13 and the distance in
+// sixteenths of a voxel in bits 14 - 31. resolve.frag shades
+// it when it's drawn. A miss is zero, which no hit can be
+// since solid voxels aren't type 0.
+uint Pack(Hit hit)
+{
+	if (hit.t >= NO_HIT) return 0u;
+
+	uint depth = uint(clamp(hit.t * 16.0f, 0.0f, 262143.0f));
+	return (depth << 14) | (min(hit.type, 4095u) << 2) | hit.face;
+}
+
+#endif
\ No newline at end of file
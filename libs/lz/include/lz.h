@@ -0,0 +1,21 @@
+#ifndef LZ_H
+#define LZ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Worst-case compressed size of `size` bytes of input. */
+int lz_bound(int size);
+
+/* Compresses one block. Returns the compressed size, or 0 if dstCapacity < lz_bound(srcSize). */
+int lz_compress(const unsigned char* src, int srcSize, unsigned char* dst, int dstCapacity);
+
+/* Decompresses one block. Returns the decompressed size, or -1 on malformed input. */
+int lz_decompress(const unsigned char* src, int srcSize, unsigned char* dst, int dstSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,185 @@
+#include "lz.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LZ_HASH_LOG		16
+#define LZ_MIN_MATCH	4
+#define LZ_MAX_OFFSET	65535
+#define LZ_LAST_LITERALS	5
+#define LZ_MATCH_LIMIT	12
+
+static unsigned int lz_read32(const unsigned char* p)
+{
+	unsigned int v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static unsigned int lz_hash(unsigned int v)
+{
+	return (v * 2654435761u) >> (32 - LZ_HASH_LOG);
+}
+
+static unsigned char* lz_write_length(unsigned char* op, int len)
+{
+	while (len >= 255)
+	{
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (unsigned char)len;
+	return op;
+}
+
+static unsigned char* lz_write_literals(unsigned char* op, const unsigned char* anchor, int litLen, int matchCode)
+{
+	unsigned char* token = op++;
+	*token = (unsigned char)(((litLen < 15) ? litLen : 15) << 4 | matchCode);
+	if (litLen >= 15) op = lz_write_length(op, litLen - 15);
+
+	memcpy(op, anchor, litLen);
+	return op + litLen;
+}
+
+int lz_bound(int size)
+{
+	return size + size / 255 + 16;
+}
+
+int lz_compress(const unsigned char* src, int srcSize, unsigned char* dst, int dstCapacity)
+{
+	const unsigned char* ip = src;
+	const unsigned char* anchor = src;
+	const unsigned char* iend = src + srcSize;
+	const unsigned char* mflimit = iend - LZ_MATCH_LIMIT;
+	const unsigned char* matchlimit = iend - LZ_LAST_LITERALS;
+	unsigned char* op = dst;
+	int* table;
+	int misses = 0;
+
+	if (dstCapacity < lz_bound(srcSize)) return 0;
+
+	table = (int*)malloc(sizeof(int) << LZ_HASH_LOG);
+	if (table == NULL) return 0;
+	memset(table, 0xff, sizeof(int) << LZ_HASH_LOG);
+
+	if (srcSize > LZ_MATCH_LIMIT)
+	{
+		while (ip < mflimit)
+		{
+			unsigned int h = lz_hash(lz_read32(ip));
+			int ref = table[h];
+			const unsigned char* match;
+			int len, litLen, offset;
+
+			table[h] = (int)(ip - src);
+
+			if (ref < 0 || (ip - src) - ref > LZ_MAX_OFFSET || lz_read32(src + ref) != lz_read32(ip))
+			{
+				/* Skip ahead faster through data that doesn't compress. */
+				ip += 1 + (misses++ >> 6);
+				continue;
+			}
+			misses = 0;
+			match = src + ref;
+
+			while (ip > anchor && match > src && ip[-1] == match[-1])
+			{
+				ip--;
+				match--;
+			}
+
+			len = LZ_MIN_MATCH;
+			while (ip + len < matchlimit && ip[len] == match[len]) len++;
+
+			litLen = (int)(ip - anchor);
+			offset = (int)(ip - match);
+
+			op = lz_write_literals(op, anchor, litLen, ((len - LZ_MIN_MATCH) < 15) ? (len - LZ_MIN_MATCH) : 15);
+			*op++ = (unsigned char)(offset & 0xff);
+			*op++ = (unsigned char)(offset >> 8);
+			if (len - LZ_MIN_MATCH >= 15) op = lz_write_length(op, len - LZ_MIN_MATCH - 15);
+
+			ip += len;
+			anchor = ip;
+
+			if (ip < mflimit) table[lz_hash(lz_read32(ip - 2))] = (int)(ip - 2 - src);
+		}
+	}
+
+	op = lz_write_literals(op, anchor, (int)(iend - anchor), 0);
+
+	free(table);
+	return (int)(op - dst);
+}
+
+int lz_decompress(const unsigned char* src, int srcSize, unsigned char* dst, int dstSize)
+{
+	const unsigned char* ip = src;
+	const unsigned char* iend = src + srcSize;
+	unsigned char* op = dst;
+	unsigned char* oend = dst + dstSize;
+
+	while (ip < iend)
+	{
+		unsigned int token = *ip++;
+		size_t len = token >> 4;
+		size_t offset;
+		const unsigned char* match;
+
+		if (len == 15)
+		{
+			unsigned int b;
+			do
+			{
+				if (ip >= iend) return -1;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+
+		if (len > (size_t)(iend - ip) || len > (size_t)(oend - op)) return -1;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		/* The last sequence is literals only. */
+		if (ip >= iend) break;
+
+		if (iend - ip < 2) return -1;
+		offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - dst)) return -1;
+
+		len = token & 15;
+		if (len == 15)
+		{
+			unsigned int b;
+			do
+			{
+				if (ip >= iend) return -1;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		len += LZ_MIN_MATCH;
+		if (len > (size_t)(oend - op)) return -1;
+
+		/*
+			Overlapping matches repeat the last `offset` bytes, so we can
+			copy in chunks that double in size instead of byte by byte.
+		*/
+		match = op - offset;
+		while (len > 0)
+		{
+			size_t n = (size_t)(op - match);
+			if (n > len) n = len;
+			memcpy(op, match, n);
+			op += n;
+			len -= n;
+		}
+	}
+
+	return (int)(op - dst);
+}
@@ -0,0 +1,452 @@
+// bench.cpp
+//
+// Flies the camera along a fixed path over a world generated from a
+// fixed seed and times every frame, so runs can be compared across
+// commits. Renders into a hidden window, so nobody has to sit and
+// watch it. Prints JSON: frame time percentiles, GPU pass times,
+// traversal stats and memory.
+//
+// With validate, it checks the renderer instead of timing it, at
+// points along the same path, and exits with 2 if any check fails:
+//
+//   beam         the beam pre-pass against a single-pass trace, which
+//                must match pixel for pixel, with the steps each took
+//   reprojection what panning builds up in the ring, over pans of
+//                whole and part pixels, against a fresh trace
+//   edits        batches of random edits applied on the GPU by the
+//                VoxelEditor, read back (voxels and allocator) and
+//                compared with the same edits made on the CPU with
+//                AddVoxel and RemoveVoxel, which must be bit-identical
+//
+// Usage: winedark_bench [frames] [size] [output.json]
+//        winedark_bench validate [size] [output.json]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "../rendering/renderer.h"
+#include "../rendering/voxeleditor.h"
+#include "../world/generator.h"
+#include "../util/geometry.h"
+#include "../util/profiler.h"
+
+using Clock = std::chrono::steady_clock;
+
+const unsigned int SEED = 1;
+const unsigned int WIDTH = 1600;
+const unsigned int HEIGHT = 600;
+const unsigned int WARMUP = 5;
+const unsigned int VALIDATE_WIDTH = 320;
+const unsigned int VALIDATE_HEIGHT = 200;
+const unsigned int VALIDATE_POINTS = 8;
+const unsigned int VALIDATE_PANS = 16;
+const unsigned int VALIDATE_BATCHES = 16;
+const int VALIDATE_EDIT_RADIUS = 6;
+
+/*
+	The camera's path. It sweeps across the world and back while
+	tilting away from straight down and back again, so we see both
+	the cheap top-down case and the oblique one.
+*/
+struct Flythrough
+{
+	Winedark::BezierCurve			path;
+	Winedark::BezierQuaternion		rotation;
+
+	void Place(Winedark::Camera* camera, unsigned int frame, unsigned int frames)
+	{
+		float t = (frames > 1) ? (float)frame / (frames - 1) : 0.0f;
+		camera->SetPosition(path.GetPoint(t));
+		camera->SetRotation(rotation.GetQuaternion(t));
+	}
+};
+
+Flythrough MakeFlythrough(unsigned int size)
+{
+	float s = (float)size;
+	float z = -s - 100.0f;
+
+	Flythrough f;
+	f.path.points = { { 0.2f * s, 0.2f * s, z }, { 0.9f * s, 0.1f * s, z }, { 0.1f * s, 0.9f * s, z }, { 0.8f * s, 0.8f * s, z } };
+	f.rotation.rotations = { Winedark::Quaternion(), Winedark::Quaternion({ 1.0f, 0.0f, 0.0f }, 0.5f), Winedark::Quaternion({ 0.0f, 1.0f, 0.0f }, 0.4f), Winedark::Quaternion() };
+	return f;
+}
+
+double Percentile(std::vector<double> values, double p)
+{
+	if (values.empty()) return 0.0;
+
+	std::sort(values.begin(), values.end());
+	return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+/*
+	The timed run. Every frame moves the camera, so every
+	frame traces the whole view, and we wait for the GPU so
+	the time is the whole frame's.
+*/
+void Benchmark(Winedark::Renderer* renderer, Winedark::Camera* camera, Winedark::OctreeBuffer* buffer, Winedark::Octree* octree, unsigned int frames, std::ostringstream& json)
+{
+	unsigned int size = octree->GetSize();
+	Flythrough flythrough = MakeFlythrough(size);
+	std::vector<double> frameTimes;
+
+	for (unsigned int i = 0; i < WARMUP + frames; i++)
+	{
+		auto start = Clock::now();
+
+		flythrough.Place(camera, (i < WARMUP) ? 0 : i - WARMUP, frames);
+		camera->UpdateView();
+		camera->UpdateProjection();
+		buffer->Update();
+		renderer->Render();
+		glFinish();
+
+		if (i >= WARMUP) frameTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+	renderer->GetGpuTimer().Collect();
+	std::vector<Winedark::ZoneStats> zones = Winedark::GetProfileStats();
+
+	/*
+		Then the same path again, counting traversal steps.
+		Reading the counters back stalls, which is why this
+		isn't part of the timed run.
+	*/
+	Winedark::TraversalStats total = { 0, 0, 0, 0 };
+	renderer->SetCountSteps(true);
+	renderer->ReadTraversalStats();
+
+	for (unsigned int i = 0; i < frames; i++)
+	{
+		flythrough.Place(camera, i, frames);
+		renderer->Render();
+
+		Winedark::TraversalStats stats = renderer->ReadTraversalStats();
+		total.beamSteps += stats.beamSteps;
+		total.traceSteps += stats.traceSteps;
+		total.beamRays += stats.beamRays;
+		total.traceRays += stats.traceRays;
+	}
+	renderer->SetCountSteps(false);
+
+	/*
+		And out it all goes.
+	*/
+	double totalTime = 0.0;
+	for (double t : frameTimes) totalTime += t;
+
+	json << "{\n";
+	json << "  \"config\": { \"frames\": " << frames << ", \"size\": " << size << ", \"width\": " << WIDTH << ", \"height\": " << HEIGHT
+		 << ", \"seed\": " << SEED << ", \"renderer\": \"" << glGetString(GL_RENDERER) << "\", \"beam\": " << (renderer->GetBeamOptimization() ? "true" : "false")
+		 << ", \"localSize\": [" << renderer->GetLocalSizeX() << ", " << renderer->GetLocalSizeY() << "] },\n";
+	json << "  \"frameMs\": { \"mean\": " << totalTime / frameTimes.size() << ", \"p50\": " << Percentile(frameTimes, 0.5)
+		 << ", \"p95\": " << Percentile(frameTimes, 0.95) << ", \"p99\": " << Percentile(frameTimes, 0.99)
+		 << ", \"max\": " << Percentile(frameTimes, 1.0) << " },\n";
+
+	json << "  \"zonesMs\": {";
+	const char* separator = "\n";
+	for (auto& zone : zones)
+	{
+		json << separator << "    \"" << zone.name << "\": { \"count\": " << zone.count << ", \"p50\": " << zone.p50 << ", \"p95\": " << zone.p95 << ", \"p99\": " << zone.p99 << " }";
+		separator = ",\n";
+	}
+	json << "\n  },\n";
+
+	json << "  \"traversal\": { \"traceSteps\": " << total.traceSteps << ", \"traceRays\": " << total.traceRays
+		 << ", \"stepsPerRay\": " << (total.traceRays ? (double)total.traceSteps / total.traceRays : 0.0)
+		 << ", \"beamSteps\": " << total.beamSteps << ", \"beamRays\": " << total.beamRays << " },\n";
+
+	size_t voxelBytes = (size_t)octree->GetCapacity() * sizeof(Winedark::Voxel);
+	size_t usedBytes = (size_t)octree->GetCursor() * sizeof(Winedark::Voxel);
+	size_t imageBytes = (size_t)WIDTH * HEIGHT * sizeof(unsigned int);
+	json << "  \"memory\": { \"voxelPoolBytes\": " << voxelBytes << ", \"voxelsUsedBytes\": " << usedBytes
+		 << ", \"gpuBufferBytes\": " << voxelBytes + sizeof(Winedark::BufferData) << ", \"imageBytes\": " << imageBytes << " }\n";
+	json << "}\n";
+}
+
+/*
+	The checks. Each is run at VALIDATE_POINTS points along
+	the path, over a small view so the readbacks stay
+	quick, and counts what it finds wrong.
+*/
+bool Validate(Winedark::Renderer* renderer, Winedark::Camera* camera, Winedark::OctreeBuffer* buffer, Winedark::Octree* octree, std::ostringstream& json)
+{
+	unsigned int size = octree->GetSize();
+	Flythrough flythrough = MakeFlythrough(size);
+
+	auto place = [&](unsigned int point)
+	{
+		flythrough.Place(camera, point, VALIDATE_POINTS);
+		camera->UpdateView();
+		camera->UpdateProjection();
+		buffer->Update();
+		renderer->Render();
+	};
+
+	/*
+		The beam pre-pass only skips space the rays would
+		have found empty, so it must give the very same
+		image as tracing each ray on its own, in fewer
+		steps.
+	*/
+	Winedark::TraversalStats single = { 0, 0, 0, 0 };
+	Winedark::TraversalStats beam = { 0, 0, 0, 0 };
+	unsigned int beamMismatches = 0;
+
+	for (unsigned int i = 0; i < VALIDATE_POINTS; i++)
+	{
+		place(i);
+
+		Winedark::TraversalStats s, b;
+		beamMismatches += renderer->ValidateBeam(s, b);
+
+		single.traceSteps += s.traceSteps;
+		single.traceRays += s.traceRays;
+		beam.beamSteps += b.beamSteps;
+		beam.traceSteps += b.traceSteps;
+		beam.beamRays += b.beamRays;
+		beam.traceRays += b.traceRays;
+	}
+
+	/*
+		Reprojection: from each point we pan the camera a
+		little at a time, by whole and part pixels (and now
+		and then along the view, which has to start the
+		trace over), and after every pan what the ring has
+		built up must be what a fresh trace gives.
+	*/
+	unsigned int reprojectionMismatches = 0;
+	unsigned int pans = 0;
+	unsigned int reprojected = 0;
+	renderer->SetReprojection(true);
+	renderer->SetCountSteps(true);
+
+	for (unsigned int i = 0; i < VALIDATE_POINTS; i++)
+	{
+		place(i);
+
+		Winedark::Quaternion rotation = camera->GetRotation();
+		glm::vec3 right = Winedark::Rotate({ 1.0f, 0.0f, 0.0f }, rotation);
+		glm::vec3 up = Winedark::Rotate({ 0.0f, 1.0f, 0.0f }, rotation);
+		glm::vec3 forward = Winedark::Rotate({ 0.0f, 0.0f, 1.0f }, rotation);
+
+		for (unsigned int k = 0; k < VALIDATE_PANS; k++)
+		{
+			float dx = ((k * 7) % 11) * 0.37f - 1.5f;
+			float dy = ((k * 5) % 13) * 0.29f - 1.7f;
+			if (k % 5 == 4) dx *= 9.0f;
+
+			float dz = (k % 4 == 3) ? 0.5f : 0.0f;
+
+			camera->SetPosition(camera->GetPosition() + dx * right + dy * up + dz * forward);
+			camera->UpdateView();
+			camera->UpdateProjection();
+			renderer->ReadTraversalStats();
+			renderer->Render();
+			if (renderer->ReadTraversalStats().traceRays < VALIDATE_WIDTH * VALIDATE_HEIGHT) reprojected++;
+
+			reprojectionMismatches += renderer->ValidateReprojection();
+			pans++;
+		}
+	}
+	renderer->SetCountSteps(false);
+
+	/*
+		Edits, in pairs of batches: the first sweeps through
+		a cube somewhere in the world clearing nearly all of
+		it, so that branches get pruned and their blocks pile
+		up on the free list, with the odd voxel added along
+		the way to take some straight back. The second adds
+		and clears at random in the same cube, taking the
+		rest. The sweeps are longer than a dispatch. The
+		reference is a second copy of the world, edited
+		directly.
+	*/
+	Winedark::Octree* reference = new Winedark::Octree(size);
+	Winedark::GenerateSea(reference, SEED);
+	Winedark::VoxelEditor* editor = new Winedark::VoxelEditor(buffer);
+
+	std::mt19937 rng(SEED);
+	std::uniform_int_distribution<int> across(0, (int)size - 1);
+	std::uniform_int_distribution<int> around(-VALIDATE_EDIT_RADIUS, VALIDATE_EDIT_RADIUS);
+	std::uniform_int_distribution<int> count(1, 600);
+	std::uniform_int_distribution<int> type(0, 4);
+
+	unsigned int capacity = octree->GetCapacity();
+	std::vector<Winedark::Voxel> voxels(capacity);
+	std::vector<unsigned int> allocator(2 + capacity / 8);
+
+	unsigned int edits = 0;
+	unsigned int peakFree = 0;
+	unsigned int voxelMismatches = 0;
+	unsigned int allocatorMismatches = 0;
+
+	auto edit = [&](int x, int y, int z, uint16_t t)
+	{
+		x = std::clamp(x, 0, (int)size - 1);
+		y = std::clamp(y, 0, (int)size - 1);
+		z = std::clamp(z, 0, (int)size - 1);
+
+		octree->EditVoxel(x, y, z, t);
+		if (t == 0) reference->RemoveVoxel(x, y, z);
+		else reference->AddVoxel(x, y, z, t);
+	};
+
+	int cx = 0, cy = 0, cz = 0;
+
+	for (unsigned int b = 0; b < VALIDATE_BATCHES; b++)
+	{
+		if (b % 2 == 0)
+		{
+			cx = across(rng);
+			cy = across(rng);
+			cz = across(rng);
+
+			for (int z = cz - VALIDATE_EDIT_RADIUS; z <= cz + VALIDATE_EDIT_RADIUS; z++)
+			{
+				for (int y = cy - VALIDATE_EDIT_RADIUS; y <= cy + VALIDATE_EDIT_RADIUS; y++)
+				{
+					for (int x = cx - VALIDATE_EDIT_RADIUS; x <= cx + VALIDATE_EDIT_RADIUS; x++) edit(x, y, z, (type(rng) == 0) ? 1 : 0);
+				}
+			}
+		}
+		else
+		{
+			int n = count(rng);
+			for (int e = 0; e < n; e++) edit(cx + around(rng), cy + around(rng), cz + around(rng), (uint16_t)std::max(0, type(rng) - 1));
+		}
+
+		buffer->Update();
+		edits += editor->Apply();
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->GetSSBO());
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, capacity * sizeof(Winedark::Voxel), voxels.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->GetAllocatorSSBO());
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, allocator.size() * sizeof(unsigned int), allocator.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		/*
+			The buffer against the reference, and the octree's
+			mirror (replayed from the same edits) too.
+		*/
+		const Winedark::Voxel* expected = reference->GetVoxels();
+		const Winedark::Voxel* mirror = octree->GetVoxels();
+
+		for (unsigned int i = 0; i < capacity; i++)
+		{
+			if (voxels[i].type != expected[i].type || voxels[i].children != expected[i].children) voxelMismatches++;
+			if (mirror[i].type != expected[i].type || mirror[i].children != expected[i].children) voxelMismatches++;
+		}
+
+		const std::vector<unsigned int>& freeBlocks = reference->GetFreeBlocks();
+		peakFree = std::max(peakFree, (unsigned int)freeBlocks.size());
+
+		if (allocator[0] != reference->GetCursor() || allocator[1] != freeBlocks.size()) allocatorMismatches++;
+		else if (!std::equal(freeBlocks.begin(), freeBlocks.end(), allocator.begin() + 2)) allocatorMismatches++;
+	}
+
+	delete editor;
+	delete reference;
+
+	unsigned int beamTotal = beam.beamSteps + beam.traceSteps;
+
+	json << "{\n";
+	json << "  \"config\": { \"size\": " << size << ", \"width\": " << VALIDATE_WIDTH << ", \"height\": " << VALIDATE_HEIGHT
+		 << ", \"points\": " << VALIDATE_POINTS << ", \"seed\": " << SEED << ", \"renderer\": \"" << glGetString(GL_RENDERER) << "\" },\n";
+	json << "  \"beam\": { \"mismatches\": " << beamMismatches << ", \"singleSteps\": " << single.traceSteps << ", \"singleRays\": " << single.traceRays
+		 << ", \"beamCoarseSteps\": " << beam.beamSteps << ", \"beamFineSteps\": " << beam.traceSteps
+		 << ", \"beamRays\": " << beam.beamRays << ", \"stepRatio\": " << (beamTotal ? (double)single.traceSteps / beamTotal : 0.0) << " },\n";
+	json << "  \"reprojection\": { \"pans\": " << pans << ", \"reprojected\": " << reprojected << ", \"mismatches\": " << reprojectionMismatches << " },\n";
+	json << "  \"edits\": { \"batches\": " << VALIDATE_BATCHES << ", \"edits\": " << edits << ", \"cursor\": " << allocator[0] << ", \"peakFree\": " << peakFree
+		 << ", \"voxelMismatches\": " << voxelMismatches << ", \"allocatorMismatches\": " << allocatorMismatches << " }";
+	json << "\n}\n";
+
+	return beamMismatches == 0 && reprojectionMismatches == 0 && voxelMismatches == 0 && allocatorMismatches == 0;
+}
+
+int main(int argc, char** argv)
+{
+	bool validate = (argc > 1 && strcmp(argv[1], "validate") == 0);
+	unsigned int frames = (!validate && argc > 1) ? atoi(argv[1]) : 300;
+	unsigned int size = (argc > 2) ? atoi(argv[2]) : 128;
+	const char* output = (argc > 3) ? argv[3] : nullptr;
+
+	/*
+		A hidden window gives us a context without putting
+		anything on screen.
+	*/
+	if (!glfwInit())
+	{
+		std::cout << "Failed to initialize GLFW." << std::endl;
+		return 1;
+	}
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Winedark Bench", NULL, NULL);
+	if (!window)
+	{
+		glfwTerminate();
+		std::cout << "Failed to create Opengl Window." << std::endl;
+		return 1;
+	}
+
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return 1;
+	}
+
+	/*
+		The world and the path are the same every run.
+	*/
+	unsigned int width = validate ? VALIDATE_WIDTH : WIDTH;
+	unsigned int height = validate ? VALIDATE_HEIGHT : HEIGHT;
+
+	Winedark::Camera* camera = new Winedark::Camera(1.0f, { size / 2.0f, size / 2.0f, -size - 100.0f }, { 1.0f, 0.0f, 0.0f, 0.0f }, width, height, 0.01f, 2000.0f);
+	Winedark::Octree* octree = new Winedark::Octree(size);
+	Winedark::GenerateSea(octree, SEED);
+	Winedark::OctreeBuffer* buffer = new Winedark::OctreeBuffer(octree);
+	Winedark::Renderer* renderer = new Winedark::Renderer(camera, buffer);
+
+	std::ostringstream json;
+	bool passed = true;
+
+	if (validate) passed = Validate(renderer, camera, buffer, octree, json);
+	else Benchmark(renderer, camera, buffer, octree, frames, json);
+
+	if (output != nullptr)
+	{
+		std::ofstream file(output, std::ios::trunc);
+		file << json.str();
+	}
+	std::cout << json.str();
+
+	delete renderer;
+	delete buffer;
+	delete octree;
+	delete camera;
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return passed ? 0 : 2;
+}
\ No newline at end of file
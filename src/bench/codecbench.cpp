@@ -0,0 +1,74 @@
+// codecbench.cpp
+//
+// Compares the world storage codecs on generated worlds: compression
+// ratio, encode speed and decode speed. Decoding goes straight into
+// the octree's voxel pool, just like loading a save does.
+//
+// Usage: winedark_codec_bench [size] [repeats]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+
+#include "../world/codec.h"
+#include "../world/octree.h"
+#include "../world/generator.h"
+
+using Clock = std::chrono::steady_clock;
+
+/*
+	Runs each codec over the given octree and prints one
+	row per codec.
+*/
+void BenchWorld(const char* name, Winedark::Octree* octree, int repeats)
+{
+	unsigned int n = octree->GetCursor();
+	double rawBytes = (double)n * sizeof(Winedark::Voxel);
+	std::vector<Winedark::Voxel> source(octree->GetVoxels(), octree->GetVoxels() + n);
+
+	for (uint32_t t = 0; t < Winedark::CODEC_COUNT; t++)
+	{
+		Winedark::Codec* codec = Winedark::GetCodec((Winedark::CodecType)t);
+		std::vector<uint8_t> encoded;
+
+		auto start = Clock::now();
+		for (int r = 0; r < repeats; r++) codec->Encode(source.data(), n, encoded);
+		double encodeTime = std::chrono::duration<double>(Clock::now() - start).count() / repeats;
+
+		bool ok = true;
+		start = Clock::now();
+		for (int r = 0; r < repeats; r++) ok &= codec->Decode(encoded.data(), encoded.size(), octree->GetVoxels(), n);
+		double decodeTime = std::chrono::duration<double>(Clock::now() - start).count() / repeats;
+
+		ok &= (memcmp(octree->GetVoxels(), source.data(), rawBytes) == 0);
+
+		printf("%-10s %-8s %12u %12zu %8.2fx %10.3f %10.3f %s\n",
+			name, codec->GetName(), n, encoded.size(), rawBytes / encoded.size(),
+			rawBytes / encodeTime / 1e9, rawBytes / decodeTime / 1e9, ok ? "" : "MISMATCH");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int size = (argc > 1) ? atoi(argv[1]) : 128;
+	int repeats = (argc > 2) ? atoi(argv[2]) : 5;
+
+	printf("%-10s %-8s %12s %12s %9s %10s %10s\n", "world", "codec", "voxels", "bytes", "ratio", "enc GB/s", "dec GB/s");
+
+	{
+		Winedark::Octree octree(size);
+		Winedark::GenerateSea(&octree, 1);
+		BenchWorld("sea", &octree, repeats);
+	}
+
+	{
+		Winedark::Octree octree(size);
+		Winedark::GenerateNoise(&octree, 1, 0.5f);
+		BenchWorld("noise", &octree, repeats);
+	}
+
+	return 0;
+}
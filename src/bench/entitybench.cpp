@@ -0,0 +1,408 @@
+// entitybench.cpp
+//
+// Puts the entity tree through what a busy sea would: tens of
+// thousands of boids and ships wandering about a 1024^3 world, ticked
+// at a fixed rate. Every tick each of them moves, a few are despawned
+// and others spawned, each looks around its neighbourhood (a batch
+// query), every overlapping pair is found and a few hundred rays are
+// cast. The tick is timed as a whole and in those parts.
+//
+// It's run twice from the same seed: once only refitting, so the tree
+// just gets worse as things move, and once with the background SAH
+// rebuilds. Every so often, each run's queries, pairs and rays are
+// checked against brute force over every entity.
+//
+// No GL, so it builds with winedark_core alone. Prints JSON, and exits
+// with 2 if any query disagreed with brute force.
+//
+// Usage: winedark_entity_bench [entities] [ticks] [ticks per second] [output.json]
+//        (0 ticks per second runs flat out)
+
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "../world/entitytree.h"
+#include "../util/framepacer.h"
+#include "../util/geometry.h"
+
+using Clock = std::chrono::steady_clock;
+
+const unsigned int SEED = 1;
+const float WORLD = 1024.0f;
+const float MIN_SPEED = 2.0f;
+const float MAX_SPEED = 12.0f;
+const float JITTER = 4.0f;
+const float NEIGHBOURHOOD = 4.0f;
+const unsigned int SHIP_EVERY = 100;
+const unsigned int CHURN = 50;
+const unsigned int RAYS = 256;
+const unsigned int VALIDATE_EVERY = 60;
+const unsigned int SAMPLES = 64;
+
+double Percentile(std::vector<double> values, double p)
+{
+	if (values.empty()) return 0.0;
+
+	std::sort(values.begin(), values.end());
+	return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+double Mean(const std::vector<double>& values)
+{
+	double total = 0.0;
+	for (double v : values) total += v;
+	return values.empty() ? 0.0 : total / values.size();
+}
+
+double Milliseconds(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool Overlap(const Winedark::Box& a, const Winedark::Box& b)
+{
+	return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::greaterThanEqual(a.max, b.min));
+}
+
+/*
+	A boid, or now and then a ship, which is the same but
+	bigger.
+*/
+struct Entity
+{
+	glm::vec3		position;
+	glm::vec3		velocity;
+	float			halfSize;
+	unsigned int	proxy;
+
+	Winedark::Box GetBox() { return { position - glm::vec3(halfSize), position + glm::vec3(halfSize) }; }
+};
+
+/*
+	What one run came to.
+*/
+struct Run
+{
+	const char*				name;
+	bool					rebuild;
+	std::vector<double>		tickTimes;
+	std::vector<double>		moveTimes;
+	std::vector<double>		updateTimes;
+	std::vector<double>		queryTimes;
+	std::vector<double>		pairTimes;
+	std::vector<double>		rayTimes;
+	double					seconds;
+	unsigned int			lateTicks;
+	unsigned long long		refits;
+	unsigned long long		neighbours;
+	unsigned long long		pairs;
+	unsigned long long		rayHits;
+	float					startCost;
+	unsigned int			mismatches;
+	Winedark::EntityTreeStats	stats;
+};
+
+void Spawn(Entity& e, std::mt19937& rng, unsigned int i)
+{
+	std::uniform_real_distribution<float> across(0.0f, WORLD);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> size(0.5f, 2.0f);
+
+	e.position = { across(rng), across(rng), across(rng) };
+	e.velocity = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.001f)) * MIN_SPEED;
+	e.halfSize = (i % SHIP_EVERY == 0) ? 8.0f : size(rng);
+}
+
+/*
+	Brute force, for checking: every entity, every time.
+*/
+unsigned int Validate(Winedark::EntityTree& tree, std::vector<Entity>& entities, std::vector<Winedark::Box>& neighbourhoods,
+					  std::vector<Winedark::EntityOverlap>& overlaps, std::vector<Winedark::EntityOverlap>& pairs, std::mt19937& rng)
+{
+	unsigned int mismatches = 0;
+	std::uniform_int_distribution<unsigned int> pick(0, (unsigned int)entities.size() - 1);
+	std::uniform_real_distribution<float> across(0.0f, WORLD);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	for (unsigned int s = 0; s < SAMPLES; s++)
+	{
+		/*
+			A neighbourhood query.
+		*/
+		glm::vec3 centre = { across(rng), across(rng), across(rng) };
+		Winedark::Box box = { centre - glm::vec3(4.0f * NEIGHBOURHOOD), centre + glm::vec3(4.0f * NEIGHBOURHOOD) };
+
+		std::vector<unsigned int> found, expected;
+		tree.Query(box, found);
+		for (unsigned int i = 0; i < entities.size(); i++)
+		{
+			if (Overlap(entities[i].GetBox(), box)) expected.push_back(i);
+		}
+
+		std::sort(found.begin(), found.end());
+		if (found != expected) mismatches++;
+
+		/*
+			One entity's pairs.
+		*/
+		unsigned int e = pick(rng);
+		std::vector<unsigned int> partners, expectedPartners;
+
+		for (Winedark::EntityOverlap& pair : pairs)
+		{
+			if (pair.a == e) partners.push_back(pair.b);
+			if (pair.b == e) partners.push_back(pair.a);
+		}
+		for (unsigned int i = 0; i < entities.size(); i++)
+		{
+			if (i != e && Overlap(entities[i].GetBox(), entities[e].GetBox())) expectedPartners.push_back(i);
+		}
+
+		std::sort(partners.begin(), partners.end());
+		if (partners != expectedPartners) mismatches++;
+
+		/*
+			And what it saw around it.
+		*/
+		std::vector<unsigned int> seen, expectedSeen;
+
+		for (Winedark::EntityOverlap& overlap : overlaps)
+		{
+			if (overlap.a == e) seen.push_back(overlap.b);
+		}
+		for (unsigned int i = 0; i < entities.size(); i++)
+		{
+			if (Overlap(entities[i].GetBox(), neighbourhoods[e])) expectedSeen.push_back(i);
+		}
+
+		std::sort(seen.begin(), seen.end());
+		if (seen != expectedSeen) mismatches++;
+
+		/*
+			A ray.
+		*/
+		glm::vec3 origin = { across(rng), across(rng), across(rng) };
+		glm::vec3 direction = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.001f));
+
+		unsigned int hit;
+		float t;
+		bool hitTree = tree.RayCast(origin, direction, WORLD, hit, t);
+
+		float bestT = WORLD;
+		bool hitBrute = false;
+		for (unsigned int i = 0; i < entities.size(); i++)
+		{
+			Winedark::Box b = entities[i].GetBox();
+			float tMin = 0.0f, tMax = bestT;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float t1 = (b.min[axis] - origin[axis]) / direction[axis];
+				float t2 = (b.max[axis] - origin[axis]) / direction[axis];
+				tMin = std::max(tMin, std::min(t1, t2));
+				tMax = std::min(tMax, std::max(t1, t2));
+			}
+			if (tMin <= tMax)
+			{
+				bestT = tMin;
+				hitBrute = true;
+			}
+		}
+
+		if (hitTree != hitBrute || (hitTree && std::abs(t - bestT) > 1e-3f)) mismatches++;
+	}
+
+	return mismatches;
+}
+
+void RunTicks(Run& run, unsigned int count, unsigned int ticks, double rate)
+{
+	std::mt19937 rng(SEED);
+	std::mt19937 validation(SEED + 1);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> across(0.0f, WORLD);
+	std::uniform_int_distribution<unsigned int> pick(0, count - 1);
+
+	/*
+		Everyone in at once, then one build, as on loading
+		a world.
+	*/
+	Winedark::EntityTree* tree = new Winedark::EntityTree();
+	if (!run.rebuild) tree->rebuildThreshold = 1e30f;
+
+	std::vector<Entity> entities(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		Spawn(entities[i], rng, i);
+		entities[i].proxy = tree->Insert(entities[i].GetBox(), i);
+	}
+	tree->Rebuild();
+	tree->Wait();
+	run.startCost = tree->GetCost();
+
+	std::vector<Winedark::Box> neighbourhoods(count);
+	std::vector<Winedark::EntityOverlap> overlaps;
+	std::vector<Winedark::EntityOverlap> pairs;
+
+	Winedark::FramePacer pacer(rate);
+	float dt = 1.0f / 60.0f;
+	double budget = (rate > 0.0) ? 1000.0 / rate : 0.0;
+	auto runStart = Clock::now();
+
+	for (unsigned int tick = 0; tick < ticks; tick++)
+	{
+		auto tickStart = Clock::now();
+
+		/*
+			Everyone moves: a random nudge, kept between the
+			speed limits, bouncing off the edges of the world.
+			Then a few leave and as many arrive.
+		*/
+		auto start = Clock::now();
+		for (Entity& e : entities)
+		{
+			e.velocity += glm::vec3(unit(rng), unit(rng), unit(rng)) * JITTER * dt;
+
+			float speed = glm::length(e.velocity);
+			e.velocity *= std::min(std::max(speed, MIN_SPEED), MAX_SPEED) / speed;
+
+			glm::vec3 step = e.velocity * dt;
+			e.position += step;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				if (e.position[axis] < 0.0f) e.velocity[axis] = std::abs(e.velocity[axis]);
+				if (e.position[axis] > WORLD) e.velocity[axis] = -std::abs(e.velocity[axis]);
+			}
+
+			if (tree->Move(e.proxy, e.GetBox(), step)) run.refits++;
+		}
+
+		for (unsigned int c = 0; c < CHURN; c++)
+		{
+			unsigned int i = pick(rng);
+			tree->Remove(entities[i].proxy);
+			Spawn(entities[i], rng, i);
+			entities[i].proxy = tree->Insert(entities[i].GetBox(), i);
+		}
+		run.moveTimes.push_back(Milliseconds(start));
+
+		start = Clock::now();
+		tree->Update();
+		run.updateTimes.push_back(Milliseconds(start));
+
+		/*
+			Everyone looks around them.
+		*/
+		start = Clock::now();
+		for (unsigned int i = 0; i < count; i++)
+		{
+			neighbourhoods[i] = { entities[i].position - glm::vec3(NEIGHBOURHOOD), entities[i].position + glm::vec3(NEIGHBOURHOOD) };
+		}
+		overlaps.clear();
+		tree->QueryBoxes(neighbourhoods, overlaps);
+		run.neighbours += overlaps.size();
+		run.queryTimes.push_back(Milliseconds(start));
+
+		/*
+			Who's bumped into whom.
+		*/
+		start = Clock::now();
+		pairs.clear();
+		tree->FindPairs(pairs);
+		run.pairs += pairs.size();
+		run.pairTimes.push_back(Milliseconds(start));
+
+		/*
+			And some cannon fire.
+		*/
+		start = Clock::now();
+		for (unsigned int r = 0; r < RAYS; r++)
+		{
+			glm::vec3 origin = { across(rng), across(rng), across(rng) };
+			glm::vec3 direction = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.001f));
+
+			unsigned int hit;
+			float t;
+			if (tree->RayCast(origin, direction, 256.0f, hit, t)) run.rayHits++;
+		}
+		run.rayTimes.push_back(Milliseconds(start));
+
+		double ms = Milliseconds(tickStart);
+		run.tickTimes.push_back(ms);
+		if (budget > 0.0 && ms > budget) run.lateTicks++;
+
+		if ((tick + 1) % VALIDATE_EVERY == 0) run.mismatches += Validate(*tree, entities, neighbourhoods, overlaps, pairs, validation);
+		if (rate > 0.0) pacer.Wait();
+	}
+
+	run.seconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+	run.stats = tree->GetStats();
+
+	delete tree;
+}
+
+void WriteTimes(std::ostringstream& json, const char* name, const std::vector<double>& times)
+{
+	json << "\"" << name << "\": { \"mean\": " << Mean(times) << ", \"p50\": " << Percentile(times, 0.5) << ", \"p95\": " << Percentile(times, 0.95)
+		 << ", \"p99\": " << Percentile(times, 0.99) << ", \"max\": " << Percentile(times, 1.0) << " }";
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int count = (argc > 1) ? atoi(argv[1]) : 50000;
+	unsigned int ticks = (argc > 2) ? atoi(argv[2]) : 600;
+	double rate = (argc > 3) ? atof(argv[3]) : 60.0;
+	const char* output = (argc > 4) ? argv[4] : nullptr;
+
+	Run runs[] = { { "refit", false }, { "rebuild", true } };
+	unsigned int mismatches = 0;
+
+	for (Run& run : runs)
+	{
+		RunTicks(run, count, ticks, rate);
+		mismatches += run.mismatches;
+	}
+
+	std::ostringstream json;
+	json << "{\n";
+	json << "  \"config\": { \"entities\": " << count << ", \"ticks\": " << ticks << ", \"rate\": " << rate << ", \"world\": " << WORLD
+		 << ", \"neighbourhood\": " << NEIGHBOURHOOD << ", \"churn\": " << CHURN << ", \"rays\": " << RAYS << ", \"seed\": " << SEED << " },\n";
+	json << "  \"runs\": {";
+
+	const char* separator = "\n";
+	for (Run& run : runs)
+	{
+		json << separator << "    \"" << run.name << "\": {\n      ";
+		WriteTimes(json, "tickMs", run.tickTimes);
+		json << ",\n      \"phasesMs\": { \"move\": " << Mean(run.moveTimes) << ", \"update\": " << Mean(run.updateTimes) << ", \"query\": " << Mean(run.queryTimes)
+			 << ", \"pairs\": " << Mean(run.pairTimes) << ", \"rays\": " << Mean(run.rayTimes) << " },\n";
+		json << "      \"ticksPerSecond\": " << ticks / run.seconds << ", \"lateTicks\": " << run.lateTicks
+			 << ", \"refitsPerTick\": " << (double)run.refits / ticks << ", \"neighboursPerTick\": " << (double)run.neighbours / ticks
+			 << ", \"pairsPerTick\": " << (double)run.pairs / ticks << ", \"rayHitsPerTick\": " << (double)run.rayHits / ticks << ",\n";
+		json << "      \"tree\": { \"startCost\": " << run.startCost << ", \"endCost\": " << run.stats.cost << ", \"height\": " << run.stats.height
+			 << ", \"nodes\": " << run.stats.nodes << ", \"rebuilds\": " << run.stats.rebuilds << ", \"lastRebuildMs\": " << run.stats.rebuildMs << " },\n";
+		json << "      \"mismatches\": " << run.mismatches << "\n    }";
+		separator = ",\n";
+	}
+	json << "\n  }\n}\n";
+
+	if (output != nullptr)
+	{
+		std::ofstream file(output, std::ios::trunc);
+		file << json.str();
+	}
+	std::cout << json.str();
+
+	return (mismatches > 0) ? 2 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,276 @@
+// meshbench.cpp
+//
+// Puts the mesh backend up against the tracer, on a world generated
+// from a fixed seed.
+//
+// First on the CPU alone, with no GL context, the checks in
+// meshcheck.h (which winedark_mesh_check runs on its own, without GL).
+//
+// Then, if there are frames to draw, the same flythrough as
+// winedark_bench is drawn with each backend (over the cratered world),
+// timing every frame, and a few frames of each are read back and
+// compared pixel by pixel. The comparison turns reprojection off, so
+// the tracer's pixels are where the rasterizer's are.
+//
+// Prints JSON, and exits with 2 if any mesh failed validation, so
+// `winedark_mesh_bench 0` is a test of the mesher.
+//
+// Usage: winedark_mesh_bench [frames] [size] [output.json]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "../rendering/renderer.h"
+#include "../world/generator.h"
+#include "../world/mesher.h"
+#include "../util/geometry.h"
+#include "meshcheck.h"
+
+const unsigned int WIDTH = 1600;
+const unsigned int HEIGHT = 600;
+const unsigned int WARMUP = 5;
+const unsigned int COMPARISONS = 4;
+
+/*
+	The camera's path, as in bench.cpp.
+*/
+struct Flythrough
+{
+	Winedark::BezierCurve			path;
+	Winedark::BezierQuaternion		rotation;
+
+	void Place(Winedark::Camera* camera, unsigned int frame, unsigned int frames)
+	{
+		float t = (frames > 1) ? (float)frame / (frames - 1) : 0.0f;
+		camera->SetPosition(path.GetPoint(t));
+		camera->SetRotation(rotation.GetQuaternion(t));
+	}
+};
+
+Flythrough MakeFlythrough(unsigned int size)
+{
+	float s = (float)size;
+	float z = -s - 100.0f;
+
+	Flythrough f;
+	f.path.points = { { 0.2f * s, 0.2f * s, z }, { 0.9f * s, 0.1f * s, z }, { 0.1f * s, 0.9f * s, z }, { 0.8f * s, 0.8f * s, z } };
+	f.rotation.rotations = { Winedark::Quaternion(), Winedark::Quaternion({ 1.0f, 0.0f, 0.0f }, 0.5f), Winedark::Quaternion({ 0.0f, 1.0f, 0.0f }, 0.4f), Winedark::Quaternion() };
+	return f;
+}
+
+/*
+	One backend's run along the flythrough.
+*/
+struct BackendRun
+{
+	const char*					name;
+	Winedark::Backend			backend;
+	std::vector<double>			frameTimes;
+	double						switchMs;
+	Winedark::MeshStats			stats;
+};
+
+int main(int argc, char** argv)
+{
+	unsigned int frames = (argc > 1) ? atoi(argv[1]) : 300;
+	unsigned int size = (argc > 2) ? atoi(argv[2]) : 128;
+	const char* output = (argc > 3) ? argv[3] : nullptr;
+
+	Winedark::Octree* octree = new Winedark::Octree(size);
+	Winedark::GenerateSea(octree, SEED);
+
+	MeshCheck check;
+	check.Run(octree);
+
+	unsigned int mismatches = check.Mismatches();
+
+	/*
+		Now the backends, if we've been asked to draw
+		anything.
+	*/
+	BackendRun runs[] = { { "trace", Winedark::Backend::Trace }, { "mesh", Winedark::Backend::Mesh } };
+	unsigned long long comparedPixels = 0;
+	unsigned long long differingPixels = 0;
+	std::string rendererName;
+
+	if (frames > 0)
+	{
+		/*
+			A hidden window gives us a context without
+			putting anything on screen.
+		*/
+		if (!glfwInit())
+		{
+			std::cout << "Failed to initialize GLFW." << std::endl;
+			return 1;
+		}
+
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+		GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Winedark Mesh Bench", NULL, NULL);
+		if (!window)
+		{
+			glfwTerminate();
+			std::cout << "Failed to create Opengl Window." << std::endl;
+			return 1;
+		}
+
+		glfwMakeContextCurrent(window);
+
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			return 1;
+		}
+
+		rendererName = (const char*)glGetString(GL_RENDERER);
+
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glViewport(0, 0, WIDTH, HEIGHT);
+
+		Winedark::Camera* camera = new Winedark::Camera(1.0f, { size / 2.0f, size / 2.0f, -size - 100.0f }, { 1.0f, 0.0f, 0.0f, 0.0f }, WIDTH, HEIGHT, 0.01f, 2000.0f);
+		Winedark::OctreeBuffer* buffer = new Winedark::OctreeBuffer(octree);
+		Winedark::Renderer* renderer = new Winedark::Renderer(camera, buffer);
+		Flythrough flythrough = MakeFlythrough(size);
+
+		auto frame = [&]()
+		{
+			camera->UpdateView();
+			camera->UpdateProjection();
+			buffer->Update();
+
+			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+			renderer->Render();
+			glFinish();
+		};
+
+		/*
+			The timed runs. Switching to the mesh backend
+			meshes the whole world on the workers, which we
+			wait for and time on its own.
+		*/
+		for (BackendRun& run : runs)
+		{
+			flythrough.Place(camera, 0, frames);
+
+			auto start = Clock::now();
+			renderer->SetBackend(run.backend);
+			if (run.backend == Winedark::Backend::Mesh) renderer->GetMeshRenderer()->Finish();
+			frame();
+			run.switchMs = Milliseconds(start);
+
+			for (unsigned int i = 0; i < WARMUP + frames; i++)
+			{
+				start = Clock::now();
+				flythrough.Place(camera, (i < WARMUP) ? 0 : i - WARMUP, frames);
+				frame();
+
+				if (i >= WARMUP) run.frameTimes.push_back(Milliseconds(start));
+			}
+
+			run.stats = (renderer->GetMeshRenderer() != nullptr) ? renderer->GetMeshRenderer()->GetStats() : Winedark::MeshStats{ 0, 0, 0, 0, 0, 0 };
+		}
+
+		/*
+			Then the comparison: a few points along the path,
+			drawn both ways and read back. A channel can be a
+			step apart from rounding and still count as the
+			same.
+		*/
+		renderer->SetReprojection(false);
+		std::vector<unsigned char> pixels[2];
+
+		for (unsigned int k = 0; k < COMPARISONS; k++)
+		{
+			for (unsigned int b = 0; b < 2; b++)
+			{
+				renderer->SetBackend(runs[b].backend);
+				flythrough.Place(camera, k * (frames - 1) / std::max(1u, COMPARISONS - 1), frames);
+				frame();
+
+				pixels[b].resize((size_t)WIDTH * HEIGHT * 4);
+				glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels[b].data());
+			}
+
+			for (size_t p = 0; p < (size_t)WIDTH * HEIGHT; p++)
+			{
+				bool same = true;
+				for (int c = 0; c < 3; c++) same = same && std::abs(pixels[0][4 * p + c] - pixels[1][4 * p + c]) <= 1;
+
+				comparedPixels++;
+				if (!same) differingPixels++;
+			}
+		}
+
+		delete renderer;
+		delete buffer;
+		delete camera;
+
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
+
+	/*
+		And out it all goes.
+	*/
+	std::ostringstream json;
+	json << "{\n";
+	json << "  \"config\": { \"frames\": " << frames << ", \"size\": " << size << ", \"width\": " << WIDTH << ", \"height\": " << HEIGHT
+		 << ", \"seed\": " << SEED << ", \"chunkSize\": " << Winedark::CHUNK_SIZE << ", \"threads\": " << check.threads
+		 << ", \"renderer\": \"" << rendererName << "\" },\n";
+
+	check.Write(json);
+
+	if (frames > 0)
+	{
+		json << ",\n  \"backends\": {";
+
+		const char* separator = "\n";
+		for (BackendRun& run : runs)
+		{
+			json << separator << "    \"" << run.name << "\": { \"switchMs\": " << run.switchMs
+				 << ", \"frameMs\": { \"mean\": " << Mean(run.frameTimes) << ", \"p50\": " << Percentile(run.frameTimes, 0.5)
+				 << ", \"p95\": " << Percentile(run.frameTimes, 0.95) << ", \"max\": " << Percentile(run.frameTimes, 1.0) << " }";
+
+			if (run.backend == Winedark::Backend::Mesh)
+			{
+				json << ", \"drawnChunks\": " << run.stats.drawnChunks << ", \"drawnFaces\": " << run.stats.drawnFaces
+					 << ", \"vertexBytes\": " << run.stats.vertexBytes << ", \"builds\": " << run.stats.builds;
+			}
+			json << " }";
+			separator = ",\n";
+		}
+		json << "\n  },\n";
+
+		json << "  \"comparison\": { \"frames\": " << COMPARISONS << ", \"pixels\": " << comparedPixels << ", \"differing\": " << differingPixels
+			 << ", \"fraction\": " << (comparedPixels ? (double)differingPixels / comparedPixels : 0.0) << " }";
+	}
+	json << "\n}\n";
+
+	if (output != nullptr)
+	{
+		std::ofstream file(output, std::ios::trunc);
+		file << json.str();
+	}
+	std::cout << json.str();
+
+	delete octree;
+	return (mismatches > 0) ? 2 : 0;
+}
\ No newline at end of file
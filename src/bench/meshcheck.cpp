@@ -0,0 +1,49 @@
+// meshcheck.cpp
+//
+// Runs the mesher's CPU checks (see meshcheck.h) on a world generated
+// from a fixed seed, with no GL at all, so it builds and runs wherever
+// winedark_core does, the server configuration included.
+//
+// Prints JSON, and exits with 2 if any mesh failed validation, so it
+// is a test of the mesher.
+//
+// Usage: winedark_mesh_check [size] [output.json]
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include "../world/octree.h"
+#include "../world/generator.h"
+#include "../world/mesher.h"
+#include "meshcheck.h"
+
+int main(int argc, char** argv)
+{
+	unsigned int size = (argc > 1) ? atoi(argv[1]) : 128;
+	const char* output = (argc > 2) ? argv[2] : nullptr;
+
+	Winedark::Octree* octree = new Winedark::Octree(size);
+	Winedark::GenerateSea(octree, SEED);
+
+	MeshCheck check;
+	check.Run(octree);
+
+	std::ostringstream json;
+	json << "{\n";
+	json << "  \"config\": { \"size\": " << size << ", \"seed\": " << SEED << ", \"chunkSize\": " << Winedark::CHUNK_SIZE
+		 << ", \"threads\": " << check.threads << " },\n";
+	check.Write(json);
+	json << "\n}\n";
+
+	if (output != nullptr)
+	{
+		std::ofstream file(output, std::ios::trunc);
+		file << json.str();
+	}
+	std::cout << json.str();
+
+	delete octree;
+	return (check.Mismatches() > 0) ? 2 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,208 @@
+// meshcheck.h
+//
+// The mesher's CPU checks, shared by winedark_mesh_check (which runs
+// only these, and needs nothing but winedark_core) and
+// winedark_mesh_bench (which runs these, then draws).
+//
+// Every chunk is read out of the octree, greedily meshed and checked
+// against ValidateMesh, one at a time and then on the ChunkMesher's
+// workers. Then craters are blown in the world one after another, and
+// after each we mesh again only the chunks it touched, and check
+// those too.
+
+#ifndef MESHCHECK_H
+#define MESHCHECK_H
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <ostream>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "../world/octree.h"
+#include "../world/mesher.h"
+#include "../util/geometry.h"
+
+using Clock = std::chrono::steady_clock;
+
+const unsigned int SEED = 1;
+const unsigned int CRATERS = 64;
+const int CRATER_RADIUS = 4;
+
+inline double Percentile(std::vector<double> values, double p)
+{
+	if (values.empty()) return 0.0;
+
+	std::sort(values.begin(), values.end());
+	return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+inline double Mean(const std::vector<double>& values)
+{
+	double total = 0.0;
+	for (double v : values) total += v;
+	return values.empty() ? 0.0 : total / values.size();
+}
+
+inline double Milliseconds(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+inline glm::ivec3 ChunkOrigin(unsigned int chunk, unsigned int chunksPerSide)
+{
+	return glm::ivec3(chunk % chunksPerSide, (chunk / chunksPerSide) % chunksPerSide, chunk / (chunksPerSide * chunksPerSide)) * (int)Winedark::CHUNK_SIZE;
+}
+
+/*
+	What meshing a set of chunks one at a time came to.
+*/
+struct MeshTotals
+{
+	unsigned int	chunks = 0;
+	unsigned int	solidChunks = 0;
+	unsigned long long	exposedFaces = 0;
+	unsigned long long	quads = 0;
+	unsigned int	mismatches = 0;
+	double			readMs = 0.0;
+	double			meshMs = 0.0;
+
+	void Add(Winedark::Octree* octree, glm::ivec3 origin)
+	{
+		std::vector<unsigned int> types;
+		std::vector<Winedark::Vertex> vertices;
+
+		auto start = Clock::now();
+		bool solid = Winedark::ReadChunk(octree->GetVoxels(), octree->GetSize(), origin, types);
+		readMs += Milliseconds(start);
+		chunks++;
+
+		start = Clock::now();
+		if (solid) Winedark::MeshChunk(types, origin, vertices);
+		meshMs += Milliseconds(start);
+
+		unsigned int exposed = 0;
+		mismatches += Winedark::ValidateMesh(types, origin, vertices, exposed);
+
+		if (solid) solidChunks++;
+		exposedFaces += exposed;
+		quads += vertices.size() / 4;
+	}
+};
+
+/*
+	Everything the checks came to.
+*/
+struct MeshCheck
+{
+	MeshTotals				full;
+	MeshTotals				edits;
+	double					parallelMs = 0.0;
+	unsigned int			threads = 0;
+	std::vector<double>		editTimes;
+
+	unsigned int Mismatches() { return full.mismatches + edits.mismatches; }
+
+	/*
+		Runs the checks over the octree, leaving the craters
+		in it.
+	*/
+	void Run(Winedark::Octree* octree)
+	{
+		unsigned int size = octree->GetSize();
+		unsigned int chunksPerSide = std::max(1u, (size + Winedark::CHUNK_SIZE - 1) / Winedark::CHUNK_SIZE);
+		unsigned int nChunks = chunksPerSide * chunksPerSide * chunksPerSide;
+
+		/*
+			The whole world, a chunk at a time, checking every
+			mesh as we go.
+		*/
+		for (unsigned int c = 0; c < nChunks; c++) full.Add(octree, ChunkOrigin(c, chunksPerSide));
+
+		/*
+			Then on the workers. Reading stays on this thread,
+			as it does in the renderer.
+		*/
+		Winedark::ChunkMesher* mesher = new Winedark::ChunkMesher();
+		std::vector<Winedark::ChunkMesh> meshes;
+
+		auto parallelStart = Clock::now();
+		for (unsigned int c = 0; c < nChunks; c++)
+		{
+			std::vector<unsigned int> types;
+			glm::ivec3 origin = ChunkOrigin(c, chunksPerSide);
+			if (Winedark::ReadChunk(octree->GetVoxels(), size, origin, types)) mesher->Submit(c, 0, origin, std::move(types));
+		}
+		mesher->Wait();
+		mesher->TakeMeshes(meshes);
+		parallelMs = Milliseconds(parallelStart);
+		threads = mesher->GetThreadCount();
+		delete mesher;
+
+		/*
+			Craters, each a ball of air somewhere near the sea
+			floor. After each we mesh again just what it
+			touched.
+		*/
+		std::mt19937 rng(SEED);
+		std::uniform_int_distribution<int> across(0, (int)size - 1);
+		std::uniform_int_distribution<int> deep((int)size / 2, (int)size - 1);
+
+		for (unsigned int i = 0; i < CRATERS; i++)
+		{
+			int cx = across(rng), cy = across(rng), cz = deep(rng);
+
+			for (int z = cz - CRATER_RADIUS; z <= cz + CRATER_RADIUS; z++)
+			{
+				for (int y = cy - CRATER_RADIUS; y <= cy + CRATER_RADIUS; y++)
+				{
+					for (int x = cx - CRATER_RADIUS; x <= cx + CRATER_RADIUS; x++)
+					{
+						int r = (x - cx) * (x - cx) + (y - cy) * (y - cy) + (z - cz) * (z - cz);
+						if (r > CRATER_RADIUS * CRATER_RADIUS || x < 0 || y < 0 || z < 0 || x >= (int)size || y >= (int)size || z >= (int)size) continue;
+						octree->RemoveVoxel(x, y, z);
+					}
+				}
+			}
+
+			std::vector<Winedark::Box> boxes;
+			std::vector<unsigned int> touched;
+			std::vector<bool> seen(nChunks, false);
+
+			auto start = Clock::now();
+			if (octree->TakeDirtyBoxes(boxes)) Winedark::FindChunks(boxes, chunksPerSide, touched);
+			else for (unsigned int c = 0; c < nChunks; c++) touched.push_back(c);
+
+			for (unsigned int c : touched)
+			{
+				if (seen[c]) continue;
+				seen[c] = true;
+				edits.Add(octree, ChunkOrigin(c, chunksPerSide));
+			}
+			editTimes.push_back(Milliseconds(start));
+		}
+		octree->CheckChanged();
+	}
+
+	/*
+		Writes the "mesh" and "edits" members of the JSON
+		output, with no trailing separator.
+	*/
+	void Write(std::ostream& json)
+	{
+		json << "  \"mesh\": { \"chunks\": " << full.chunks << ", \"solidChunks\": " << full.solidChunks << ", \"exposedFaces\": " << full.exposedFaces
+			 << ", \"quads\": " << full.quads << ", \"facesPerQuad\": " << (full.quads ? (double)full.exposedFaces / full.quads : 0.0)
+			 << ", \"vertexBytes\": " << full.quads * 4 * sizeof(Winedark::Vertex)
+			 << ", \"readMs\": " << full.readMs << ", \"meshMs\": " << full.meshMs << ", \"parallelMs\": " << parallelMs
+			 << ", \"mismatches\": " << full.mismatches << " },\n";
+
+		json << "  \"edits\": { \"craters\": " << CRATERS << ", \"radius\": " << CRATER_RADIUS
+			 << ", \"chunksPerCrater\": " << (double)edits.chunks / CRATERS
+			 << ", \"msPerCrater\": { \"mean\": " << Mean(editTimes) << ", \"p50\": " << Percentile(editTimes, 0.5) << ", \"p95\": " << Percentile(editTimes, 0.95) << " }"
+			 << ", \"mismatches\": " << edits.mismatches << " }";
+	}
+};
+
+#endif
\ No newline at end of file
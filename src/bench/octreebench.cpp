@@ -0,0 +1,291 @@
+// octreebench.cpp
+//
+// Microbenchmarks for the octree's core operations: construction,
+// AddVoxel/RemoveVoxel under a mix of edits, CountTypedVoxels and
+// (when we can get a GL context) the buffer upload. Every case is run
+// over a grid of world sizes, fill ratios, spatial coherence (how
+// often an edit lands right next to the last one) and edit mixes,
+// from fixed seeds.
+//
+// Prints one JSON object per line per case, with ns/op, calls to
+// operator new per op (newsPerOp) and an estimate of the octree bytes
+// each op touches: the voxel at every level on the way down, plus any
+// blocks of children handed out, for edits; the whole pool for
+// counting and uploads.
+//
+// Usage: winedark_octree_bench [ops] [max size]
+
+#include <new>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "../rendering/octreebuffer.h"
+#include "../world/octree.h"
+#include "../world/generator.h"
+
+using Clock = std::chrono::steady_clock;
+
+const unsigned int SEED = 1;
+
+/*
+	Every call to operator new goes through here, so we can
+	count them. Anything that goes to malloc or realloc
+	directly isn't counted.
+*/
+static unsigned long long allocations = 0;
+
+void* operator new(size_t n)
+{
+	allocations++;
+	void* p = malloc(n ? n : 1);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+/*
+	A stream of edit positions. With probability coherence the
+	next edit is a step away from the last one, otherwise it's
+	anywhere in the world.
+*/
+struct EditStream
+{
+	std::mt19937	rng;
+	unsigned int	size;
+	float			coherence;
+	unsigned int	x, y, z;
+
+	EditStream(unsigned int size, float coherence, unsigned int seed) : rng(seed)
+	{
+		this->size = size;
+		this->coherence = coherence;
+		x = y = z = size / 2;
+	}
+
+	void Next()
+	{
+		std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+
+		if (chance(rng) < coherence)
+		{
+			std::uniform_int_distribution<int> step(-1, 1);
+			x = (x + size + step(rng)) % size;
+			y = (y + size + step(rng)) % size;
+			z = (z + size + step(rng)) % size;
+		}
+		else
+		{
+			std::uniform_int_distribution<unsigned int> anywhere(0, size - 1);
+			x = anywhere(rng);
+			y = anywhere(rng);
+			z = anywhere(rng);
+		}
+	}
+};
+
+struct Result
+{
+	double		ns;
+	double		allocs;
+	double		bytes;
+};
+
+void Print(const char* op, unsigned int size, float fill, float coherence, float removes, unsigned int ops, Result r)
+{
+	printf("{\"op\":\"%s\",\"size\":%u,\"fill\":%.2f,\"coherence\":%.2f,\"removeFraction\":%.2f,\"ops\":%u,\"nsPerOp\":%.2f,\"newsPerOp\":%.3f,\"bytesPerOp\":%.1f}\n",
+		op, size, fill, coherence, removes, ops, r.ns, r.allocs, r.bytes);
+}
+
+unsigned int Levels(unsigned int size)
+{
+	unsigned int levels = 0;
+	for (unsigned int s = size; s > 1; s /= 2) levels++;
+	return levels;
+}
+
+/*
+	Construction: allocating and clearing the voxel pool.
+*/
+Result BenchConstruct(unsigned int size, unsigned int repeats)
+{
+	unsigned long long a = allocations;
+	size_t bytes = 0;
+
+	auto start = Clock::now();
+	for (unsigned int i = 0; i < repeats; i++)
+	{
+		Winedark::Octree octree(size);
+		bytes += (size_t)octree.GetCapacity() * sizeof(Winedark::Voxel);
+	}
+	double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+	return { ns / repeats, (double)(allocations - a) / repeats, (double)bytes / repeats };
+}
+
+/*
+	A run of edits, removes making up the given fraction of them
+	and adds the rest.
+*/
+Result BenchEdits(Winedark::Octree* octree, float coherence, float removes, unsigned int ops)
+{
+	EditStream stream(octree->GetSize(), coherence, SEED);
+	std::mt19937 rng(SEED + 1);
+	std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+
+	/*
+		We work out the stream up front so generating it
+		isn't part of the time.
+	*/
+	struct Edit { unsigned int x, y, z; uint16_t type; };
+	std::vector<Edit> edits(ops);
+	for (Edit& e : edits)
+	{
+		stream.Next();
+		e = { stream.x, stream.y, stream.z, (uint16_t)((chance(rng) < removes) ? 0 : 1 + rng() % 3) };
+	}
+
+	unsigned int cursor = octree->GetCursor();
+	unsigned long long a = allocations;
+
+	auto start = Clock::now();
+	for (const Edit& e : edits)
+	{
+		if (e.type == 0) octree->RemoveVoxel(e.x, e.y, e.z);
+		else octree->AddVoxel(e.x, e.y, e.z, e.type);
+	}
+	double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+	double grown = (double)(octree->GetCursor() - cursor) * sizeof(Winedark::Voxel);
+	double bytes = (double)ops * Levels(octree->GetSize()) * sizeof(Winedark::Voxel) + grown;
+
+	return { ns / ops, (double)(allocations - a) / ops, bytes / ops };
+}
+
+/*
+	Counting every typed voxel.
+*/
+Result BenchCount(Winedark::Octree* octree, unsigned int repeats)
+{
+	volatile unsigned int sink = 0;
+	unsigned long long a = allocations;
+
+	auto start = Clock::now();
+	for (unsigned int i = 0; i < repeats; i++) sink += octree->CountTypedVoxels();
+	double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+	return { ns / repeats, (double)(allocations - a) / repeats, (double)octree->GetCapacity() * sizeof(Winedark::Voxel) };
+}
+
+/*
+	Uploading the octree to its buffer, waiting for the GPU so
+	we time the whole copy. Every upload is preceded by an edit,
+	since Update only writes the buffer when something changed.
+*/
+Result BenchUpload(Winedark::Octree* octree, unsigned int repeats)
+{
+	Winedark::OctreeBuffer buffer(octree);
+
+	octree->AddVoxel(0, 0, 0, 1);
+	buffer.Update();
+	glFinish();
+
+	unsigned long long a = allocations;
+
+	auto start = Clock::now();
+	for (unsigned int i = 0; i < repeats; i++)
+	{
+		octree->AddVoxel(0, 0, 0, 1);
+		buffer.Update();
+		glFinish();
+	}
+	double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+	return { ns / repeats, (double)(allocations - a) / repeats, (double)octree->GetCapacity() * sizeof(Winedark::Voxel) };
+}
+
+/*
+	The upload benchmark needs a GL context. If we can't make
+	one (no display, say), we just skip it.
+*/
+GLFWwindow* CreateHiddenWindow()
+{
+	if (!glfwInit()) return nullptr;
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	GLFWwindow* window = glfwCreateWindow(64, 64, "Winedark Octree Bench", NULL, NULL);
+	if (window == nullptr) return nullptr;
+
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) return nullptr;
+
+	return window;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int ops = (argc > 1) ? atoi(argv[1]) : 200000;
+	unsigned int maxSize = (argc > 2) ? atoi(argv[2]) : 256;
+
+	const float fills[] = { 0.05f, 0.5f };
+	const float coherences[] = { 0.0f, 0.95f };
+	const float removeFractions[] = { 0.0f, 0.5f, 1.0f };
+
+	GLFWwindow* window = CreateHiddenWindow();
+
+	for (unsigned int size = 64; size <= maxSize; size *= 2)
+	{
+		Print("construct", size, 0.0f, 0.0f, 0.0f, 10, BenchConstruct(size, 10));
+
+		for (float fill : fills)
+		{
+			/*
+				Generating a world takes a while, so we do it
+				once and put it back between cases the same
+				way loading a save does.
+			*/
+			Winedark::Octree octree(size);
+			Winedark::GenerateNoise(&octree, SEED, fill);
+
+			unsigned int n = octree.GetCursor();
+			std::vector<Winedark::Voxel> snapshot(octree.GetVoxels(), octree.GetVoxels() + n);
+
+			for (float coherence : coherences)
+			{
+				for (float removes : removeFractions)
+				{
+					memcpy(octree.GetVoxels(), snapshot.data(), n * sizeof(Winedark::Voxel));
+					octree.Rebuild(n);
+
+					Print("edit", size, fill, coherence, removes, ops, BenchEdits(&octree, coherence, removes, ops));
+				}
+			}
+
+			memcpy(octree.GetVoxels(), snapshot.data(), n * sizeof(Winedark::Voxel));
+			octree.Rebuild(n);
+
+			Print("count", size, fill, 0.0f, 0.0f, 10, BenchCount(&octree, 10));
+			if (window != nullptr) Print("upload", size, fill, 0.0f, 0.0f, 10, BenchUpload(&octree, 10));
+		}
+	}
+
+	if (window != nullptr)
+	{
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,333 @@
+// spritebench.cpp
+//
+// Draws a frame of 100k sprites (by default) over and over through the
+// sprite batch and times it: the CPU side (adding the sprites, then
+// sorting and writing them out in End) and the whole frame with the
+// GPU finished. The sprites are spread over a handful of layers and two
+// atlases, from a fixed seed. We run it with the sprites added in layer
+// order and then shuffled, so the sort's cost shows up, and then in
+// order again with the rasterizer off, so what's left is our side of
+// it and the vertex work (on a software rasterizer the fill can swamp
+// everything else).
+//
+// Prints JSON: per-case timings, draw calls per frame and bytes per
+// sprite, against the nine-float Vertex the rest of the renderer uses.
+//
+// Then it draws a log window through the TextRenderer: thousands of
+// lines, most of them scrolled off screen, in the font under
+// assets/fonts. After the first frame every line has been shaped and
+// every glyph rasterized, so from then on nothing more should be, and
+// the lot should go out in one draw. If any of that isn't so, it exits
+// with 2.
+//
+// Usage: winedark_sprite_bench [frames] [sprites] [output.json]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "../rendering/spritebatch.h"
+#include "../rendering/textrenderer.h"
+#include "../rendering/texture.h"
+#include "../rendering/textureatlas.h"
+#include "../util/polygons.h"
+
+using Clock = std::chrono::steady_clock;
+
+const unsigned int SEED = 1;
+const unsigned int WIDTH = 1600;
+const unsigned int HEIGHT = 600;
+const unsigned int WARMUP = 5;
+const unsigned int LAYERS = 8;
+const unsigned int TEXTURES = 16;
+const unsigned int TEXTURE_SIZE = 32;
+const char* FONT = "assets/fonts/DejaVuSansMono.ttf";
+const unsigned int LOG_LINES = 4000;
+const float LOG_TEXT_SIZE = 14.0f;
+
+double Percentile(std::vector<double> values, double p)
+{
+	if (values.empty()) return 0.0;
+
+	std::sort(values.begin(), values.end());
+	return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+double Mean(const std::vector<double>& values)
+{
+	double total = 0.0;
+	for (double v : values) total += v;
+	return values.empty() ? 0.0 : total / values.size();
+}
+
+/*
+	A checkerboard of the given color, so the sprites look like
+	something if anyone reads the frame back.
+*/
+std::vector<unsigned char> MakePixels(glm::vec4 color)
+{
+	std::vector<unsigned char> pixels(TEXTURE_SIZE * TEXTURE_SIZE * 4);
+
+	for (unsigned int y = 0; y < TEXTURE_SIZE; y++)
+	{
+		for (unsigned int x = 0; x < TEXTURE_SIZE; x++)
+		{
+			float shade = (((x / 4) + (y / 4)) % 2 == 0) ? 1.0f : 0.5f;
+			unsigned char* p = &pixels[(y * TEXTURE_SIZE + x) * 4];
+
+			p[0] = (unsigned char)(color.x * shade * 255.0f);
+			p[1] = (unsigned char)(color.y * shade * 255.0f);
+			p[2] = (unsigned char)(color.z * shade * 255.0f);
+			p[3] = 255;
+		}
+	}
+
+	return pixels;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int frames = (argc > 1) ? atoi(argv[1]) : 200;
+	unsigned int count = (argc > 2) ? atoi(argv[2]) : 100000;
+	const char* output = (argc > 3) ? argv[3] : nullptr;
+
+	/*
+		A hidden window gives us a context without putting
+		anything on screen.
+	*/
+	if (!glfwInit())
+	{
+		std::cout << "Failed to initialize GLFW." << std::endl;
+		return 1;
+	}
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Winedark Sprite Bench", NULL, NULL);
+	if (!window)
+	{
+		glfwTerminate();
+		std::cout << "Failed to create Opengl Window." << std::endl;
+		return 1;
+	}
+
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return 1;
+	}
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glViewport(0, 0, WIDTH, HEIGHT);
+
+	/*
+		Two atlases of TEXTURES textures each.
+	*/
+	std::vector<std::vector<unsigned char>> pixels;
+	std::vector<Winedark::Texture*> textures[2];
+	Winedark::TextureAtlas* atlases[2] = { new Winedark::TextureAtlas(), new Winedark::TextureAtlas() };
+
+	for (unsigned int a = 0; a < 2; a++)
+	{
+		for (unsigned int i = 0; i < TEXTURES; i++)
+		{
+			float h = (float)(a * TEXTURES + i) / (2 * TEXTURES);
+			pixels.push_back(MakePixels({ h, 1.0f - h, 0.5f, 1.0f }));
+		}
+	}
+
+	for (unsigned int a = 0; a < 2; a++)
+	{
+		for (unsigned int i = 0; i < TEXTURES; i++) textures[a].push_back(new Winedark::Texture(TEXTURE_SIZE, TEXTURE_SIZE, pixels[a * TEXTURES + i].data()));
+		atlases[a]->Build(textures[a]);
+	}
+
+	/*
+		The sprites. Even layers use the first atlas and odd
+		ones the second, so the batch can't merge across
+		layers and it's one draw per layer.
+	*/
+	std::mt19937 rng(SEED);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Winedark::Sprite> ordered(count);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int layer = i * LAYERS / count;
+		unsigned int a = layer % 2;
+
+		Winedark::Sprite& sprite = ordered[i];
+		sprite.atlas = atlases[a];
+		sprite.region = atlases[a]->GetRegion(textures[a][rng() % TEXTURES]);
+		sprite.size = { 8.0f + 24.0f * unit(rng), 8.0f + 24.0f * unit(rng) };
+		sprite.position = { unit(rng) * (WIDTH - sprite.size.x), unit(rng) * (HEIGHT - sprite.size.y) };
+		sprite.color = Winedark::PackColor({ 1.0f, 1.0f, 1.0f, 0.5f + 0.5f * unit(rng) });
+		sprite.layer = (int)layer;
+	}
+
+	std::vector<Winedark::Sprite> shuffled = ordered;
+	std::shuffle(shuffled.begin(), shuffled.end(), rng);
+
+	/*
+		Then the runs. The segments hold a whole frame, so
+		every frame is one End.
+	*/
+	Winedark::SpriteBatch* batch = new Winedark::SpriteBatch(count);
+
+	struct Case
+	{
+		const char*							name;
+		std::vector<Winedark::Sprite>*		sprites;
+		bool								discard;
+		std::vector<double>					submitTimes;
+		std::vector<double>					frameTimes;
+		unsigned int						drawCalls;
+	};
+	Case cases[] = { { "ordered", &ordered, false }, { "shuffled", &shuffled, false }, { "orderedNoRaster", &ordered, true } };
+
+	for (Case& c : cases)
+	{
+		if (c.discard) glEnable(GL_RASTERIZER_DISCARD);
+
+		for (unsigned int i = 0; i < WARMUP + frames; i++)
+		{
+			auto start = Clock::now();
+
+			glClear(GL_COLOR_BUFFER_BIT);
+			batch->Begin(WIDTH, HEIGHT);
+			for (const Winedark::Sprite& sprite : *c.sprites) batch->Draw(sprite);
+			batch->End();
+			double submit = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			glFinish();
+			double frame = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			if (i < WARMUP) continue;
+			c.submitTimes.push_back(submit);
+			c.frameTimes.push_back(frame);
+		}
+		c.drawCalls = batch->GetDrawCalls();
+
+		glDisable(GL_RASTERIZER_DISCARD);
+	}
+
+	/*
+		The log window. Every line is drawn every frame, from
+		the bottom of the screen up, so only the last few
+		dozen are on it; the rest are culled, but still
+		looked up.
+	*/
+	Winedark::TextRenderer* text = new Winedark::TextRenderer(FONT, 32);
+
+	std::vector<std::string> lines(LOG_LINES);
+	for (unsigned int i = 0; i < LOG_LINES; i++)
+	{
+		lines[i] = "[" + std::to_string(i) + "] tick " + std::to_string(i * 7 + rng() % 7) + ": " + std::to_string(rng() % 1000) + " edits, "
+				 + std::to_string(rng() % 100) + " entities moved, chunk (" + std::to_string(rng() % 16) + ", " + std::to_string(rng() % 16) + ") remeshed";
+	}
+
+	std::vector<double> logTimes;
+	unsigned long long firstRasterized = 0, firstMisses = 0;
+	unsigned int logDrawCalls = 0;
+	bool logPassed = text->GetGlyphCache()->IsLoaded();
+
+	for (unsigned int i = 0; logPassed && i < WARMUP + frames; i++)
+	{
+		auto start = Clock::now();
+
+		glClear(GL_COLOR_BUFFER_BIT);
+		text->Begin(WIDTH, HEIGHT);
+
+		float lineHeight = text->GetLineHeight(LOG_TEXT_SIZE);
+		for (unsigned int l = 0; l < LOG_LINES; l++)
+		{
+			text->DrawText(lines[LOG_LINES - 1 - l], { 8.0f, 8.0f + l * lineHeight }, LOG_TEXT_SIZE, Winedark::PackColor({ 0.8f, 0.9f, 0.8f, 1.0f }));
+		}
+		text->End();
+
+		glFinish();
+		double frame = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		/*
+			Everything is shaped and rasterized on the first
+			frame. After that, nothing is.
+		*/
+		Winedark::GlyphCache* cache = text->GetGlyphCache();
+		if (i == 0)
+		{
+			firstRasterized = cache->GetRasterized();
+			firstMisses = text->GetLayoutMisses();
+		}
+		else if (cache->GetRasterized() != firstRasterized || text->GetLayoutMisses() != firstMisses) logPassed = false;
+
+		logDrawCalls = text->GetSpriteBatch()->GetDrawCalls();
+		if (logDrawCalls != 1) logPassed = false;
+
+		if (i >= WARMUP) logTimes.push_back(frame);
+	}
+
+	/*
+		And out it all goes.
+	*/
+	std::ostringstream json;
+	json << "{\n";
+	json << "  \"config\": { \"frames\": " << frames << ", \"sprites\": " << count << ", \"layers\": " << LAYERS << ", \"atlases\": 2"
+		 << ", \"width\": " << WIDTH << ", \"height\": " << HEIGHT << ", \"seed\": " << SEED << ", \"renderer\": \"" << glGetString(GL_RENDERER)
+		 << "\", \"persistent\": " << (batch->IsPersistent() ? "true" : "false") << " },\n";
+	json << "  \"bytesPerSprite\": { \"spriteBatch\": " << 4 * sizeof(Winedark::SpriteVertex) << ", \"quad\": " << sizeof(Winedark::Quad) << " },\n";
+	json << "  \"cases\": {";
+
+	const char* separator = "\n";
+	for (Case& c : cases)
+	{
+		json << separator << "    \"" << c.name << "\": { \"drawCalls\": " << c.drawCalls
+			 << ", \"submitMs\": { \"mean\": " << Mean(c.submitTimes) << ", \"p50\": " << Percentile(c.submitTimes, 0.5) << ", \"p95\": " << Percentile(c.submitTimes, 0.95) << " }"
+			 << ", \"frameMs\": { \"mean\": " << Mean(c.frameTimes) << ", \"p50\": " << Percentile(c.frameTimes, 0.5) << ", \"p95\": " << Percentile(c.frameTimes, 0.95) << " }"
+			 << ", \"spritesPerMs\": " << count / std::max(Mean(c.submitTimes), 1e-6) << " }";
+		separator = ",\n";
+	}
+	json << "\n  },\n";
+	json << "  \"log\": { \"font\": \"" << FONT << "\", \"loaded\": " << (text->GetGlyphCache()->IsLoaded() ? "true" : "false") << ", \"lines\": " << LOG_LINES
+		 << ", \"drawCalls\": " << logDrawCalls << ", \"layouts\": " << text->GetLayoutCount()
+		 << ", \"rasterized\": { \"first\": " << firstRasterized << ", \"total\": " << text->GetGlyphCache()->GetRasterized() << " }"
+		 << ", \"layoutMisses\": { \"first\": " << firstMisses << ", \"total\": " << text->GetLayoutMisses() << " }"
+		 << ", \"frameMs\": { \"mean\": " << Mean(logTimes) << ", \"p50\": " << Percentile(logTimes, 0.5) << ", \"p95\": " << Percentile(logTimes, 0.95) << " }"
+		 << ", \"passed\": " << (logPassed ? "true" : "false") << " }\n";
+	json << "}\n";
+
+	if (output != nullptr)
+	{
+		std::ofstream file(output, std::ios::trunc);
+		file << json.str();
+	}
+	std::cout << json.str();
+
+	delete text;
+	delete batch;
+	for (unsigned int a = 0; a < 2; a++)
+	{
+		for (Winedark::Texture* t : textures[a]) delete t;
+		delete atlases[a];
+	}
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return logPassed ? 0 : 2;
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+// traversalcheck.cpp
+//
+// Checks TraceRay (the compute shader's traversal, built from
+// traverse.glsl) against MarchRay, the plain DDA that is the reference
+// for it, on worlds generated from a fixed seed: noise and sea, at
+// several sizes. Each world is looked at from a handful of directions,
+// axis-aligned and oblique, with a grid of parallel rays that covers it
+// from outside. Needs nothing but winedark_core, so it runs wherever
+// that builds, unlike the G key in the game.
+//
+// Two hits agree as they do in Renderer::ValidateTraversal: the same
+// packed hit with depths at most one apart, or, for a ray straight down
+// an edge between voxels, the same as the reference gives with the ray
+// nudged a little to one side. Here, where we have the hits and not
+// just what was packed of them, a ray that comes into a voxel right
+// through an edge (crossing two faces at once) may also name either
+// face.
+//
+// Prints JSON, and exits with 2 if any ray disagrees, so it is a test
+// of the traversal.
+//
+// Usage: winedark_traversal_check [output.json]
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+#include "../world/octree.h"
+#include "../world/generator.h"
+#include "../world/traversal.h"
+
+const unsigned int SEED = 1;
+const float NOISE_FILL = 0.5f;
+const unsigned int SIZES[] = { 16, 32, 64, 128 };
+const unsigned int GRID = 64;
+
+/*
+	The directions the worlds are looked at from. The first
+	three are straight down each axis, where rays run along
+	the faces between voxels, and the rest are oblique.
+*/
+const glm::vec3 DIRECTIONS[] = {
+	{ 0.0f, 0.0f, 1.0f },
+	{ 1.0f, 0.0f, 0.0f },
+	{ 0.0f, -1.0f, 0.0f },
+	{ 1.0f, 1.0f, 1.0f },
+	{ -0.3f, 0.2f, 1.0f },
+	{ 0.7f, -1.0f, 0.15f },
+	{ -1.0f, -0.45f, -0.8f }
+};
+
+/*
+	What checking one world came to.
+*/
+struct TraversalCheck
+{
+	unsigned int	rays = 0;
+	unsigned int	hits = 0;
+	unsigned int	mismatches = 0;
+
+	/*
+		Traces GRID x GRID parallel rays at the octree from
+		each direction, from outside it, and checks each.
+	*/
+	void Run(Winedark::Octree* octree)
+	{
+		unsigned int size = octree->GetSize();
+		const Winedark::Voxel* voxels = octree->GetVoxels();
+		float s = (float)size;
+
+		/*
+			Two packed hits are the same if everything but the
+			depth is, and the depths are at most one apart.
+		*/
+		auto same = [](unsigned int a, unsigned int b)
+		{
+			if ((a & 0x3FFF) != (b & 0x3FFF)) return false;
+			return std::abs((int)(a >> 14) - (int)(b >> 14)) <= 1;
+		};
+
+		for (const glm::vec3& direction : DIRECTIONS)
+		{
+			glm::vec3 forward = glm::normalize(direction);
+			glm::vec3 right = glm::normalize(glm::cross(std::abs(forward.y) < 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), forward));
+			glm::vec3 up = glm::cross(forward, right);
+			glm::vec3 nudges[4] = { right * 1e-3f, -right * 1e-3f, up * 1e-3f, -up * 1e-3f };
+
+			/*
+				The grid is a little wider than the world's
+				diagonal, so some rays miss it altogether.
+			*/
+			float extent = s * 0.9f;
+			float spacing = 2.0f * extent / GRID;
+
+			for (unsigned int v = 0; v < GRID; v++)
+			{
+				for (unsigned int u = 0; u < GRID; u++)
+				{
+					glm::vec3 origin = -forward * (s * 2.0f) + right * (-extent + (u + 0.5f) * spacing) + up * (-extent + (v + 0.5f) * spacing);
+
+					Winedark::RayHit hit = Winedark::MarchRay(voxels, size, origin, forward);
+					unsigned int reference = Winedark::PackHit(hit);
+					Winedark::RayHit tracedHit = Winedark::TraceRay(voxels, size, origin, forward);
+					unsigned int traced = Winedark::PackHit(tracedHit);
+
+					rays++;
+					if (hit.type != 0) hits++;
+					if (same(traced, reference)) continue;
+
+					/*
+						The face the trace names has to be one the
+						ray crosses where it hits, to within the
+						float error at that distance.
+					*/
+					if (tracedHit.type == hit.type && tracedHit.type != 0 && std::abs(tracedHit.t - hit.t) < 1.0f / 16.0f)
+					{
+						float c = origin[tracedHit.face] + forward[tracedHit.face] * tracedHit.t + s * 0.5f;
+						if (std::abs(c - std::round(c)) < 1e-3f) continue;
+					}
+
+					bool nudged = false;
+					for (glm::vec3& nudge : nudges)
+					{
+						if (same(traced, Winedark::PackHit(Winedark::MarchRay(voxels, size, origin + nudge, forward)))) nudged = true;
+					}
+
+					if (!nudged) mismatches++;
+				}
+			}
+		}
+	}
+};
+
+int main(int argc, char** argv)
+{
+	const char* output = (argc > 1) ? argv[1] : nullptr;
+
+	std::ostringstream json;
+	unsigned int mismatches = 0;
+
+	json << "{\n";
+	json << "  \"config\": { \"seed\": " << SEED << ", \"noiseFill\": " << NOISE_FILL << ", \"grid\": " << GRID
+		 << ", \"directions\": " << sizeof(DIRECTIONS) / sizeof(DIRECTIONS[0]) << " },\n";
+	json << "  \"worlds\": [\n";
+
+	bool first = true;
+	for (unsigned int size : SIZES)
+	{
+		for (unsigned int world = 0; world < 2; world++)
+		{
+			Winedark::Octree* octree = new Winedark::Octree(size);
+			if (world == 0) Winedark::GenerateNoise(octree, SEED, NOISE_FILL);
+			else Winedark::GenerateSea(octree, SEED);
+
+			TraversalCheck check;
+			check.Run(octree);
+			mismatches += check.mismatches;
+
+			json << (first ? "" : ",\n") << "    { \"world\": \"" << (world == 0 ? "noise" : "sea") << "\", \"size\": " << size
+				 << ", \"rays\": " << check.rays << ", \"hits\": " << check.hits << ", \"mismatches\": " << check.mismatches << " }";
+			first = false;
+
+			delete octree;
+		}
+	}
+
+	json << "\n  ],\n";
+	json << "  \"mismatches\": " << mismatches << "\n";
+	json << "}\n";
+
+	if (output != nullptr)
+	{
+		std::ofstream file(output, std::ios::trunc);
+		file << json.str();
+	}
+	std::cout << json.str();
+
+	return (mismatches > 0) ? 2 : 0;
+}
\ No newline at end of file
@@ -1,22 +1,52 @@
 // main.cpp
 //
 
+#include <ctime>
 #include <chrono>
 #include <string>
+#include <vector>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
-#include <corecrt_math_defines.h>
+#include <functional>
+#include <filesystem>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
 #include "rendering/renderer.h"
+#include "rendering/voxeleditor.h"
+#include "world/journal.h"
+#include "world/generator.h"
+#include "world/simulation.h"
+#include "util/profiler.h"
+#include "util/framepacer.h"
 
 #define VERSION 0.01
 
-void main()
+/*
+	When nothing on screen would change, we skip drawing
+	and sleep until there's input (or IDLE_TIMEOUT seconds
+	pass). While it is changing, we draw at most FRAME_CAP
+	frames a second (zero for no cap).
+*/
+#define RENDER_ON_DEMAND true
+#define FRAME_CAP 120.0
+#define IDLE_TIMEOUT 0.25
+
+/*
+	A debug key: which key it is, what it does, and whether
+	it was down last frame.
+*/
+struct DebugKey
+{
+	int						key;
+	std::function<void()>	action;
+	bool					pressed = false;
+};
+
+int main()
 {
 	/*
 		Let's get some meta-details straight.
@@ -39,7 +69,7 @@ void main()
 	if (!glfwInit())
 	{
 		std::cout << "Failed to initialize GLFW." << std::endl;
-		return;
+		return 1;
 	}
 
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -55,7 +85,7 @@ void main()
 	{
 		glfwTerminate();
 		std::cout << "Failed to create Opengl Window." << std::endl;
-		return;
+		return 1;
 	}
 
 	glfwMakeContextCurrent(window);
@@ -63,7 +93,7 @@ void main()
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 	{
 		std::cout << "Failed to initialize GLAD" << std::endl;
-		return;
+		return 1;
 	}
 
 	glEnable(GL_BLEND);
@@ -77,8 +107,45 @@ void main()
 	*/
 	int size = 128;
 	Winedark::Camera* camera = new Winedark::Camera(1.0f, { (float)size / 2.0f, (float)size / 2.0f, -size - 100.0f}, {1.0f, 0.0f, 0.0f, 0.0f}, 1600, 600, 0.01f, 2000.0f);
-	Winedark::Octree* octree = new Winedark::Octree(size, camera);
-	Winedark::Renderer* renderer = new Winedark::Renderer(camera, octree);
+	Winedark::Octree* octree = new Winedark::Octree(size);
+	Winedark::OctreeBuffer* buffer = new Winedark::OctreeBuffer(octree);
+	Winedark::Renderer* renderer = new Winedark::Renderer(camera, buffer);
+	Winedark::VoxelEditor* editor = new Winedark::VoxelEditor(buffer);
+
+	/*
+		The minimap is a secondary view in the top right
+		corner that follows the camera around. It's traced
+		at half resolution, at most every fourth frame.
+	*/
+	Winedark::Camera* minimapCamera = new Winedark::Camera(1.0f, camera->GetPosition(), camera->GetRotation(), 240, 240, 0.01f, 2000.0f);
+	int minimap = -1;
+
+	/*
+		If we've saved this world before, we load the
+		last checkpoint plus any edits made since.
+		Otherwise we generate a new one.
+	*/
+	std::filesystem::create_directories("saves");
+	Winedark::EditJournal* journal = new Winedark::EditJournal("saves/world");
+	if (!journal->Load(octree)) Winedark::GenerateNoise(octree, time(NULL), 0.5f);
+	journal->Attach(octree);
+
+	Winedark::Simulation* simulation = new Winedark::Simulation(octree, journal);
+
+	/*
+		The window needs drawing again when it's uncovered or
+		resized, even if nothing in it has changed, and any
+		key might change what's shown, so we draw the frame
+		after one too.
+	*/
+	static bool windowDamaged = true;
+	static bool inputReceived = false;
+
+	glfwSetWindowRefreshCallback(window, [](GLFWwindow*) { windowDamaged = true; });
+	glfwSetFramebufferSizeCallback(window, [](GLFWwindow*, int, int) { windowDamaged = true; });
+	glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int) { inputReceived = true; });
+
+	Winedark::FramePacer pacer(FRAME_CAP);
 
 	/*
 		And now we can run the loop.
@@ -87,36 +154,280 @@ void main()
 	auto fpsStart = std::chrono::steady_clock::now();
 	int frameCount = 0;
 
+	/*
+		The debug keys, each with what it does. An action runs
+		once when its key goes down, and not again until the
+		key has been let go.
+	*/
+	std::vector<DebugKey> debugKeys = {
+		/*
+			F2 checks the beam optimization against a plain
+			trace of the current view and F3 toggles it.
+		*/
+		{ GLFW_KEY_F2, [&]()
+		{
+			Winedark::TraversalStats single, beam;
+			unsigned int mismatches = renderer->ValidateBeam(single, beam);
+
+			std::cout << "Beam Validation: " << mismatches << " pixels differ." << std::endl;
+			std::cout << "    Single Pass: " << single.traceSteps << " steps over " << single.traceRays << " rays" << std::endl;
+			std::cout << "    Beam Pass: " << beam.beamSteps << " coarse + " << beam.traceSteps << " steps over " << beam.beamRays << " + " << beam.traceRays << " rays" << std::endl;
+		} },
+		{ GLFW_KEY_F3, [&]()
+		{
+			renderer->SetBeamOptimization(!renderer->GetBeamOptimization());
+			std::cout << "Beam Optimization: " << (renderer->GetBeamOptimization() ? "On" : "Off") << std::endl;
+		} },
+
+		/*
+			G checks the traversal, on the GPU and its CPU
+			build, against a voxel-by-voxel DDA of the view.
+		*/
+		{ GLFW_KEY_G, [&]()
+		{
+			unsigned int cpuMismatches;
+			unsigned int mismatches = renderer->ValidateTraversal(cpuMismatches);
+
+			std::cout << "Traversal Validation: " << mismatches << " pixels differ (" << cpuMismatches << " on the CPU)." << std::endl;
+		} },
+
+		/*
+			F4 times the trace with each workgroup size and
+			keeps the fastest.
+		*/
+		{ GLFW_KEY_F4, [&]()
+		{
+			std::vector<Winedark::LocalSizeTiming> timings = renderer->TuneLocalSize(20);
+
+			std::cout << "Workgroup Sizes:" << std::endl;
+			for (auto& timing : timings) std::cout << "    " << timing.x << "x" << timing.y << ": " << timing.ms << " ms" << std::endl;
+			std::cout << "Using " << renderer->GetLocalSizeX() << "x" << renderer->GetLocalSizeY() << "." << std::endl;
+		} },
+
+		/*
+			F7 toggles reprojection when panning and F8
+			checks what it's built up against a full trace.
+		*/
+		{ GLFW_KEY_F7, [&]()
+		{
+			renderer->SetReprojection(!renderer->GetReprojection());
+			std::cout << "Reprojection: " << (renderer->GetReprojection() ? "On" : "Off") << std::endl;
+		} },
+		{ GLFW_KEY_F8, [&]()
+		{
+			std::cout << "Reprojection Validation: " << renderer->ValidateReprojection() << " pixels differ." << std::endl;
+		} },
+
+		/*
+			F9 toggles the resolution controller.
+		*/
+		{ GLFW_KEY_F9, [&]()
+		{
+			renderer->SetAdaptiveResolution(!renderer->GetAdaptiveResolution());
+			if (!renderer->GetAdaptiveResolution()) renderer->SetRenderScale(1.0f);
+
+			std::cout << "Adaptive Resolution: " << (renderer->GetAdaptiveResolution() ? "On" : "Off")
+					  << " (" << renderer->GetTraceBudget() << " ms budget)" << std::endl;
+		} },
+
+		/*
+			F10 toggles progressive refinement.
+		*/
+		{ GLFW_KEY_F10, [&]()
+		{
+			renderer->SetProgressive(!renderer->GetProgressive());
+			std::cout << "Progressive Refinement: " << (renderer->GetProgressive() ? "On" : "Off") << std::endl;
+		} },
+
+		/*
+			F11 toggles the minimap.
+		*/
+		{ GLFW_KEY_F11, [&]()
+		{
+			if (minimap < 0) minimap = renderer->AddView(minimapCamera, { camera->GetWidth() - 250.0f, camera->GetHeight() - 250.0f }, 0.5f, 4);
+			else
+			{
+				renderer->RemoveView(minimap);
+				minimap = -1;
+			}
+			std::cout << "Minimap: " << ((minimap >= 0) ? "On" : "Off") << std::endl;
+		} },
+
+		/*
+			F12 digs a 9 x 9 shaft straight through the world
+			under the camera, on the GPU, next tick.
+		*/
+		{ GLFW_KEY_F12, [&]()
+		{
+			int cx = (int)camera->GetPosition().x;
+			int cy = (int)camera->GetPosition().y;
+
+			for (int x = cx - 4; x <= cx + 4; x++)
+			{
+				for (int y = cy - 4; y <= cy + 4; y++)
+				{
+					if (x < 0 || y < 0 || x >= size || y >= size) continue;
+					for (int z = 0; z < size; z++) simulation->QueueEdit(x, y, z, 0);
+				}
+			}
+		} },
+
+		/*
+			M switches the main view between tracing and
+			drawing meshes.
+		*/
+		{ GLFW_KEY_M, [&]()
+		{
+			bool meshed = (renderer->GetBackend() == Winedark::Backend::Mesh);
+			renderer->SetBackend(meshed ? Winedark::Backend::Trace : Winedark::Backend::Mesh);
+			std::cout << "Backend: " << (meshed ? "Trace" : "Mesh") << std::endl;
+		} },
+
+		/*
+			F1 steps the heatmap through each traversal count
+			and then off, which turns instrumentation off too.
+		*/
+		{ GLFW_KEY_F1, [&]()
+		{
+			const char* names[] = { "Visits", "Pushes", "Pops", "Iterations" };
+			int next = (int)renderer->GetHeatmap() + 1;
+
+			if (next > (int)Winedark::Heatmap::Iterations)
+			{
+				renderer->SetInstrumented(false);
+				std::cout << "Heatmap: Off" << std::endl;
+			}
+			else
+			{
+				renderer->SetHeatmap((Winedark::Heatmap)next);
+				std::cout << "Heatmap: " << names[next] << std::endl;
+			}
+		} },
+
+		/*
+			F5 dumps what the profiler has recorded as a
+			Chrome trace, and F6 prints how long each zone
+			has been taking.
+		*/
+		{ GLFW_KEY_F5, [&]()
+		{
+			if (Winedark::WriteChromeTrace("profile.json")) std::cout << "Wrote profile.json." << std::endl;
+		} },
+		{ GLFW_KEY_F6, [&]()
+		{
+			std::cout << std::left << std::setw(32) << "Zone" << std::right << std::setw(8) << "Count" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms" << std::setw(10) << "p99 ms" << std::endl;
+			for (auto& zone : Winedark::GetProfileStats())
+			{
+				std::cout << std::left << std::setw(32) << zone.name << std::right << std::setw(8) << zone.count << std::fixed << std::setprecision(3)
+						  << std::setw(10) << zone.p50 << std::setw(10) << zone.p95 << std::setw(10) << zone.p99 << std::defaultfloat << std::endl;
+			}
+		} }
+	};
+
 	while (!glfwWindowShouldClose(window))
 	{
+		PROFILE_SCOPE("Frame");
+
 		float deltaTime = glfwGetTime() - lastTime;
 		lastTime = glfwGetTime();
 
-		frameCount++;
 		auto now = std::chrono::steady_clock::now();
 		auto fpsDiff = now - fpsStart;
 
 		if (fpsDiff >= std::chrono::seconds(1))
 		{
 			fpsStart = now;
-			std::cout << "Frame Count: " << frameCount << std::endl;
+			if (frameCount > 0) std::cout << "Frame Count: " << frameCount << std::endl;
+			if (renderer->GetAdaptiveResolution()) std::cout << "Render Scale: " << renderer->GetRenderScale() << std::endl;
+
+			Winedark::TraversalCounters c = renderer->GetTraversalCounters();
+			if (renderer->GetInstrumented() && c.rays > 0)
+			{
+				std::cout << "Per Ray: " << (float)c.visits / c.rays << " visits, " << (float)c.pushes / c.rays << " pushes, "
+						  << (float)c.pops / c.rays << " pops, " << (float)c.iterations / c.rays << " iterations (max " << c.maxIterations << ", "
+						  << c.activeRays << " of " << c.rays << " rays in the octree)" << std::endl;
+			}
 			frameCount = 0;
 		}
 
-		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-
-		octree->Update();
+		simulation->Tick();
+		{
+			GPU_PROFILE_SCOPE(renderer->GetGpuTimer(), "GPU Voxel Upload");
+			buffer->Update();
+			editor->Apply();
+		}
 		camera->Update(window, deltaTime);
-		renderer->Render();
+		if (minimap >= 0 && minimapCamera->GetPosition() != camera->GetPosition()) minimapCamera->SetPosition(camera->GetPosition());
+
+		/*
+			Skipping the frame skips the swap too, so the last
+			one we drew stays up.
+		*/
+		bool draw = !RENDER_ON_DEMAND || windowDamaged || renderer->IsUpdateNeeded();
+		windowDamaged = false;
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		if (inputReceived)
+		{
+			renderer->RequestRedraw();
+			inputReceived = false;
+		}
+
+		if (draw)
+		{
+			frameCount++;
+
+			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+			renderer->Render();
+		}
+
+		/*
+			The debug keys have no say in whether we draw:
+			pressing one is input like any other, so the key
+			callback has already asked for the next frame.
+		*/
+		for (DebugKey& debugKey : debugKeys)
+		{
+			bool down = (glfwGetKey(window, debugKey.key) == GLFW_PRESS);
+			if (down && !debugKey.pressed) debugKey.action();
+			debugKey.pressed = down;
+		}
+
+		if (draw)
+		{
+			{
+				PROFILE_SCOPE("SwapBuffers");
+				glfwSwapBuffers(window);
+			}
+			pacer.Wait();
+		}
+
+		/*
+			Once a frame goes by with nothing to draw, we sleep
+			until there's something to do. (Not straight after
+			a drawn frame: a held key moves the camera without
+			any new events.) The time spent asleep isn't time
+			the camera should have moved for.
+		*/
+		if (RENDER_ON_DEMAND && !draw && !renderer->IsUpdateNeeded())
+		{
+			PROFILE_SCOPE("Idle");
+			glfwWaitEventsTimeout(IDLE_TIMEOUT);
+			lastTime = glfwGetTime();
+		}
+		else glfwPollEvents();
 	}
 
 	std::cout << "Shutting down Winedark. Have a wonderful day!" << std::endl;
 
+	delete simulation;
+	delete journal;
 	delete camera;
-	delete octree;
+	delete minimapCamera;
+	delete editor;
 	delete renderer;
+	delete buffer;
+	delete octree;
+
+	return 0;
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "camera.h"
 
+#include "../util/profiler.h"
+
 namespace Winedark
 {
 	/*----------------------------------------------------------------------------------------------*/
@@ -42,6 +44,8 @@ namespace Winedark
 	/* Update ---------------------------------------------*/
 	void Camera::Update(GLFWwindow* window, float dt)
 	{
+		PROFILE_SCOPE("Camera::Update");
+
 		HandleInput(window, dt);
 		UpdateView();
 		UpdateProjection();
@@ -82,8 +86,16 @@ namespace Winedark
 			HasChanged();
 		}
 
-		if (zoomIn) zoom -= zoomSpeed * dt;
-		else if (zoomOut) zoom += zoomSpeed * dt;
+		if (zoomIn)
+		{
+			zoom -= zoomSpeed * dt;
+			HasChanged();
+		}
+		else if (zoomOut)
+		{
+			zoom += zoomSpeed * dt;
+			HasChanged();
+		}
 
 		if (zoom < minZoom) zoom = minZoom;
 		else if (zoom > maxZoom) zoom = maxZoom;
@@ -81,6 +81,7 @@ namespace Winedark
 		/* Flag Functions 2									   */
 		/*-----------------------------------------------------*/
 		bool				CheckChanged();
+		bool				IsChanged() { return changed; }
 
 		/*-----------------------------------------------------*/
 		/* General Functions								   */
@@ -95,6 +96,9 @@ namespace Winedark
 		Quaternion			GetRotation() { return rotation; }
 		float				GetZoom() { return zoom; }
 
+		void				SetPosition(glm::vec3 position) { this->position = position; HasChanged(); }
+		void				SetRotation(Quaternion rotation) { this->rotation = rotation; HasChanged(); }
+
 		/*-----------------------------------------------------*/
 		/* Position & Rotation Functions					   */
 		/*-----------------------------------------------------*/
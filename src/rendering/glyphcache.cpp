@@ -0,0 +1,245 @@
+#include "glyphcache.h"
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include FT_MODULE_H
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Glyph Cache																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*
+		How far out from the outline (in pixels at the cache's size) the
+		distance field goes. FreeType's default of 2 is fine at the size
+		it was rendered at, but the further we scale text up the more of
+		the field the edge is smoothed over, and the more we want.
+	*/
+	const int SDF_SPREAD = 4;
+
+	/*
+		Glyphs sit a texel in from the edges of their cells, so linear
+		filtering at a glyph's edge never picks up its neighbour's.
+	*/
+	const int CELL_MARGIN = 1;
+
+	/*-----------------------------------------------------------------------*/
+	/* Glyph Cache															 */
+	/*-----------------------------------------------------------------------*/
+	/*-----------------------------------------------------*/
+	/* Cell Functions									   */
+	/*-----------------------------------------------------*/
+	/* TakeCell -------------------------------------------*/
+	/*
+		Finds a cell for a glyph: a free one, if there is
+		one, and otherwise the least recently used, whose
+		glyph we evict. Cells used this frame are off limits.
+
+		Input: None
+		Output: The cell, or -1 if there isn't one to take
+	*/
+	int GlyphCache::TakeCell()
+	{
+		int best = -1;
+
+		for (int i = 0; i < (int)cells.size(); i++)
+		{
+			if (cells[i].glyph < 0) return i;
+			if (best < 0 || cells[i].lastUsed < cells[best].lastUsed) best = i;
+		}
+
+		if (best < 0 || cells[best].lastUsed == frame) return -1;
+
+		this->glyphs[cells[best].glyph].slot = -1;
+		this->cells[best].glyph = -1;
+		this->evicted++;
+
+		return best;
+	}
+
+	/* Rasterize ------------------------------------------*/
+	/*
+		Renders a glyph's distance field with FreeType and
+		copies it into a cell of the page, upside down, since
+		FreeType's rows go top to bottom and ours bottom to
+		top. Glyphs too big for a cell are cropped.
+
+		Input: The glyph
+		Output: Whether it's now in a cell
+	*/
+	bool GlyphCache::Rasterize(Glyph& glyph)
+	{
+		PROFILE_SCOPE("GlyphCache::Rasterize");
+
+		if (FT_Load_Glyph(face, glyph.index, FT_LOAD_NO_HINTING) || FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF))
+		{
+			std::cout << "ERROR::GLYPHCACHE::RENDER_FAILED " << glyph.index << std::endl;
+			glyph.width = glyph.height = 0;
+			return false;
+		}
+
+		FT_GlyphSlot slot = face->glyph;
+		glyph.advance = slot->advance.x / 64.0f;
+		glyph.left = slot->bitmap_left;
+		glyph.top = slot->bitmap_top;
+		glyph.width = std::min((int)slot->bitmap.width, cellSize - 2 * CELL_MARGIN);
+		glyph.height = std::min((int)slot->bitmap.rows, cellSize - 2 * CELL_MARGIN);
+		this->rasterized++;
+
+		if (glyph.width == 0 || glyph.height == 0) return false;
+
+		int cell = TakeCell();
+		if (cell < 0) return false;
+
+		std::fill(staging.begin(), staging.end(), 0);
+		for (int y = 0; y < glyph.height; y++)
+		{
+			const unsigned char* row = slot->bitmap.buffer + y * slot->bitmap.pitch;
+			std::copy(row, row + glyph.width, &staging[(size_t)(cellSize - 1 - CELL_MARGIN - y) * cellSize + CELL_MARGIN]);
+		}
+
+		page.Upload((cell % columns) * cellSize, (cell / columns) * cellSize, cellSize, cellSize, GL_RED, staging.data());
+
+		glyph.slot = cell;
+		this->cells[cell] = { (int)(&glyph - glyphs.data()), frame };
+		return true;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Glyph Functions									   */
+	/*-----------------------------------------------------*/
+	/* GetGlyphID -----------------------------------------*/
+	/*
+		Finds the glyph for a character, rendering it if
+		it's the first time we've seen it. Characters the
+		font doesn't have get its missing glyph.
+
+		Input: Unicode codepoint
+		Output: The glyph's id
+	*/
+	unsigned int GlyphCache::GetGlyphID(unsigned int codepoint)
+	{
+		auto it = ids.find(codepoint);
+		if (it != ids.end()) return it->second;
+
+		Glyph glyph = { 0, 0.0f, 0, 0, 0, 0, -1 };
+		if (face != nullptr) glyph.index = FT_Get_Char_Index(face, codepoint);
+
+		unsigned int id = (unsigned int)glyphs.size();
+		glyphs.push_back(glyph);
+		ids[codepoint] = id;
+
+		if (face != nullptr) Rasterize(glyphs[id]);
+		return id;
+	}
+
+	/* GetKerning -----------------------------------------*/
+	/*
+		Input: Glyph ids of a pair of neighbouring glyphs
+		Output: How much closer they go, in pixels
+	*/
+	float GlyphCache::GetKerning(unsigned int left, unsigned int right)
+	{
+		if (face == nullptr || !FT_HAS_KERNING(face)) return 0.0f;
+
+		FT_Vector delta;
+		if (FT_Get_Kerning(face, glyphs[left].index, glyphs[right].index, FT_KERNING_UNFITTED, &delta)) return 0.0f;
+		return delta.x / 64.0f;
+	}
+
+	/* Use ------------------------------------------------*/
+	/*
+		Marks a glyph as used this frame, rendering it again
+		if it's been evicted, and tells us where it is.
+
+		Input: The glyph's id & where to put its region
+		Output: Whether there's anything to draw
+	*/
+	bool GlyphCache::Use(unsigned int id, glm::vec4& region)
+	{
+		Glyph& glyph = glyphs[id];
+		if (glyph.width == 0 || glyph.height == 0) return false;
+		if (glyph.slot < 0 && !Rasterize(glyph)) return false;
+
+		this->cells[glyph.slot].lastUsed = frame;
+
+		float x = (float)((glyph.slot % columns) * cellSize + CELL_MARGIN);
+		float y = (float)((glyph.slot / columns) * cellSize + cellSize - CELL_MARGIN);
+		region = { x / page.GetWidth(), (y - glyph.height) / page.GetHeight(), (x + glyph.width) / page.GetWidth(), y / page.GetHeight() };
+		return true;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor & Deconstructor						   */
+	/*-----------------------------------------------------*/
+	/* Constructor ----------------------------------------*/
+	/*
+		Opens the font and allocates a page with room for
+		capacity glyphs. If the font can't be opened, every
+		glyph comes out blank.
+
+		Input: Font file, size to render glyphs at (in
+			   pixels) & most glyphs to keep
+		Output: (Glyph Cache)
+	*/
+	GlyphCache::GlyphCache(const char* path, unsigned int pixelSize, unsigned int capacity)
+	{
+		this->library = nullptr;
+		this->face = nullptr;
+		this->pixelSize = pixelSize;
+		this->lineHeight = (float)pixelSize;
+		this->ascender = (float)pixelSize;
+		this->frame = 0;
+		this->rasterized = 0;
+		this->evicted = 0;
+
+		if (FT_Init_FreeType(&library) || FT_New_Face(library, path, 0, &face))
+		{
+			std::cout << "ERROR::GLYPHCACHE::FONT_NOT_LOADED " << path << std::endl;
+			this->face = nullptr;
+		}
+
+		int spread = SDF_SPREAD;
+		this->cellSize = (int)pixelSize + 2 * (spread + CELL_MARGIN);
+
+		if (face != nullptr)
+		{
+			FT_Property_Set(library, "sdf", "spread", &spread);
+			FT_Property_Set(library, "bsdf", "spread", &spread);
+			FT_Set_Pixel_Sizes(face, 0, pixelSize);
+
+			/*
+				A cell has to fit the tallest and widest glyphs
+				we expect: ascender to descender, and the
+				widest advance.
+			*/
+			FT_Size_Metrics& metrics = face->size->metrics;
+			this->lineHeight = metrics.height / 64.0f;
+			this->ascender = metrics.ascender / 64.0f;
+
+			int extent = (int)std::ceil(std::max(metrics.ascender - metrics.descender, metrics.max_advance) / 64.0f);
+			this->cellSize = extent + 2 * (spread + CELL_MARGIN);
+		}
+
+		capacity = std::max(1u, capacity);
+		this->columns = (int)std::ceil(std::sqrt((double)capacity));
+		int rows = ((int)capacity + columns - 1) / columns;
+
+		page.Allocate(columns * cellSize, rows * cellSize, GL_R8, GL_RED, GL_LINEAR);
+		cells.assign(capacity, { -1, 0 });
+		staging.resize((size_t)cellSize * cellSize);
+	}
+
+	/* Deconstructor --------------------------------------*/
+	GlyphCache::~GlyphCache()
+	{
+		if (face != nullptr) FT_Done_Face(face);
+		if (library != nullptr) FT_Done_FreeType(library);
+	}
+}
\ No newline at end of file
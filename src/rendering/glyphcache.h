@@ -0,0 +1,150 @@
+#ifndef GLYPHCACHE_H
+#define GLYPHCACHE_H
+
+#include <vector>
+#include <unordered_map>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "textureatlas.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Glyph Cache																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Glyph																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		What we know about one of the font's glyphs, in pixels at the
+		cache's SDF size. Its bitmap is the signed distance field (with
+		the spread around the outline), and (left, top) is where its top
+		left corner goes from the pen. Slot is the cell of the atlas it's
+		in, or -1 if it isn't in one right now (or has nothing to draw,
+		like a space).
+	*/
+	struct Glyph
+	{
+		unsigned int		index;
+		float				advance;
+		int					left, top;
+		int					width, height;
+		int					slot;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Glyph Cache															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Keeps the glyphs of one font as signed distance fields, in a
+		page of a TextureAtlas. They're rendered by FreeType the first
+		time they're asked for, at one size, and drawn at any size from
+		there (see text.frag).
+
+		The page is a grid of equal cells, each big enough for any glyph
+		in the font, so any glyph can go in any free cell. Once they're
+		all taken, the least recently used glyph is evicted to make room:
+		each cell remembers the last frame it was drawn in. We only ever
+		forget a glyph's bitmap, not its metrics, so laying text out
+		never has to go back to FreeType for a glyph it's seen before.
+		Glyphs used this frame are never evicted; if there's nothing else
+		to evict, the glyph isn't drawn.
+
+		Glyphs are referred to by their id, their place in GetGlyph's
+		list, which never changes.
+	*/
+	class GlyphCache
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Cell												   */
+		/*-----------------------------------------------------*/
+		struct Cell
+		{
+			int					glyph;
+			unsigned long long	lastUsed;
+		};
+
+		/*-----------------------------------------------------*/
+		/* Font												   */
+		/*-----------------------------------------------------*/
+		FT_Library					library;
+		FT_Face						face;
+		unsigned int				pixelSize;
+		float						lineHeight;
+		float						ascender;
+
+		/*-----------------------------------------------------*/
+		/* Glyphs											   */
+		/*-----------------------------------------------------*/
+		std::vector<Glyph>			glyphs;
+		std::unordered_map<unsigned int, unsigned int>	ids;
+
+		/*-----------------------------------------------------*/
+		/* Page												   */
+		/*-----------------------------------------------------*/
+		TextureAtlas				page;
+		std::vector<Cell>			cells;
+		std::vector<unsigned char>	staging;
+		int							cellSize;
+		int							columns;
+
+		/*-----------------------------------------------------*/
+		/* Frame & Stats									   */
+		/*-----------------------------------------------------*/
+		unsigned long long			frame;
+		unsigned long long			rasterized;
+		unsigned long long			evicted;
+
+		/*-----------------------------------------------------*/
+		/* Cell Functions									   */
+		/*-----------------------------------------------------*/
+		int							TakeCell();
+		bool						Rasterize(Glyph& glyph);
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Glyph Functions									   */
+		/*-----------------------------------------------------*/
+		unsigned int				GetGlyphID(unsigned int codepoint);
+		Glyph&						GetGlyph(unsigned int id) { return glyphs[id]; }
+		float						GetKerning(unsigned int left, unsigned int right);
+		bool						Use(unsigned int id, glm::vec4& region);
+
+		/*-----------------------------------------------------*/
+		/* Font Functions									   */
+		/*-----------------------------------------------------*/
+		bool						IsLoaded() { return face != nullptr; }
+		unsigned int				GetPixelSize() { return pixelSize; }
+		float						GetLineHeight() { return lineHeight; }
+		float						GetAscender() { return ascender; }
+
+		/*-----------------------------------------------------*/
+		/* Page Functions									   */
+		/*-----------------------------------------------------*/
+		TextureAtlas*				GetPage() { return &page; }
+		unsigned int				GetCapacity() { return (unsigned int)cells.size(); }
+
+		/*-----------------------------------------------------*/
+		/* Frame & Stat Functions							   */
+		/*-----------------------------------------------------*/
+		void						NextFrame() { this->frame++; }
+		unsigned long long			GetFrame() { return frame; }
+		unsigned long long			GetRasterized() { return rasterized; }
+		unsigned long long			GetEvicted() { return evicted; }
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		GlyphCache(const char* path, unsigned int pixelSize, unsigned int capacity);
+		~GlyphCache();
+	};
+}
+
+#endif
\ No newline at end of file
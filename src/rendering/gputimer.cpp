@@ -0,0 +1,157 @@
+#include "gputimer.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* GPU Timer																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* GPU Timer															 */
+	/*-----------------------------------------------------------------------*/
+	/*-----------------------------------------------------*/
+	/* Timing Functions									   */
+	/*-----------------------------------------------------*/
+	/* Begin ----------------------------------------------*/
+	/*
+		Marks the start of a pass on the GPU.
+
+		Input: Pass name (must live forever)
+		Output: None
+	*/
+	void GpuTimer::Begin(const char* name)
+	{
+		Query query = { GetQuery(), 0, name };
+		glQueryCounter(query.begin, GL_TIMESTAMP);
+		open.push_back(query);
+	}
+
+	/* End ------------------------------------------------*/
+	/*
+		Marks the end of the innermost open pass.
+
+		Input: None
+		Output: None
+	*/
+	void GpuTimer::End()
+	{
+		if (open.empty()) return;
+
+		Query query = open.back();
+		open.pop_back();
+
+		query.end = GetQuery();
+		glQueryCounter(query.end, GL_TIMESTAMP);
+		pending.push_back(query);
+	}
+
+	/* Collect --------------------------------------------*/
+	/*
+		Reads back every pass the GPU has finished with and
+		hands the timings to the profiler. Passes finish in
+		the order they ended, so we stop at the first one
+		that isn't ready rather than wait for it.
+
+		Input: None
+		Output: None
+	*/
+	void GpuTimer::Collect()
+	{
+		SyncClocks();
+
+		while (!pending.empty())
+		{
+			Query& query = pending.front();
+
+			GLint available = 0;
+			glGetQueryObjectiv(query.end, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) break;
+
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end);
+			RecordProfileEvent(track, query.name, begin + clockOffset, end + clockOffset);
+			latest[query.name] = (end - begin) / 1e6;
+
+			freeQueries.push_back(query.begin);
+			freeQueries.push_back(query.end);
+			pending.pop_front();
+		}
+	}
+
+	/* TakeLatest -----------------------------------------*/
+	/*
+		Hands over the most recent time collected for a
+		pass, once. Until another one comes back, there's
+		nothing new to hand over.
+
+		Input: Pass name
+		Output: Milliseconds, or a negative number if
+				there's no new time
+	*/
+	double GpuTimer::TakeLatest(const char* name)
+	{
+		auto it = latest.find(name);
+		if (it == latest.end()) return -1.0;
+
+		double ms = it->second;
+		latest.erase(it);
+		return ms;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Query Functions									   */
+	/*-----------------------------------------------------*/
+	/* GetQuery -------------------------------------------*/
+	/*
+		Hands out a query object, reusing one if we can.
+	*/
+	GLuint GpuTimer::GetQuery()
+	{
+		GLuint id;
+
+		if (freeQueries.empty())
+		{
+			glGenQueries(1, &id);
+			return id;
+		}
+
+		id = freeQueries.back();
+		freeQueries.pop_back();
+		return id;
+	}
+
+	/* SyncClocks -----------------------------------------*/
+	/*
+		Works out how far the GPU's clock is from the one
+		the profiler uses. Reading the GPU's time this way
+		doesn't wait for it to finish anything.
+	*/
+	void GpuTimer::SyncClocks()
+	{
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		clockOffset = (int64_t)ProfileNow() - gpuNow;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor & Deconstructor						   */
+	/*-----------------------------------------------------*/
+	GpuTimer::GpuTimer()
+	{
+		this->track = CreateProfileTrack("GPU");
+		this->clockOffset = 0;
+	}
+
+	GpuTimer::~GpuTimer()
+	{
+		for (GLuint id : freeQueries) glDeleteQueries(1, &id);
+		for (Query& query : open) glDeleteQueries(1, &query.begin);
+		for (Query& query : pending)
+		{
+			glDeleteQueries(1, &query.begin);
+			glDeleteQueries(1, &query.end);
+		}
+	}
+}
\ No newline at end of file
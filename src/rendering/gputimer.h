@@ -0,0 +1,131 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glad/glad.h>
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* GPU Timer																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Macros																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		GPU_PROFILE_SCOPE(timer, "Name") times the GL commands issued in
+		the rest of the block, on the GPU. These nest just like
+		PROFILE_SCOPE.
+	*/
+#ifdef WINEDARK_PROFILING
+#define GPU_PROFILE_SCOPE(timer, name) Winedark::GpuScope PROFILE_CONCAT(gpuScope, __LINE__)(timer, name)
+#else
+#define GPU_PROFILE_SCOPE(timer, name)
+#endif
+
+	/*-----------------------------------------------------------------------*/
+	/* GPU Timer															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Times passes on the GPU without ever waiting for them. Each pass
+		gets a pair of GL_TIMESTAMP queries, one before and one after,
+		which go on a queue when the pass ends. We only read them back
+		once the GPU says they're ready, which in practice is a frame or
+		so later. Query objects are recycled, so after the first few
+		frames we're just alternating between the same couple of sets of
+		them.
+
+		We use timestamps rather than GL_TIME_ELAPSED because llvmpipe
+		reports next to nothing elapsed around a compute dispatch, while
+		its timestamps are right. They also let passes nest, and tell
+		us when each pass actually ran.
+
+		Finished timings go to the profiler on their own "GPU" track, so
+		they show up in the stats table and the Chrome trace next to the
+		CPU zones. To line the two up, we keep track of the difference
+		between the GPU's clock and ours.
+
+		We also hang on to the latest time for each pass, for anything
+		that wants to react to how long passes are taking (the renderer's
+		resolution controller, say).
+	*/
+	class GpuTimer
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Pending Query									   */
+		/*-----------------------------------------------------*/
+		struct Query
+		{
+			GLuint			begin;
+			GLuint			end;
+			const char*		name;
+		};
+
+		/*-----------------------------------------------------*/
+		/* Queries											   */
+		/*-----------------------------------------------------*/
+		std::vector<GLuint>	freeQueries;
+		std::vector<Query>	open;
+		std::deque<Query>	pending;
+
+		/*-----------------------------------------------------*/
+		/* Profiler											   */
+		/*-----------------------------------------------------*/
+		int					track;
+		int64_t				clockOffset;
+
+		/*-----------------------------------------------------*/
+		/* Latest Timings									   */
+		/*-----------------------------------------------------*/
+		std::unordered_map<std::string, double>	latest;
+
+		/*-----------------------------------------------------*/
+		/* Query Functions									   */
+		/*-----------------------------------------------------*/
+		GLuint				GetQuery();
+		void				SyncClocks();
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Timing Functions									   */
+		/*-----------------------------------------------------*/
+		void				Begin(const char* name);
+		void				End();
+		void				Collect();
+		double				TakeLatest(const char* name);
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		GpuTimer();
+		~GpuTimer();
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* GPU Scope															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Begins a query when made and ends it when it goes out of scope.
+		Use the GPU_PROFILE_SCOPE macro rather than this directly.
+	*/
+	class GpuScope
+	{
+	private:
+		GpuTimer*			timer;
+
+	public:
+		GpuScope(GpuTimer& timer, const char* name) { this->timer = &timer; timer.Begin(name); }
+		~GpuScope() { timer->End(); }
+	};
+}
+
+#endif
\ No newline at end of file
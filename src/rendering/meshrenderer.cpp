@@ -0,0 +1,426 @@
+#include "meshrenderer.h"
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Mesh Renderer																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Helper Functions														 */
+	/*-----------------------------------------------------------------------*/
+	/* IsBoxVisible -----------------------------------------*/
+	/*
+		A box is off screen if all eight of its corners are
+		outside the same side of the view.
+
+		Input: View projection & box
+		Output: Whether any of it might be on screen
+	*/
+	static bool IsBoxVisible(const glm::mat4& mvp, const Box& box)
+	{
+		glm::vec4 corners[8];
+		for (int i = 0; i < 8; i++)
+		{
+			glm::vec3 p = { (i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z };
+			corners[i] = mvp * glm::vec4(p, 1.0f);
+		}
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			bool below = true;
+			bool above = true;
+
+			for (int i = 0; i < 8; i++)
+			{
+				below = below && corners[i][axis] < -corners[i].w;
+				above = above && corners[i][axis] > corners[i].w;
+			}
+
+			if (below || above) return false;
+		}
+
+		return true;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Mesh Renderer														 */
+	/*-----------------------------------------------------------------------*/
+	/*-----------------------------------------------------*/
+	/* View Functions									   */
+	/*-----------------------------------------------------*/
+	/* GetView --------------------------------------------*/
+	/*
+		Takes the world onto the camera's plane the way the
+		tracer's rays leave it: right and up across the
+		screen, a voxel to a unit, and forward into it (which
+		is -z, looking down -z as the camera does).
+
+		Input: None
+		Output: View matrix
+	*/
+	glm::mat4 MeshRenderer::GetView()
+	{
+		Quaternion r = camera->GetRotation();
+		glm::vec3 right = Rotate({ 1.0f, 0.0f, 0.0f }, r);
+		glm::vec3 up = Rotate({ 0.0f, 1.0f, 0.0f }, r);
+		glm::vec3 forward = Rotate({ 0.0f, 0.0f, 1.0f }, r);
+		glm::vec3 p = camera->GetPosition();
+
+		glm::mat4 view(1.0f);
+		for (int i = 0; i < 3; i++)
+		{
+			view[i][0] = right[i];
+			view[i][1] = up[i];
+			view[i][2] = -forward[i];
+		}
+
+		view[3][0] = -glm::dot(right, p);
+		view[3][1] = -glm::dot(up, p);
+		view[3][2] = glm::dot(forward, p);
+		return view;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Dirty Functions									   */
+	/*-----------------------------------------------------*/
+	/* MarkDirty ------------------------------------------*/
+	/*
+		Marks every chunk an edit inside the boxes could have
+		changed the faces of.
+
+		Input: Edited boxes
+		Output: None
+	*/
+	void MeshRenderer::MarkDirty(const std::vector<Box>& boxes)
+	{
+		std::vector<unsigned int> touched;
+		FindChunks(boxes, chunksPerSide, touched);
+
+		for (unsigned int chunk : touched) chunks[chunk].dirty = true;
+	}
+
+	/* MarkAllDirty ---------------------------------------*/
+	/*
+		Marks every chunk, for when we don't know what's
+		changed (too many edits, a world loaded or edits we
+		weren't told about).
+
+		Input: None
+		Output: None
+	*/
+	void MeshRenderer::MarkAllDirty()
+	{
+		for (Chunk& chunk : chunks) chunk.dirty = true;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Chunk Functions									   */
+	/*-----------------------------------------------------*/
+	/* Submit ---------------------------------------------*/
+	/*
+		Reads a chunk out of the octree and sends it off to
+		be meshed. A chunk with nothing solid in it needs no
+		meshing, so it's emptied here and now.
+
+		Input: Chunk
+		Output: None
+	*/
+	void MeshRenderer::Submit(unsigned int index)
+	{
+		Chunk& chunk = chunks[index];
+		chunk.version++;
+		chunk.dirty = false;
+
+		glm::ivec3 origin = glm::ivec3(chunk.box.min);
+		if (!ReadChunk(octree->GetVoxels(), octree->GetSize(), origin, grid))
+		{
+			chunk.faces = 0;
+			return;
+		}
+
+		mesher.Submit(index, chunk.version, origin, std::move(grid));
+	}
+
+	/* Upload ---------------------------------------------*/
+	/*
+		Puts a finished mesh in its chunk's vertex buffer.
+
+		Input: Mesh
+		Output: None
+	*/
+	void MeshRenderer::Upload(ChunkMesh& mesh)
+	{
+		PROFILE_SCOPE("MeshRenderer::Upload");
+
+		Chunk& chunk = chunks[mesh.chunk];
+		chunk.faces = (unsigned int)(mesh.vertices.size() / 4);
+		this->stats.builds++;
+
+		if (chunk.faces == 0) return;
+		if (chunk.vbo == 0) glGenBuffers(1, &chunk.vbo);
+
+		glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+		glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex), mesh.vertices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		ReserveIndices(chunk.faces);
+	}
+
+	/* ReserveIndices -------------------------------------*/
+	/*
+		Every chunk's faces are drawn from the same indices
+		(two triangles per four vertices), so the index
+		buffer only has to be as big as the biggest chunk.
+		When one's bigger, it at least doubles.
+
+		Input: Faces to have indices for
+		Output: None
+	*/
+	void MeshRenderer::ReserveIndices(unsigned int faces)
+	{
+		if (faces <= indexCapacity) return;
+
+		this->indexCapacity = std::max(faces, 2 * indexCapacity);
+
+		std::vector<unsigned int> indices(6 * (size_t)indexCapacity);
+		for (unsigned int i = 0; i < indexCapacity; i++)
+		{
+			unsigned int v = 4 * i;
+			unsigned int quad[6] = { v, v + 1, v + 2, v, v + 2, v + 3 };
+			std::copy(quad, quad + 6, &indices[6 * (size_t)i]);
+		}
+
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+		glBindVertexArray(0);
+	}
+
+	/*-----------------------------------------------------*/
+	/* Rendering Functions								   */
+	/*-----------------------------------------------------*/
+	/* Update ---------------------------------------------*/
+	/*
+		Sends the dirty chunks off to be meshed and uploads
+		whichever meshes have come back, unless they've
+		since been overtaken.
+
+		Input: None
+		Output: None
+	*/
+	void MeshRenderer::Update()
+	{
+		PROFILE_SCOPE("MeshRenderer::Update");
+
+		for (unsigned int i = 0; i < chunks.size(); i++)
+		{
+			if (chunks[i].dirty) Submit(i);
+		}
+
+		meshes.clear();
+		mesher.TakeMeshes(meshes);
+
+		for (ChunkMesh& mesh : meshes)
+		{
+			if (mesh.version == chunks[mesh.chunk].version) Upload(mesh);
+		}
+		meshes.clear();
+
+		this->stats.chunks = 0;
+		this->stats.faces = 0;
+		this->stats.vertexBytes = 0;
+
+		for (Chunk& chunk : chunks)
+		{
+			if (chunk.faces == 0) continue;
+
+			this->stats.chunks++;
+			this->stats.faces += chunk.faces;
+			this->stats.vertexBytes += 4 * (size_t)chunk.faces * sizeof(Vertex);
+		}
+	}
+
+	/* Draw -----------------------------------------------*/
+	/*
+		Draws every chunk that might be on screen, over
+		whatever's there already. The depth buffer is ours
+		alone, so we clear it, and leave depth testing and
+		culling off again when we're done.
+
+		Input: None
+		Output: None
+	*/
+	void MeshRenderer::Draw()
+	{
+		PROFILE_SCOPE("MeshRenderer::Draw");
+
+		/*
+			The camera's projection, but reaching as far
+			behind its plane as in front of it: the tracer's
+			rays don't start at the camera, so a tilted view
+			sees the parts of the world behind it too.
+		*/
+		float halfWidth = (camera->GetWidth() / 2.0f) * camera->GetZoom();
+		float halfHeight = (camera->GetHeight() / 2.0f) * camera->GetZoom();
+		glm::mat4 projection = glm::ortho(-halfWidth, halfWidth, -halfHeight, halfHeight, -camera->GetFarClip(), camera->GetFarClip());
+
+		glm::mat4 view = GetView();
+		glm::mat4 mvp = projection * camera->GetView() * view;
+
+		/*
+			Faces wind counter-clockwise seen from outside in
+			the world, but the view can mirror them (right x
+			up is -forward, not forward), in which case the
+			front faces are the clockwise ones.
+		*/
+		glm::vec3 right = glm::vec3(view[0][0], view[1][0], view[2][0]);
+		glm::vec3 up = glm::vec3(view[0][1], view[1][1], view[2][1]);
+		glm::vec3 back = glm::vec3(view[0][2], view[1][2], view[2][2]);
+		bool mirrored = glm::dot(glm::cross(right, up), back) < 0.0f;
+
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
+		glEnable(GL_CULL_FACE);
+		glCullFace(GL_BACK);
+		glFrontFace(mirrored ? GL_CW : GL_CCW);
+
+		shader.Use();
+		SetMatrix(shader.GetID(), "mvp", mvp);
+		glBindVertexArray(vao);
+
+		this->stats.drawnChunks = 0;
+		this->stats.drawnFaces = 0;
+
+		for (Chunk& chunk : chunks)
+		{
+			if (chunk.faces == 0 || !IsBoxVisible(mvp, chunk.box)) continue;
+
+			glBindVertexBuffer(0, chunk.vbo, 0, sizeof(Vertex));
+			glDrawElements(GL_TRIANGLES, 6 * chunk.faces, GL_UNSIGNED_INT, nullptr);
+
+			this->stats.drawnChunks++;
+			this->stats.drawnFaces += chunk.faces;
+		}
+
+		glBindVertexArray(0);
+		glFrontFace(GL_CCW);
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_DEPTH_TEST);
+	}
+
+	/* IsBusy ---------------------------------------------*/
+	/*
+		Input: None
+		Output: Whether there are chunks still to mesh or
+				meshes still to upload
+	*/
+	bool MeshRenderer::IsBusy()
+	{
+		for (Chunk& chunk : chunks)
+		{
+			if (chunk.dirty) return true;
+		}
+
+		return mesher.GetPending() > 0;
+	}
+
+	/* Finish ---------------------------------------------*/
+	/*
+		Meshes and uploads every dirty chunk before it
+		returns, so the next Draw is up to date.
+
+		Input: None
+		Output: None
+	*/
+	void MeshRenderer::Finish()
+	{
+		PROFILE_SCOPE("MeshRenderer::Finish");
+
+		while (IsBusy())
+		{
+			Update();
+			mesher.Wait();
+		}
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor & Deconstructor						   */
+	/*-----------------------------------------------------*/
+	/* Constructor ----------------------------------------*/
+	/*
+		Splits the octree into chunks, all dirty, so the
+		first Update meshes the whole world.
+
+		Input: Camera, octree & how many threads to mesh on
+			   (0 for one fewer than there are cores)
+		Output: (Mesh Renderer)
+	*/
+	MeshRenderer::MeshRenderer(Camera* camera, Octree* octree, unsigned int threads) :
+		mesher(threads),
+		shader("assets/shaders/base.vert", "assets/shaders/mesh.frag")
+	{
+		this->camera = camera;
+		this->octree = octree;
+		this->indexCapacity = 0;
+		this->stats = { 0, 0, 0, 0, 0, 0 };
+
+		unsigned int size = octree->GetSize();
+		this->chunksPerSide = std::max(1u, (size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+
+		for (unsigned int z = 0; z < chunksPerSide; z++)
+		{
+			for (unsigned int y = 0; y < chunksPerSide; y++)
+			{
+				for (unsigned int x = 0; x < chunksPerSide; x++)
+				{
+					glm::vec3 min = glm::vec3(x, y, z) * (float)CHUNK_SIZE;
+					glm::vec3 max = glm::min(min + (float)CHUNK_SIZE, glm::vec3((float)size));
+					chunks.push_back({ 0, 0, 0, true, { min, max } });
+				}
+			}
+		}
+
+		/*
+			Vertices come from a different buffer for every
+			chunk, so the layout (a Vertex, as everywhere else)
+			is set once and each draw just binds its buffer.
+		*/
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+
+		glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, x));
+		glVertexAttribBinding(0, 0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribFormat(1, 4, GL_FLOAT, GL_FALSE, offsetof(Vertex, r));
+		glVertexAttribBinding(1, 0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, s));
+		glVertexAttribBinding(2, 0);
+		glEnableVertexAttribArray(2);
+
+		glGenBuffers(1, &ibo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+		glBindVertexArray(0);
+	}
+
+	/* Deconstructor --------------------------------------*/
+	MeshRenderer::~MeshRenderer()
+	{
+		for (Chunk& chunk : chunks)
+		{
+			if (chunk.vbo != 0) glDeleteBuffers(1, &chunk.vbo);
+		}
+
+		glDeleteBuffers(1, &ibo);
+		glDeleteVertexArrays(1, &vao);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#ifndef MESHRENDERER_H
+#define MESHRENDERER_H
+
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "camera.h"
+#include "shader.h"
+#include "../world/octree.h"
+#include "../world/mesher.h"
+#include "../util/geometry.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Mesh Renderer																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Mesh Stats															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		What the last Draw drew, and what's resident: chunks with
+		anything in them, their faces and the bytes of vertices on the
+		GPU. Builds is how many meshes have been uploaded since the
+		start.
+	*/
+	struct MeshStats
+	{
+		unsigned int		drawnChunks;
+		unsigned int		drawnFaces;
+		unsigned int		chunks;
+		unsigned int		faces;
+		size_t				vertexBytes;
+		unsigned long long	builds;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Mesh Renderer														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		The other way to draw the octree: rather than tracing a ray per
+		pixel, we mesh each chunk (see mesher.h) and rasterize the
+		faces, which costs the same however much of the world is on
+		screen and however it's zoomed. Flat sea is one big quad a slice
+		per chunk.
+
+		Every chunk has a vertex buffer of its own, so an edit only
+		means meshing and uploading the chunks it touched. The octree's
+		dirty boxes say which (a box grown by a voxel, since the faces
+		of the voxels next to an edit change too). Dirty chunks are read
+		on this thread and meshed on the ChunkMesher's workers, and
+		Update uploads whatever's finished. Until a chunk's new mesh
+		comes back, its old one is drawn. Each chunk counts its
+		versions, so if it's edited again before its mesh comes back
+		that mesh is dropped for the newer one.
+
+		The faces go through the same vertex pipeline as the rest of the
+		renderer: Vertex, base.vert and the camera's projection, with
+		the world mapped onto the camera's plane one voxel to a unit, as
+		the tracer does. Every face is four vertices and they share one
+		index buffer, so there's one draw per chunk, and chunks entirely
+		off screen are skipped.
+	*/
+	class MeshRenderer
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Chunk											   */
+		/*-----------------------------------------------------*/
+		struct Chunk
+		{
+			GLuint				vbo;
+			unsigned int		faces;
+			unsigned int		version;
+			bool				dirty;
+			Box					box;
+		};
+
+		/*-----------------------------------------------------*/
+		/* World											   */
+		/*-----------------------------------------------------*/
+		Camera*					camera;
+		Octree*					octree;
+
+		/*-----------------------------------------------------*/
+		/* Chunks											   */
+		/*-----------------------------------------------------*/
+		std::vector<Chunk>		chunks;
+		unsigned int			chunksPerSide;
+		ChunkMesher				mesher;
+		std::vector<ChunkMesh>	meshes;
+		std::vector<unsigned int>	grid;
+
+		/*-----------------------------------------------------*/
+		/* Buffers											   */
+		/*-----------------------------------------------------*/
+		GLuint					vao;
+		GLuint					ibo;
+		unsigned int			indexCapacity;
+
+		/*-----------------------------------------------------*/
+		/* Shader											   */
+		/*-----------------------------------------------------*/
+		Shader					shader;
+
+		/*-----------------------------------------------------*/
+		/* Stats											   */
+		/*-----------------------------------------------------*/
+		MeshStats				stats;
+
+		/*-----------------------------------------------------*/
+		/* Chunk Functions									   */
+		/*-----------------------------------------------------*/
+		void					Submit(unsigned int chunk);
+		void					Upload(ChunkMesh& mesh);
+		void					ReserveIndices(unsigned int faces);
+
+	public:
+		/*-----------------------------------------------------*/
+		/* View Functions									   */
+		/*-----------------------------------------------------*/
+		glm::mat4				GetView();
+
+		/*-----------------------------------------------------*/
+		/* Dirty Functions									   */
+		/*-----------------------------------------------------*/
+		void					MarkDirty(const std::vector<Box>& boxes);
+		void					MarkAllDirty();
+
+		/*-----------------------------------------------------*/
+		/* Rendering Functions								   */
+		/*-----------------------------------------------------*/
+		void					Update();
+		void					Draw();
+		bool					IsBusy();
+		void					Finish();
+
+		/*-----------------------------------------------------*/
+		/* Stat Functions									   */
+		/*-----------------------------------------------------*/
+		MeshStats				GetStats() { return stats; }
+		unsigned int			GetThreadCount() { return mesher.GetThreadCount(); }
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		MeshRenderer(Camera* camera, Octree* octree, unsigned int threads = 0);
+		~MeshRenderer();
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "octreebuffer.h"
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Octree Buffer																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*---------------------------------------------------*/
+	/* General Functions								 */
+	/*---------------------------------------------------*/
+	/* Update -------------------------------------------*/
+	/*
+		Update checks if the octree has been updated and,
+		if so, writes it to the buffer.
+	*/
+	void OctreeBuffer::Update()
+	{
+		PROFILE_SCOPE("OctreeBuffer::Update");
+
+		if (octree->CheckUpdated()) WriteBuffer();
+	}
+
+	/*---------------------------------------------------*/
+	/* Buffer Functions									 */
+	/*---------------------------------------------------*/
+	/* WriteBuffer --------------------------------------*/
+	/*
+		WriteBuffer writes the current voxel data to the
+		SSBO on the GPU. That's all that's in it; the
+		camera and the like are per view, so each renderer
+		keeps those in its own buffer.
+
+		The allocator goes up with it, so edits made on
+		the GPU carry on from where ours left off.
+	*/
+	void OctreeBuffer::WriteBuffer()
+	{
+		PROFILE_SCOPE("OctreeBuffer::WriteBuffer");
+
+		if (ssbo == 0) CreateBuffer();
+
+		Voxel* voxels = octree->GetVoxels();
+		const std::vector<unsigned int>& freeBlocks = octree->GetFreeBlocks();
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, octree->GetCapacity() * sizeof(Voxel), voxels);
+
+		unsigned int allocator[2] = { octree->GetCursor(), (unsigned int)freeBlocks.size() };
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, allocatorSsbo);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(allocator), allocator);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(allocator), freeBlocks.size() * sizeof(unsigned int), freeBlocks.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	/* CreateBuffer -------------------------------------*/
+	/*
+		CreateBuffer sets up the SSBOs the first time we
+		need them, and tells the octree that from now on
+		there's a copy on the GPU for edits to be applied
+		to.
+
+		The allocator's buffer is the cursor and the size
+		of the free list, then room for every block on it.
+	*/
+	void OctreeBuffer::CreateBuffer()
+	{
+		GLsizeiptr nVoxels = octree->GetCapacity();
+
+		glGenBuffers(1, &ssbo);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, nVoxels * sizeof(Voxel), nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, ssbo);
+
+		glGenBuffers(1, &allocatorSsbo);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, allocatorSsbo);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, (2 + nVoxels / 8) * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		octree->SetBuffered(true);
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor & Deconstructor						   */
+	/*-----------------------------------------------------*/
+	OctreeBuffer::OctreeBuffer(Octree* octree)
+	{
+		this->octree = octree;
+		this->ssbo = 0;
+		this->allocatorSsbo = 0;
+	}
+
+	OctreeBuffer::~OctreeBuffer()
+	{
+		if (ssbo == 0) return;
+
+		octree->SetBuffered(false);
+		glDeleteBuffers(1, &ssbo);
+		glDeleteBuffers(1, &allocatorSsbo);
+	}
+}
\ No newline at end of file
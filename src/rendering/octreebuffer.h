@@ -0,0 +1,69 @@
+#ifndef OCTREEBUFFER_H
+#define OCTREEBUFFER_H
+
+#include <glad/glad.h>
+
+#include "../world/octree.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Octree Buffer																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Octree Buffer														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		The octree's copy on the GPU: its voxels in one SSBO and its
+		allocator (the cursor, then the free list) in another, for the
+		tracer to read and the VoxelEditor to edit. The octree itself
+		knows nothing about GL, so it can be built, edited and saved
+		where there isn't any (see winedark_core); this is all there is
+		of it on the GPU.
+
+		Call Update once a frame, before the VoxelEditor applies its
+		edits and before anything traces. Whenever the octree has been
+		changed on the CPU, that writes all of it again. The buffers are
+		made the first time there's something to write, and until then
+		the octree makes GPU edits itself.
+	*/
+	class OctreeBuffer
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Octree											   */
+		/*-----------------------------------------------------*/
+		Octree*					octree;
+
+		/*-----------------------------------------------------*/
+		/* Buffers											   */
+		/*-----------------------------------------------------*/
+		GLuint					ssbo;
+		GLuint					allocatorSsbo;
+
+		/*-----------------------------------------------------*/
+		/* Buffer Functions									   */
+		/*-----------------------------------------------------*/
+		void					WriteBuffer();
+		void					CreateBuffer();
+
+	public:
+		/*-----------------------------------------------------*/
+		/* General Functions								   */
+		/*-----------------------------------------------------*/
+		void					Update();
+		Octree*					GetOctree() { return octree; }
+		GLuint					GetSSBO() { return ssbo; }
+		GLuint					GetAllocatorSSBO() { return allocatorSsbo; }
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		OctreeBuffer(Octree* octree);
+		~OctreeBuffer();
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,7 +1,14 @@
 #include "renderer.h"
 
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
 #include <iostream>
 
+#include "../util/profiler.h"
+#include "../world/traversal.h"
+
 namespace Winedark
 {
 	/*----------------------------------------------------------------------------------------------*/
@@ -9,59 +16,1596 @@ namespace Winedark
 	/* Rendering																					*/
 	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
 	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Utility Functions													 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		The defines that set the compute shader's workgroup size, and
+		whether it's the instrumentation build.
+	*/
+	std::vector<std::string> ComputeDefines(unsigned int x, unsigned int y, bool instrument)
+	{
+		std::vector<std::string> defines = { "LOCAL_SIZE_X " + std::to_string(x), "LOCAL_SIZE_Y " + std::to_string(y) };
+		if (instrument) defines.push_back("INSTRUMENT");
+		return defines;
+	}
+
+	/*
+		The render scale goes from MIN_RENDER_SCALE to 1 in steps
+		of 1 / RENDER_SCALE_STEPS.
+	*/
+	const float MIN_RENDER_SCALE = 0.25f;
+	const float RENDER_SCALE_STEPS = 8.0f;
+
+	/*
+		How many slots the frame data ring has. Three is enough for
+		the driver to be a couple of frames behind us.
+	*/
+	const unsigned int FRAME_SLOTS = 3;
+
+	/*
+		How many secondary views we can have. This must match
+		MAX_VIEWS in base.comp.
+	*/
+	const unsigned int MAX_VIEWS = 8;
+
+	/*
+		How far the camera can drift along the view while
+		panning before the trace has to start over. Depths are
+		kept to a sixteenth of a voxel, so this is well under
+		one step of those.
+	*/
+	const float PAN_TOLERANCE = 1e-3f;
+
+	/*
+		The BufferData for a camera looking at an octree of the
+		given size.
+	*/
+	BufferData MakeBufferData(Camera* camera, unsigned int size)
+	{
+		Quaternion r = camera->GetRotation();
+		glm::vec3 right = Rotate({ 1.0, 0.0,0.0 }, r);
+		glm::vec3 up = Rotate({ 0.0, 1.0,0.0 }, r);
+		glm::vec3 forward = Rotate({ 0.0, 0.0, 1.0 }, r);
+
+		return { size, camera->GetWidth(), camera->GetHeight(), 0,
+					glm::vec4(camera->GetPosition(), 0),
+					glm::vec4(right, 0),
+					glm::vec4(up, 0),
+					glm::vec4(forward, 0),
+					glm::vec4(glm::vec3(size * 0.5f), 0) };
+	}
+
+	/*
+		The order progressive refinement visits the pixels of each
+		4 x 4 block in, as (x, y, fill). It's the order of a 4 x 4
+		Bayer matrix, so every pass is spread evenly over the block.
+		The first pass fills the whole block, the next three a 2 x 2
+		quarter each, and the rest just their own pixel.
+	*/
+	const unsigned int REFINE_PHASES = 16;
+	const int REFINE_ORDER[REFINE_PHASES][3] =
+	{
+		{ 0, 0, 4 }, { 2, 2, 2 }, { 2, 0, 2 }, { 0, 2, 2 },
+		{ 1, 1, 1 }, { 3, 3, 1 }, { 3, 1, 1 }, { 1, 3, 1 },
+		{ 1, 0, 1 }, { 3, 2, 1 }, { 3, 0, 1 }, { 1, 2, 1 },
+		{ 0, 1, 1 }, { 2, 3, 1 }, { 2, 1, 1 }, { 0, 3, 1 }
+	};
+
 	/*-----------------------------------------------------------------------*/
 	/* Renderer																 */
 	/*-----------------------------------------------------------------------*/
 	/*-------------------------------------------------------*/
-	/* Rendering Functions									 */
+	/* Rendering Functions									 */
+	/*-------------------------------------------------------*/
+	void Renderer::Render()
+	{
+		PROFILE_SCOPE("Renderer::Render");
+
+		/*
+			Whatever GPU timings have come back since last
+			frame go to the profiler.
+		*/
+		gpuTimer.Collect();
+		UpdateRenderScale();
+		this->redrawRequested = false;
+
+		/*
+			Edits come with the boxes they touched, so we only
+			need to re-trace the pixels that can see those.
+			When there were too many to keep track of, nothing
+			we traced before can be trusted.
+		*/
+		bool cameraChanged = camera->CheckChanged();
+		bool octreeChanged = octree->CheckChanged();
+		bool meshed = (backend == Backend::Mesh);
+
+		if (octreeChanged && meshed)
+		{
+			std::vector<Box> boxes;
+			if (octree->TakeDirtyBoxes(boxes)) meshRenderer->MarkDirty(boxes);
+			else meshRenderer->MarkAllDirty();
+		}
+		else if (octreeChanged && !octree->TakeDirtyBoxes(dirtyBoxes)) traceValid = false;
+
+		if (meshed) meshRenderer->Update();
+
+		/*
+			Then each pass says what it reads and writes, and
+			the graph puts in whatever barriers that takes. The
+			octree's buffer isn't made until it's first
+			written, so we keep its import up to date.
+		*/
+		graph.SetImport(voxelResource, buffer->GetSSBO());
+
+		if (!meshed && (cameraChanged || !traceValid || !dirtyBoxes.empty() || IsRefining() || instrumented))
+		{
+			std::vector<Use> uses = { { octreeResource, Access::ImageWrite }, { voxelResource, Access::StorageRead } };
+			if (instrumented)
+			{
+				this->costSlot = (costSlot + 1) % FRAME_SLOTS;
+				graph.SetImport(costBufferResource, costBuffers[costSlot]);
+
+				uses.push_back({ costImageResource, Access::ImageWrite });
+				uses.push_back({ costBufferResource, Access::Transfer });
+				uses.push_back({ costBufferResource, Access::StorageWrite });
+			}
+
+			graph.AddPass("Trace Pass", uses, [this, cameraChanged]() { TraceScene(cameraChanged); });
+		}
+
+		if (CollectViews(octreeChanged))
+		{
+			graph.AddPass("View Pass",
+				{ { viewResource, Access::ImageWrite }, { voxelResource, Access::StorageRead } },
+				[this]() { TraceViews(); });
+		}
+
+		std::vector<Use> drawUses = { { viewResource, Access::Sampled }, { screenResource, Access::RenderTarget } };
+		if (!meshed) drawUses.push_back({ octreeResource, Access::Sampled });
+		if (!meshed && heatmap != Heatmap::None) drawUses.push_back({ costImageResource, Access::Sampled });
+
+		graph.AddPass("Draw Pass", drawUses, [this]() { Draw(); });
+
+		graph.Execute(gpuTimer);
+	}
+
+	/* IsUpdateNeeded ---------------------------------------*/
+	/*
+		Tells us whether the next Render would show anything
+		different from the last: the camera or the octree
+		has changed, there's tracing left to do, a view is
+		waiting to be traced, or someone's asked for a
+		redraw (the window was uncovered, say). When it
+		wouldn't, the caller can skip the frame altogether.
+		With the mesh backend, there's tracing left to do
+		if there are chunks still being meshed.
+
+		Instrumented frames always retrace, so the counts
+		stay live.
+
+		This only looks. Unlike the old IsUpdateNeeded, it
+		doesn't clear the camera's or the octree's changed
+		flags (Render takes those), so it can be asked any
+		number of times a frame.
+
+		Input: None
+		Output: Whether to render
+	*/
+	bool Renderer::IsUpdateNeeded()
+	{
+		if (redrawRequested || camera->IsChanged() || octree->IsChanged()) return true;
+
+		if (backend == Backend::Mesh)
+		{
+			if (meshRenderer->IsBusy()) return true;
+		}
+		else if (!traceValid || !dirtyBoxes.empty() || IsRefining() || instrumented) return true;
+
+		for (View& view : views)
+		{
+			if (view.dirty || view.camera->IsChanged()) return true;
+		}
+
+		return false;
+	}
+
+	/* TraceScene -------------------------------------------*/
+	/*
+		Brings the main view's image up to date, tracing as
+		little of it as we can get away with.
+
+		Input: Whether the camera changed this frame
+		Output: None
+	*/
+	void Renderer::TraceScene(bool cameraChanged)
+	{
+		bool restarted = false;
+		bool refining = IsRefining();
+
+		if (instrumented) ReadTraversalCounters();
+
+		if (cameraChanged || !traceValid || !dirtyBoxes.empty() || instrumented)
+		{
+			/*
+				If the camera has only panned, we trace the
+				strips it's uncovered. Otherwise it's the
+				whole view. Half-refined pixels can't be
+				panned, since the ring would shuffle which
+				ones are still to do, so moving the camera
+				mid-refinement starts it over.
+
+				Instrumented, we always trace the whole view
+				in one go, so every pixel's counts are from
+				this frame.
+			*/
+			restarted = !traceValid || instrumented || (cameraChanged && (refining || !reprojection || !Reproject()));
+			if (restarted) ResetReprojection();
+
+			/*
+				The frame data goes after, since where the rays
+				start from depends on which it was.
+			*/
+			{
+				GPU_PROFILE_SCOPE(gpuTimer, "GPU Upload");
+				WriteFrameData();
+			}
+
+			if (restarted)
+			{
+				if (progressive && !instrumented) StartRefinement();
+				else Trace(beamOptimization);
+			}
+			else
+			{
+				TraceStrips();
+				TraceDirtyBoxes();
+			}
+
+			dirtyBoxes.clear();
+		}
+
+		if (progressive && !restarted) Refine();
+		if (instrumented) this->costFences[costSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	/* Draw -------------------------------------------------*/
+	/*
+		Draws the main view, then the secondary views over
+		it.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::Draw()
+	{
+		if (backend == Backend::Mesh)
+		{
+			meshRenderer->Draw();
+			DrawViews();
+			return;
+		}
+
+		glActiveTexture(GL_TEXTURE0);
+
+		if (heatmap != Heatmap::None)
+		{
+			glBindTexture(GL_TEXTURE_2D, costTexture);
+
+			heatmapShader.Use();
+			SetMatrix(heatmapShader.GetID(), "mvp", camera->GetViewProjection());
+			SetInt(heatmapShader.GetID(), "channel", (int)heatmap);
+			SetFloat(heatmapShader.GetID(), "scale", GetHeatmapScale());
+		}
+		else
+		{
+			glBindTexture(GL_TEXTURE_2D, octreeTexture);
+
+			sceneShader.Use();
+			SetMatrix(sceneShader.GetID(), "mvp", camera->GetViewProjection());
+		}
+
+		/*
+			The quad only changes when the ring moves or the
+			render scale does, so most frames there's nothing
+			to upload.
+		*/
+		glBindVertexArray(vao);
+		if (UpdateScreenQuad() || screenQuadDirty)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, vbo);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Quad), &screenQuad);
+			this->screenQuadDirty = false;
+		}
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+
+		DrawViews();
+	}
+
+	/*-------------------------------------------------------*/
+	/* Frame Data Functions									 */
+	/*-------------------------------------------------------*/
+	/* WriteFrameData ---------------------------------------*/
+	/*
+		Writes the camera and the like into the next slot of
+		the frame data ring, which the compute shader reads
+		from then on.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::WriteFrameData()
+	{
+		PROFILE_SCOPE("Renderer::WriteFrameData");
+
+		/*
+			The rays start from where the camera was when the
+			trace last started over, plus however many whole
+			pixels it has panned since (gridShift), rather than
+			from where it is now. So a pixel's ray is the very
+			same whichever frame traces it, and strips line up
+			with what's already in the ring bit for bit.
+		*/
+		BufferData bd = MakeBufferData(camera, octree->GetSize());
+		if (traceValid) bd.cameraPosition = glm::vec4(traceOrigin, 0);
+
+		this->frameSlot = (frameSlot + 1) % FRAME_SLOTS;
+
+		glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, frameSlot * frameStride, sizeof(BufferData), &bd);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	/*-------------------------------------------------------*/
+	/* Tracing Functions									 */
+	/*-------------------------------------------------------*/
+	/* UseComputeShader -------------------------------------*/
+	/*
+		Binds the compute shader, our images, our frame data
+		slot and the octree, and sets the uniforms every
+		dispatch of the shader shares. We bind these every
+		time rather than once since another renderer may
+		have bound its own.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::UseComputeShader()
+	{
+		GLuint id = computeShader.GetID();
+
+		computeShader.Use();
+		glBindBufferRange(GL_UNIFORM_BUFFER, 0, frameBuffer, frameSlot * frameStride, sizeof(BufferData));
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, buffer->GetSSBO());
+		glBindImageTexture(0, octreeTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+		glBindImageTexture(1, beamTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+		glBindImageTexture(2, viewAtlas, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+
+		if (instrumented)
+		{
+			glBindImageTexture(3, costTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32UI);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, costBuffers[costSlot]);
+		}
+
+		SetBool(id, "countSteps", countSteps);
+		SetUint(id, "beamTile", beamTile);
+		glUniform2i(glGetUniformLocation(id, "ringOffset"), ringOffset.x, ringOffset.y);
+		glUniform2i(glGetUniformLocation(id, "gridShift"), traceValid ? traceShift.x : 0, traceValid ? traceShift.y : 0);
+		glUniform1f(glGetUniformLocation(id, "pixelSize"), 1.0f / renderScale);
+		SetBool(id, "progressive", false);
+		SetBool(id, "viewPass", false);
+	}
+
+	/* Trace ------------------------------------------------*/
+	/*
+		Runs the compute shader over the whole view. With the
+		beam optimization, the coarse pass goes first and we
+		wait for its start distances to land in the beam
+		texture before the full pass reads them.
+
+		Input: Whether to run the coarse beam pass
+		Output: None
+	*/
+	void Renderer::Trace(bool beam)
+	{
+		PROFILE_SCOPE("Renderer::Trace");
+
+		unsigned int width = renderWidth;
+		unsigned int height = renderHeight;
+
+		UseComputeShader();
+		SetBool(computeShader.GetID(), "useBeam", beam);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->GetSSBO());
+
+		/*
+			We round the number of workgroups up, and the
+			shader skips the invocations that land outside
+			the image.
+		*/
+		if (beam)
+		{
+			GPU_PROFILE_SCOPE(gpuTimer, "GPU Beam");
+
+			unsigned int tilesX = (width + beamTile - 1) / beamTile;
+			unsigned int tilesY = (height + beamTile - 1) / beamTile;
+
+			SetBool(computeShader.GetID(), "beamPass", true);
+			glDispatchCompute((tilesX + localSizeX - 1) / localSizeX, (tilesY + localSizeY - 1) / localSizeY, 1);
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		}
+
+		/*
+			This one is timed even without profiling, since
+			the resolution controller goes by it.
+		*/
+		{
+			GpuScope traceScope(gpuTimer, "GPU Trace");
+
+			SetBool(computeShader.GetID(), "beamPass", false);
+			TraceRegion(0, 0, width, height);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	/* TraceRegion ------------------------------------------*/
+	/*
+		Dispatches the full-resolution pass over a rectangle
+		of the view. The compute shader has to be in use
+		with its uniforms set.
+
+		Input: Corner, width & height of the rectangle
+		Output: None
+	*/
+	void Renderer::TraceRegion(int x, int y, unsigned int width, unsigned int height)
+	{
+		if (width == 0 || height == 0) return;
+
+		glUniform2i(glGetUniformLocation(computeShader.GetID(), "regionOrigin"), x, y);
+		glUniform2i(glGetUniformLocation(computeShader.GetID(), "regionSize"), width, height);
+		glDispatchCompute((width + localSizeX - 1) / localSizeX, (height + localSizeY - 1) / localSizeY, 1);
+	}
+
+	/* TraceDirtyBoxes --------------------------------------*/
+	/*
+		Re-traces the pixels whose rays pass through any of
+		the dirty boxes. A ray's hit can only change if the
+		ray goes through a voxel that changed, so that's all
+		of them.
+
+		We project each box's corners onto the camera's right
+		and up axes, the same way the compute shader places
+		a pixel's ray, and trace the rectangle of pixels
+		they cover (plus one to spare for rounding).
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::TraceDirtyBoxes()
+	{
+		if (dirtyBoxes.empty()) return;
+
+		PROFILE_SCOPE("Renderer::TraceDirtyBoxes");
+		GPU_PROFILE_SCOPE(gpuTimer, "GPU Trace Dirty");
+
+		Quaternion r = camera->GetRotation();
+		glm::vec3 right = Rotate({ 1.0f, 0.0f, 0.0f }, r);
+		glm::vec3 up = Rotate({ 0.0f, 1.0f, 0.0f }, r);
+		glm::vec3 position = camera->GetPosition();
+
+		int width = renderWidth;
+		int height = renderHeight;
+		glm::vec2 center = glm::vec2(camera->GetWidth() * 0.5f, camera->GetHeight() * 0.5f) * renderScale + subPixel - 0.5f;
+
+		UseComputeShader();
+		SetBool(computeShader.GetID(), "useBeam", false);
+		SetBool(computeShader.GetID(), "beamPass", false);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->GetSSBO());
+
+		for (Box& box : dirtyBoxes)
+		{
+			glm::vec2 lo = glm::vec2(1e30f);
+			glm::vec2 hi = glm::vec2(-1e30f);
+
+			for (int i = 0; i < 8; i++)
+			{
+				glm::vec3 corner = { (i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z };
+				glm::vec2 pixel = glm::vec2(glm::dot(corner - position, right), glm::dot(corner - position, up)) * renderScale + center;
+
+				lo = glm::min(lo, pixel);
+				hi = glm::max(hi, pixel);
+			}
+
+			int x0 = std::max((int)std::floor(lo.x) - 1, 0);
+			int y0 = std::max((int)std::floor(lo.y) - 1, 0);
+			int x1 = std::min((int)std::ceil(hi.x) + 1, width - 1);
+			int y1 = std::min((int)std::ceil(hi.y) + 1, height - 1);
+
+			if (x1 >= x0 && y1 >= y0) TraceRegion(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+		}
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	/* ReadImage --------------------------------------------*/
+	/*
+		Reads the traced image back from the GPU. This stalls
+		until the compute shader is done, so it's only for
+		checking the output, never for the frame loop.
+
+		Input: Vector to fill with packed pixels
+		Output: None
+	*/
+	void Renderer::ReadImage(std::vector<unsigned int>& pixels)
+	{
+		pixels.resize(renderWidth * renderHeight);
+
+		glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+		glBindTexture(GL_TEXTURE_2D, octreeTexture);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, pixels.data());
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	/* TimeTrace --------------------------------------------*/
+	/*
+		Traces the whole view n times, waiting for the GPU to
+		finish each time, and returns the average time taken.
+
+		Input: Number of traces
+		Output: Milliseconds per trace
+	*/
+	float Renderer::TimeTrace(unsigned int n)
+	{
+		WriteFrameData();
+
+		Trace(beamOptimization);
+		glFinish();
+
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < n; i++)
+		{
+			Trace(beamOptimization);
+			glFinish();
+		}
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		return elapsed.count() / n;
+	}
+
+	/*-------------------------------------------------------*/
+	/* Reprojection Functions								 */
+	/*-------------------------------------------------------*/
+	/* SetReprojection --------------------------------------*/
+	/*
+		Turns reprojection on or off. Either way the next
+		frame traces the whole view, and with it off the
+		ring goes back to starting at (0, 0).
+
+		Input: Whether to reproject
+		Output: None
+	*/
+	void Renderer::SetReprojection(bool reprojection)
+	{
+		this->reprojection = reprojection;
+		this->traceValid = false;
+	}
+
+	/* ValidateReprojection ---------------------------------*/
+	/*
+		Traces the whole view afresh, on the same grid and
+		into the same ring, and compares it with what we had
+		built up from strips and dirty boxes. The two must be
+		identical.
+
+		Input: None
+		Output: Number of pixels that differ
+	*/
+	unsigned int Renderer::ValidateReprojection()
+	{
+		std::vector<unsigned int> a, b;
+
+		ReadImage(a);
+		WriteFrameData();
+		Trace(false);
+		ReadImage(b);
+
+		unsigned int mismatches = 0;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (a[i] != b[i]) mismatches++;
+		}
+
+		return mismatches;
+	}
+
+	/* ResetReprojection ------------------------------------*/
+	/*
+		Makes the camera's current position and rotation the
+		ones the next full trace is done from. The ring can
+		stay where it is, since the trace fills all of it.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::ResetReprojection()
+	{
+		this->traceValid = true;
+		this->traceOrigin = camera->GetPosition();
+		this->traceRotation = camera->GetRotation();
+		this->traceShift = { 0, 0 };
+		this->subPixel = { 0.0f, 0.0f };
+		this->panStep = { 0, 0 };
+
+		if (!reprojection) ringOffset = { 0, 0 };
+	}
+
+	/* Reproject --------------------------------------------*/
+	/*
+		Works out how many whole pixels the camera has panned
+		since the last frame and moves the ring by that much.
+		TraceStrips then traces the strips that have come
+		into view.
+
+		Only a move along the right and up axes can be
+		reprojected. Moving along the view direction changes
+		every pixel's depth (and, inside the world, what's in
+		front of the camera), and turning or panning a whole
+		view's width or more changes everything, so in those
+		cases we leave it to a full trace. Panning alone
+		still leaves a trace of float error along the view,
+		far below what a depth can tell apart, which we let
+		go.
+
+		Input: None
+		Output: Whether we could reproject
+	*/
+	bool Renderer::Reproject()
+	{
+		Quaternion r = camera->GetRotation();
+		if (r.w != traceRotation.w || r.x != traceRotation.x || r.y != traceRotation.y || r.z != traceRotation.z) return false;
+
+		glm::ivec2 view = { (int)renderWidth, (int)renderHeight };
+		glm::vec3 d = camera->GetPosition() - traceOrigin;
+		if (std::abs(glm::dot(d, Rotate({ 0.0f, 0.0f, 1.0f }, r))) > PAN_TOLERANCE) return false;
+
+		glm::vec2 pan = glm::vec2(glm::dot(d, Rotate({ 1.0f, 0.0f, 0.0f }, r)), glm::dot(d, Rotate({ 0.0f, 1.0f, 0.0f }, r))) * renderScale;
+
+		glm::ivec2 shift = { (int)std::lround(pan.x), (int)std::lround(pan.y) };
+		glm::ivec2 step = shift - traceShift;
+		if (abs(step.x) >= view.x || abs(step.y) >= view.y) return false;
+
+		this->traceShift = shift;
+		this->subPixel = pan - glm::vec2(shift);
+		this->ringOffset = { (ringOffset.x + step.x + view.x) % view.x, (ringOffset.y + step.y + view.y) % view.y };
+		this->panStep = step;
+
+		return true;
+	}
+
+	/* TraceStrips ------------------------------------------*/
+	/*
+		Traces the strips the last Reproject uncovered.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::TraceStrips()
+	{
+		glm::ivec2 view = { (int)renderWidth, (int)renderHeight };
+		glm::ivec2 step = panStep;
+
+		this->panStep = { 0, 0 };
+		if (step.x == 0 && step.y == 0) return;
+
+		PROFILE_SCOPE("Renderer::TraceStrips");
+		GPU_PROFILE_SCOPE(gpuTimer, "GPU Trace Strips");
+
+		UseComputeShader();
+		SetBool(computeShader.GetID(), "useBeam", false);
+		SetBool(computeShader.GetID(), "beamPass", false);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->GetSSBO());
+
+		/*
+			Panning right uncovers columns on the right, and
+			left on the left; likewise up and down. The rows
+			skip the columns we've just done.
+		*/
+		unsigned int columns = abs(step.x);
+		unsigned int rows = abs(step.y);
+
+		TraceRegion((step.x > 0) ? view.x - step.x : 0, 0, columns, view.y);
+		TraceRegion((step.x > 0) ? 0 : columns, (step.y > 0) ? view.y - step.y : 0, view.x - columns, rows);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	/* UpdateScreenQuad -------------------------------------*/
+	/*
+		Points the screen quad's texture coordinates at
+		wherever view pixel (0, 0) is in the ring. The far
+		edges run off the end of the texture and wrap back
+		around (GL_REPEAT).
+
+		Below full resolution the image is rounded up to
+		whole pixels, so it can be a touch wider than the
+		view, and the quad stops short of its far edge.
+
+		Input: None
+		Output: Whether any coordinates changed
+	*/
+	bool Renderer::UpdateScreenQuad()
+	{
+		float s = (float)ringOffset.x / renderWidth;
+		float t = (float)ringOffset.y / renderHeight;
+		float sMax = camera->GetWidth() * renderScale / renderWidth;
+		float tMax = camera->GetHeight() * renderScale / renderHeight;
+		bool changed = false;
+
+		Vertex* vertices = &screenQuad.a.a;
+		for (int i = 0; i < 6; i++)
+		{
+			float vs = ((vertices[i].x > 0.0f) ? sMax : 0.0f) + s;
+			float vt = ((vertices[i].y > 0.0f) ? tMax : 0.0f) + t;
+
+			if (vs != vertices[i].s || vt != vertices[i].t) changed = true;
+			vertices[i].s = vs;
+			vertices[i].t = vt;
+		}
+
+		return changed;
+	}
+
+	/*-------------------------------------------------------*/
+	/* Progressive Refinement Functions						 */
+	/*-------------------------------------------------------*/
+	/* SetProgressive ---------------------------------------*/
+	/*
+		Turns progressive refinement on or off. Either way,
+		the next frame starts over.
+
+		Input: Whether to refine progressively
+		Output: None
+	*/
+	void Renderer::SetProgressive(bool progressive)
+	{
+		this->progressive = progressive;
+		this->traceValid = false;
+		this->refinePhase = REFINE_PHASES;
+	}
+
+	/* IsRefining -------------------------------------------*/
+	/*
+		Input: None
+		Output: Whether there are still pixels to refine
+	*/
+	bool Renderer::IsRefining()
+	{
+		return progressive && refinePhase < REFINE_PHASES;
+	}
+
+	/* StartRefinement --------------------------------------*/
+	/*
+		Traces one pixel in every 4 x 4 block and fills the
+		block with it, so there's a rough picture of the
+		whole view for a sixteenth of the work.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::StartRefinement()
+	{
+		PROFILE_SCOPE("Renderer::StartRefinement");
+		GPU_PROFILE_SCOPE(gpuTimer, "GPU Trace Coarse");
+
+		UseComputeShader();
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->GetSSBO());
+
+		TracePhase(0, 0, (renderHeight + 3) / 4);
+		this->refinePhase = 1;
+		this->refineRow = 0;
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	/* Refine -----------------------------------------------*/
+	/*
+		Carries on filling in the view, tracing at most about
+		refineBudget more pixels. We go a phase at a time and
+		a row of blocks at a time within each, always at least
+		one row so we finish eventually.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::Refine()
+	{
+		if (refinePhase >= REFINE_PHASES) return;
+
+		PROFILE_SCOPE("Renderer::Refine");
+		GPU_PROFILE_SCOPE(gpuTimer, "GPU Refine");
+
+		unsigned int blocksX = (renderWidth + 3) / 4;
+		unsigned int blocksY = (renderHeight + 3) / 4;
+		unsigned int budget = refineBudget;
+
+		UseComputeShader();
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->GetSSBO());
+
+		while (refinePhase < REFINE_PHASES && budget > 0)
+		{
+			unsigned int rows = std::min(blocksY - refineRow, std::max(1u, budget / blocksX));
+			TracePhase(refinePhase, refineRow, rows);
+
+			budget -= std::min(budget, rows * blocksX);
+			refineRow += rows;
+
+			if (refineRow == blocksY)
+			{
+				refinePhase++;
+				refineRow = 0;
+			}
+		}
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	/* TracePhase -------------------------------------------*/
+	/*
+		Traces one phase's pixel in each block of a run of
+		rows of blocks. The compute shader has to be in use
+		with its uniforms set.
+
+		Input: Phase, first row of blocks & number of rows
+		Output: None
+	*/
+	void Renderer::TracePhase(unsigned int phase, unsigned int row, unsigned int rows)
+	{
+		GLuint id = computeShader.GetID();
+
+		SetBool(id, "useBeam", false);
+		SetBool(id, "beamPass", false);
+		SetBool(id, "progressive", true);
+		glUniform2i(glGetUniformLocation(id, "phaseOffset"), REFINE_ORDER[phase][0], REFINE_ORDER[phase][1]);
+		glUniform1i(glGetUniformLocation(id, "fillSize"), REFINE_ORDER[phase][2]);
+
+		TraceRegion(0, row, (renderWidth + 3) / 4, rows);
+	}
+
+	/*-------------------------------------------------------*/
+	/* View Functions										 */
+	/*-------------------------------------------------------*/
+	/* AddView ----------------------------------------------*/
+	/*
+		Adds a secondary view. The camera should be its own,
+		not the main view's or another view's, since we go
+		by whether it's changed.
+
+		Input: Camera, position on screen, render scale &
+			   frames between traces
+		Output: The view's index, or -1 if there's no room
+	*/
+	int Renderer::AddView(Camera* camera, glm::vec2 position, float scale, unsigned int interval)
+	{
+		if (views.size() == MAX_VIEWS)
+		{
+			std::cout << "ERROR::RENDERER::TOO_MANY_VIEWS" << std::endl;
+			return -1;
+		}
+
+		View view;
+		view.camera = camera;
+		view.position = position;
+		view.scale = std::min(std::max(scale, MIN_RENDER_SCALE), 1.0f);
+		view.interval = std::max(1u, interval);
+
+		views.push_back(view);
+		PackViews();
+
+		return (int)views.size() - 1;
+	}
+
+	/* RemoveView -------------------------------------------*/
+	/*
+		Removes a secondary view. The views after it move
+		down an index.
+
+		Input: The view's index
+		Output: None
+	*/
+	void Renderer::RemoveView(unsigned int i)
+	{
+		if (i >= views.size()) return;
+
+		views.erase(views.begin() + i);
+		PackViews();
+	}
+
+	/* PackViews --------------------------------------------*/
+	/*
+		Lays the views out in the atlas, one above the next,
+		and reallocates it to fit. Everything in it is lost,
+		so every view is traced again next frame.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::PackViews()
+	{
+		int width = 1;
+		int height = 0;
+
+		for (View& view : views)
+		{
+			view.size = { std::max(1, (int)std::ceil(view.camera->GetWidth() * view.scale)),
+						  std::max(1, (int)std::ceil(view.camera->GetHeight() * view.scale)) };
+			view.origin = { 0, height };
+			view.age = view.interval;
+			view.dirty = true;
+
+			width = std::max(width, view.size.x);
+			height += view.size.y;
+		}
+
+		height = std::max(height, 1);
+
+		glBindTexture(GL_TEXTURE_2D, viewAtlas);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		/*
+			Each view's quad covers its place on screen and
+			samples its rectangle of the atlas.
+		*/
+		float hw = (float)camera->GetWidth() / 2.0f;
+		float hh = (float)camera->GetHeight() / 2.0f;
+
+		for (View& view : views)
+		{
+			float x0 = view.position.x - hw;
+			float y0 = view.position.y - hh;
+			float x1 = x0 + view.camera->GetWidth();
+			float y1 = y0 + view.camera->GetHeight();
+
+			float s0 = (float)view.origin.x / width;
+			float t0 = (float)view.origin.y / height;
+			float s1 = (float)(view.origin.x + view.size.x) / width;
+			float t1 = (float)(view.origin.y + view.size.y) / height;
+
+			view.quad =
+			{
+				{
+					{ x0, y0, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, s0, t0 },
+					{ x0, y1, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, s0, t1 },
+					{ x1, y0, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, s1, t0 }
+				},
+				{
+					{ x0, y1, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, s0, t1 },
+					{ x1, y1, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, s1, t1 },
+					{ x1, y0, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, s1, t0 }
+				}
+			};
+		}
+
+		/*
+			The quads only change here, so this is the only
+			place they're uploaded.
+		*/
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		for (unsigned int i = 0; i < views.size(); i++)
+		{
+			glBufferSubData(GL_ARRAY_BUFFER, (1 + i) * sizeof(Quad), sizeof(Quad), &views[i].quad);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		this->redrawRequested = true;
+	}
+
+	/* CollectViews -----------------------------------------*/
+	/*
+		Works out which views are due. A view is due once its
+		camera or the octree has changed and it's been at
+		least interval frames since we last traced it.
+
+		Input: Whether the octree changed this frame
+		Output: Whether any are
+	*/
+	bool Renderer::CollectViews(bool octreeChanged)
+	{
+		dueViews.clear();
+		this->dueSize = { 0, 0 };
+
+		for (View& view : views)
+		{
+			view.age++;
+			if (view.camera->CheckChanged() || octreeChanged) view.dirty = true;
+			if (!view.dirty || view.age < view.interval) continue;
+
+			dueViews.push_back({ MakeBufferData(view.camera, octree->GetSize()), view.origin, view.size, 1.0f / view.scale, { 0.0f, 0.0f, 0.0f } });
+			this->dueSize = glm::max(dueSize, view.size);
+
+			view.age = 0;
+			view.dirty = false;
+		}
+
+		return !dueViews.empty();
+	}
+
+	/* TraceViews -------------------------------------------*/
+	/*
+		Traces every view that's due, all in one dispatch.
+		The dispatch covers the largest of them, and the
+		smaller ones skip the invocations that fall outside
+		them.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::TraceViews()
+	{
+		PROFILE_SCOPE("Renderer::TraceViews");
+		GPU_PROFILE_SCOPE(gpuTimer, "GPU Views");
+
+		this->viewSlot = (viewSlot + 1) % FRAME_SLOTS;
+
+		glBindBuffer(GL_UNIFORM_BUFFER, viewBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, viewSlot * viewStride, dueViews.size() * sizeof(ViewData), dueViews.data());
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glBindBufferRange(GL_UNIFORM_BUFFER, 1, viewBuffer, viewSlot * viewStride, MAX_VIEWS * sizeof(ViewData));
+
+		UseComputeShader();
+		SetBool(computeShader.GetID(), "useBeam", false);
+		SetBool(computeShader.GetID(), "beamPass", false);
+		SetBool(computeShader.GetID(), "viewPass", true);
+
+		glDispatchCompute((dueSize.x + localSizeX - 1) / localSizeX, (dueSize.y + localSizeY - 1) / localSizeY, (GLuint)dueViews.size());
+	}
+
+	/* DrawViews --------------------------------------------*/
+	/*
+		Draws each view's quad over the main view, from its
+		slot after the screen quad's. Whatever drew the main
+		view (the mesh renderer, the heatmap) may have left
+		its own program and vertex array bound, so we bind
+		the scene shader and the screen quad's ourselves.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::DrawViews()
+	{
+		if (views.empty()) return;
+
+		sceneShader.Use();
+		SetMatrix(sceneShader.GetID(), "mvp", camera->GetViewProjection());
+		SetInt(sceneShader.GetID(), "gBuffer", 0);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, viewAtlas);
+		glBindVertexArray(vao);
+
+		for (unsigned int i = 0; i < views.size(); i++)
+		{
+			glDrawElementsBaseVertex(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, 6 * (1 + i));
+		}
+	}
+
+	/* ReadViewImage ----------------------------------------*/
+	/*
+		Reads a view's rectangle of the atlas back from the
+		GPU, as packed pixels, row by row from the bottom.
+
+		Input: The view's index & vector to read it into
+		Output: None
+	*/
+	void Renderer::ReadViewImage(unsigned int i, std::vector<unsigned int>& pixels)
+	{
+		if (i >= views.size()) return;
+
+		GLint width, height;
+		std::vector<unsigned int> atlas;
+
+		glBindTexture(GL_TEXTURE_2D, viewAtlas);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+
+		atlas.resize((size_t)width * height);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, atlas.data());
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		View& view = views[i];
+		pixels.resize((size_t)view.size.x * view.size.y);
+
+		for (int y = 0; y < view.size.y; y++)
+		{
+			const unsigned int* row = &atlas[((size_t)(view.origin.y + y) * width) + view.origin.x];
+			memcpy(&pixels[(size_t)y * view.size.x], row, (size_t)view.size.x * sizeof(unsigned int));
+		}
+	}
+
+	/*-------------------------------------------------------*/
+	/* Render Scale Functions								 */
 	/*-------------------------------------------------------*/
-	bool Renderer::IsUpdateNeeded()
+	/* SetRenderScale ---------------------------------------*/
+	/*
+		Changes the fraction of the view's resolution we trace
+		at, rounded to the nearest step, and reallocates the
+		images to match. Nothing we've traced carries over,
+		so the next frame traces the whole view.
+
+		Input: Render scale (from MIN_RENDER_SCALE to 1)
+		Output: None
+	*/
+	void Renderer::SetRenderScale(float scale)
 	{
-		return (camera->CheckChanged() || octree->CheckChanged());
+		scale = std::round(scale * RENDER_SCALE_STEPS) / RENDER_SCALE_STEPS;
+		scale = std::min(std::max(scale, MIN_RENDER_SCALE), 1.0f);
+		if (scale == renderScale) return;
+
+		this->renderScale = scale;
+		this->traceValid = false;
+		this->ringOffset = { 0, 0 };
+		this->smoothedTraceMs = 0.0;
+		this->scaleCooldown = 2;
+
+		AllocateImages();
 	}
 
-	void Renderer::Render()
+	/* UpdateRenderScale ------------------------------------*/
+	/*
+		The resolution controller. Each time a full trace's
+		GPU time comes back, we fold it into a running
+		average and compare that with the budget. A trace
+		costs about the same per pixel whatever the scale,
+		so the time goes with the square of the scale, which
+		tells us the scale that would just fit.
+
+		Over budget, we drop straight to the step below that.
+		Under budget, we only go up a step at a time, and
+		only if the next step up should still leave some
+		room, so we don't bounce between two steps.
+
+		The GPU's times come back a frame or two late, so for
+		the first couple after a change we'd be looking at
+		the old scale. Those we ignore.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::UpdateRenderScale()
 	{
-		glActiveTexture(GL_TEXTURE0);
+		double ms = gpuTimer.TakeLatest("GPU Trace");
+		if (!adaptiveResolution || ms < 0.0) return;
+
+		if (scaleCooldown > 0)
+		{
+			scaleCooldown--;
+			return;
+		}
+
+		smoothedTraceMs = (smoothedTraceMs > 0.0) ? 0.75 * smoothedTraceMs + 0.25 * ms : ms;
+
+		float step = 1.0f / RENDER_SCALE_STEPS;
+		float up = renderScale + step;
+
+		if (smoothedTraceMs > traceBudget)
+		{
+			float fit = renderScale * (float)std::sqrt(traceBudget / smoothedTraceMs);
+			SetRenderScale(std::min(std::floor(fit * RENDER_SCALE_STEPS) / RENDER_SCALE_STEPS, renderScale - step));
+		}
+		else if (up <= 1.0f && smoothedTraceMs * (up * up) / (renderScale * renderScale) < 0.85 * traceBudget)
+		{
+			SetRenderScale(up);
+		}
+	}
+
+	/* AllocateImages ---------------------------------------*/
+	/*
+		(Re)allocates the octree and beam images at the
+		current render scale. UseComputeShader binds them.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::AllocateImages()
+	{
+		this->renderWidth = std::max(1u, (unsigned int)std::ceil(camera->GetWidth() * renderScale));
+		this->renderHeight = std::max(1u, (unsigned int)std::ceil(camera->GetHeight() * renderScale));
+
 		glBindTexture(GL_TEXTURE_2D, octreeTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, renderWidth, renderHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+
+		glBindTexture(GL_TEXTURE_2D, beamTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, (renderWidth + beamTile - 1) / beamTile, (renderHeight + beamTile - 1) / beamTile, 0, GL_RED, GL_FLOAT, NULL);
+
+		if (instrumented)
+		{
+			glBindTexture(GL_TEXTURE_2D, costTexture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, renderWidth, renderHeight, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, NULL);
+		}
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
 
-		if (IsUpdateNeeded())
+	/*-------------------------------------------------------*/
+	/* Backend Functions									 */
+	/*-------------------------------------------------------*/
+	/* SetBackend -------------------------------------------*/
+	/*
+		Switches how the main view is drawn. The backend we
+		switch to hasn't been following the octree's edits,
+		so it starts from scratch: the mesh renderer (made
+		the first time it's asked for) meshes every chunk
+		again, and the tracer traces the whole view.
+
+		Input: Backend
+		Output: None
+	*/
+	void Renderer::SetBackend(Backend backend)
+	{
+		if (backend == this->backend) return;
+
+		if (backend == Backend::Mesh)
+		{
+			if (meshRenderer == nullptr) this->meshRenderer = new MeshRenderer(camera, octree);
+			else meshRenderer->MarkAllDirty();
+		}
+		else
+		{
+			this->traceValid = false;
+			this->dirtyBoxes.clear();
+		}
+
+		this->backend = backend;
+		this->redrawRequested = true;
+	}
+
+	/*-------------------------------------------------------*/
+	/* Workgroup Functions									 */
+	/*-------------------------------------------------------*/
+	/* SetLocalSize -----------------------------------------*/
+	/*
+		Reloads the compute shader with a new workgroup size.
+
+		Input: Workgroup width & height
+		Output: None
+	*/
+	void Renderer::SetLocalSize(unsigned int x, unsigned int y)
+	{
+		if (x == localSizeX && y == localSizeY) return;
+
+		glDeleteProgram(computeShader.GetID());
+		computeShader = Shader("assets/shaders/base.comp", ComputeDefines(x, y, instrumented));
+
+		this->localSizeX = x;
+		this->localSizeY = y;
+	}
+
+	/* TuneLocalSize ----------------------------------------*/
+	/*
+		Times a trace of the current view with each of a few
+		workgroup sizes and keeps the fastest. One by one is
+		in there as the baseline.
+
+		Input: Number of traces to time per size
+		Output: Time per trace for each size
+	*/
+	std::vector<LocalSizeTiming> Renderer::TuneLocalSize(unsigned int n)
+	{
+		const unsigned int sizes[][2] = { { 1, 1 }, { 8, 4 }, { 8, 8 }, { 16, 8 }, { 16, 16 }, { 32, 8 } };
+
+		std::vector<LocalSizeTiming> timings;
+		LocalSizeTiming best = { localSizeX, localSizeY, 0.0f };
+
+		for (auto& size : sizes)
+		{
+			SetLocalSize(size[0], size[1]);
+			timings.push_back({ size[0], size[1], TimeTrace(n) });
+
+			if (best.ms == 0.0f || timings.back().ms < best.ms) best = timings.back();
+		}
+
+		SetLocalSize(best.x, best.y);
+		return timings;
+	}
+
+	/*-------------------------------------------------------*/
+	/* Beam Optimization Functions							 */
+	/*-------------------------------------------------------*/
+	/* ValidateBeam -----------------------------------------*/
+	/*
+		Traces the current view once without and once with
+		the beam pass and compares the two images, which must
+		be identical since the beam only ever skips space the
+		rays would have found empty anyway. The step counts
+		of each go into the given stats.
+
+		Input: Stats for the single-pass and beam traces
+		Output: Number of pixels that differ
+	*/
+	unsigned int Renderer::ValidateBeam(TraversalStats& single, TraversalStats& beam)
+	{
+		std::vector<unsigned int> a, b;
+		bool count = countSteps;
+		countSteps = true;
+
+		WriteFrameData();
+		ReadTraversalStats();
+
+		Trace(false);
+		single = ReadTraversalStats();
+		ReadImage(a);
+
+		Trace(true);
+		beam = ReadTraversalStats();
+		ReadImage(b);
+
+		countSteps = count;
+
+		unsigned int mismatches = 0;
+		for (size_t i = 0; i < a.size(); i++)
 		{
-			octree->OverwriteBufferData();
+			if (a[i] != b[i]) mismatches++;
+		}
+
+		return mismatches;
+	}
+
+	/*-------------------------------------------------------*/
+	/* Traversal Functions									 */
+	/*-------------------------------------------------------*/
+	/* ValidateTraversal ------------------------------------*/
+	/*
+		Traces the whole view on the GPU and checks every
+		pixel against a brute-force DDA through the grid on
+		the CPU (MarchRay), our golden image. Pixels match if
+		they hit the same type through the same face, within
+		a sixteenth of a voxel (float error can tip the depth
+		either way). cpuMismatches gets the same count for
+		the CPU build of the traversal (TraceRay), which runs
+		the shader's own code. This takes a while, since the
+		reference looks every voxel up from the root.
+
+		Input: Count of CPU traversal mismatches
+		Output: Number of GPU pixels that differ
+	*/
+	unsigned int Renderer::ValidateTraversal(unsigned int& cpuMismatches)
+	{
+		std::vector<unsigned int> image;
+
+		WriteFrameData();
+		Trace(false);
+		ReadImage(image);
 
-			computeShader.Use();
-			glBindBuffer(GL_SHADER_STORAGE_BUFFER, octree->GetSSBO());
-			glDispatchCompute(camera->GetWidth(), camera->GetHeight(), 1);
-			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		unsigned int size = octree->GetSize();
+		const Voxel* voxels = octree->GetVoxels();
+		BufferData bd = MakeBufferData(camera, size);
+		if (traceValid) bd.cameraPosition = glm::vec4(traceOrigin, 0);
+
+		glm::vec3 position = glm::vec3(bd.cameraPosition.x, bd.cameraPosition.y, bd.cameraPosition.z) - glm::vec3(bd.centerPosition.x, bd.centerPosition.y, bd.centerPosition.z);
+		glm::vec3 right = glm::vec3(bd.cameraRight.x, bd.cameraRight.y, bd.cameraRight.z);
+		glm::vec3 up = glm::vec3(bd.cameraUp.x, bd.cameraUp.y, bd.cameraUp.z);
+		glm::vec3 forward = glm::vec3(bd.cameraForward.x, bd.cameraForward.y, bd.cameraForward.z);
+		glm::vec2 gridShift = traceValid ? glm::vec2(traceShift) : glm::vec2(0.0f);
+		float pixelSize = 1.0f / renderScale;
+
+		/*
+			Two packed hits are the same if everything but the
+			depth is, and the depths are at most one apart.
+		*/
+		auto same = [](unsigned int a, unsigned int b)
+		{
+			if ((a & 0x3FFF) != (b & 0x3FFF)) return false;
+			return std::abs((int)(a >> 14) - (int)(b >> 14)) <= 1;
 		};
 
-		sceneShader.Use();
-		SetMatrix(sceneShader.GetID(), "mvp", camera->GetViewProjection());
+		/*
+			A ray straight down an edge between voxels could go
+			either way, and which it does comes down to float
+			error. So a hit that differs from the reference
+			still passes if the reference agrees with it once
+			the ray's nudged a thousandth of a voxel sideways.
+		*/
+		glm::vec3 nudges[4] = { right * 1e-3f, -right * 1e-3f, up * 1e-3f, -up * 1e-3f };
 
-		glBindVertexArray(vao);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Quad), &screenQuad);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+		auto matches = [&](unsigned int packed, unsigned int reference, glm::vec3 origin)
+		{
+			if (same(packed, reference)) return true;
+
+			for (glm::vec3& nudge : nudges)
+			{
+				if (same(packed, PackHit(MarchRay(voxels, size, origin + nudge, forward)))) return true;
+			}
+
+			return false;
+		};
+
+		unsigned int mismatches = 0;
+		cpuMismatches = 0;
+
+		for (unsigned int y = 0; y < renderHeight; y++)
+		{
+			for (unsigned int x = 0; x < renderWidth; x++)
+			{
+				/*
+					The same ray the shader traces for this pixel,
+					which it wrote to its place in the ring.
+				*/
+				glm::vec2 offset = (glm::vec2((float)x, (float)y) + gridShift + 0.5f) * pixelSize - glm::vec2((float)bd.viewWidth, (float)bd.viewHeight) * 0.5f;
+				glm::vec3 origin = position + offset.x * right + offset.y * up;
+
+				unsigned int reference = PackHit(MarchRay(voxels, size, origin, forward));
+				unsigned int cpu = PackHit(TraceRay(voxels, size, origin, forward));
+				unsigned int gpu = image[((y + ringOffset.y) % renderHeight) * renderWidth + (x + ringOffset.x) % renderWidth];
+
+				if (!matches(gpu, reference, origin)) mismatches++;
+				if (!matches(cpu, reference, origin)) cpuMismatches++;
+			}
+		}
+
+		return mismatches;
+	}
+
+	/*-------------------------------------------------------*/
+	/* Statistics Functions									 */
+	/*-------------------------------------------------------*/
+	/* ReadTraversalStats -----------------------------------*/
+	/*
+		Reads the step counters the compute shader has added
+		up since the last call, then zeroes them.
+
+		Input: None
+		Output: Traversal stats
+	*/
+	TraversalStats Renderer::ReadTraversalStats()
+	{
+		TraversalStats stats;
+		TraversalStats zero = { 0, 0, 0, 0 };
+
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, statsBuffer);
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(TraversalStats), &stats);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(TraversalStats), &zero);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		return stats;
+	}
+
+	/*-------------------------------------------------------*/
+	/* Instrumentation Functions							 */
+	/*-------------------------------------------------------*/
+	/* SetInstrumented --------------------------------------*/
+	/*
+		Swaps the compute shader for (or back from) its
+		instrumentation build. The cost image only exists
+		while it's on, so the images are sized again, and
+		what we'd traced is thrown out, along with any
+		totals left from last time.
+
+		Input: Whether to instrument
+		Output: None
+	*/
+	void Renderer::SetInstrumented(bool instrumented)
+	{
+		if (instrumented == this->instrumented) return;
+
+		this->instrumented = instrumented;
+		if (!instrumented) this->heatmap = Heatmap::None;
+
+		glDeleteProgram(computeShader.GetID());
+		computeShader = Shader("assets/shaders/base.comp", ComputeDefines(localSizeX, localSizeY, instrumented));
+
+		this->traceValid = false;
+		this->traversalCounters = { 0, 0, 0, 0, 0, 0, 0 };
+		AllocateImages();
+
+		for (unsigned int i = 0; i < FRAME_SLOTS; i++)
+		{
+			if (costFences[i] != nullptr) glDeleteSync(costFences[i]);
+			this->costFences[i] = nullptr;
+
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, costBuffers[i]);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(TraversalCounters), &traversalCounters);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	/* SetHeatmap -------------------------------------------*/
+	/*
+		Picks what the heatmap shows. Showing anything turns
+		instrumentation on.
+
+		Input: Count to show, or none
+		Output: None
+	*/
+	void Renderer::SetHeatmap(Heatmap heatmap)
+	{
+		if (heatmap != Heatmap::None) SetInstrumented(true);
+		this->heatmap = heatmap;
+	}
+
+	/* ReadTraversalCounters --------------------------------*/
+	/*
+		The totals are a ring of FRAME_SLOTS buffers, each
+		with a fence that's put down after the trace that
+		fills it. We read back the oldest (from two traces
+		ago) only once its fence has gone by, so reading
+		never waits on the GPU; if it hasn't, we keep the
+		totals we had. Then this trace's slot is zeroed.
+
+		Input: None
+		Output: None
+	*/
+	void Renderer::ReadTraversalCounters()
+	{
+		TraversalCounters zero = { 0, 0, 0, 0, 0, 0, 0 };
+		unsigned int oldest = (costSlot + 1) % FRAME_SLOTS;
+
+		if (costFences[oldest] != nullptr)
+		{
+			GLenum result = glClientWaitSync(costFences[oldest], 0, 0);
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+			{
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, costBuffers[oldest]);
+				glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(TraversalCounters), &traversalCounters);
+
+				glDeleteSync(costFences[oldest]);
+				this->costFences[oldest] = nullptr;
+			}
+		}
+
+		// If this slot was never read, its totals are lost.
+		if (costFences[costSlot] != nullptr)
+		{
+			glDeleteSync(costFences[costSlot]);
+			this->costFences[costSlot] = nullptr;
+		}
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, costBuffers[costSlot]);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(TraversalCounters), &zero);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	/* GetHeatmapScale --------------------------------------*/
+	/*
+		The count at the top of the heatmap's ramp: twice
+		the last trace's average over the rays that got into
+		the octree (the rest cost next to nothing), so the
+		typical pixel sits in the middle and the expensive
+		ones stand out.
+
+		Input: None
+		Output: Count
+	*/
+	float Renderer::GetHeatmapScale()
+	{
+		const TraversalCounters& c = traversalCounters;
+		if (c.activeRays == 0) return 64.0f;
+
+		unsigned int totals[4] = { c.visits, c.pushes, c.pops, c.iterations };
+		return std::max(1.0f, 2.0f * totals[(int)heatmap] / c.activeRays);
 	}
 
 	/*-------------------------------------------------------*/
 	/* Constructor											 */
 	/*-------------------------------------------------------*/
-	Renderer::Renderer(Camera* camera, Octree* octree) :
-		sceneShader("assets/shaders/base.vert", "assets/shaders/base.frag"),
-		computeShader("assets/shaders/base.comp")
+	Renderer::Renderer(Camera* camera, OctreeBuffer* buffer) :
+		sceneShader("assets/shaders/base.vert", "assets/shaders/resolve.frag"),
+		computeShader("assets/shaders/base.comp", ComputeDefines(8, 8, false)),
+		heatmapShader("assets/shaders/base.vert", "assets/shaders/heatmap.frag")
 	{
 		/*
 			First, some preliminary pointers.
 		*/
 		this->camera = camera;
-		this->octree = octree;
+		this->octree = buffer->GetOctree();
+		this->buffer = buffer;
+
+		this->localSizeX = 8;
+		this->localSizeY = 8;
 
 		/*
 			Next, we set up our OpenGL buffers.
 		*/
-		GLuint ibo;
-
 		glGenVertexArrays(1, &vao);
 		glBindVertexArray(vao);
 
@@ -71,7 +1615,12 @@ namespace Winedark
 		glGenBuffers(1, &ibo);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Quad), nullptr, GL_DYNAMIC_DRAW);
+		/*
+			The screen quad goes first, then a slot for each
+			view's, so drawing a view is just an offset into
+			the buffer.
+		*/
+		glBufferData(GL_ARRAY_BUFFER, (1 + MAX_VIEWS) * sizeof(Quad), nullptr, GL_DYNAMIC_DRAW);
 
 		/*
 			Now we need to assign our vertex attribute
@@ -119,11 +1668,153 @@ namespace Winedark
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, camera->GetWidth(), camera->GetHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
-		glBindImageTexture(0, octreeTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
 
-		// Now the screen quad.
+		/*
+			The beam texture holds one start distance per
+			tile, so it's a fraction of the size.
+
+			The beam pass is off by default. Looking straight
+			down on the sea, every ray already finds the
+			surface in about as many steps as the tree is
+			deep, so there's little empty space for it to
+			skip and the coarse pass costs more than it saves.
+		*/
+		this->beamOptimization = false;
+		this->beamTile = 8;
+
+		glGenTextures(1, &beamTexture);
+		glBindTexture(GL_TEXTURE_2D, beamTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		/*
+			Instrumentation is off to begin with, so the cost
+			image has no storage until it's turned on. It's a
+			ring like the octree texture, so it wraps too.
+		*/
+		TraversalCounters counters = { 0, 0, 0, 0, 0, 0, 0 };
+		this->instrumented = false;
+		this->heatmap = Heatmap::None;
+		this->traversalCounters = counters;
+
+		glGenTextures(1, &costTexture);
+		glBindTexture(GL_TEXTURE_2D, costTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		this->costBuffers.resize(FRAME_SLOTS);
+		this->costFences.assign(FRAME_SLOTS, nullptr);
+		this->costSlot = 0;
+
+		glGenBuffers(FRAME_SLOTS, costBuffers.data());
+		for (GLuint costBuffer : costBuffers)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, costBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(TraversalCounters), &counters, GL_DYNAMIC_READ);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		/*
+			Both images start out at full resolution, with
+			the resolution controller off. Upscaling is just
+			the screen quad sampling a smaller image, nearest
+			neighbour, which keeps voxel edges hard.
+		*/
+		this->renderScale = 1.0f;
+		this->adaptiveResolution = false;
+		this->traceBudget = 8.0f;
+		this->smoothedTraceMs = 0.0;
+		this->scaleCooldown = 0;
+
+		AllocateImages();
+
+		/*
+			Progressive refinement is off to begin with.
+		*/
+		this->progressive = false;
+		this->refinePhase = REFINE_PHASES;
+		this->refineRow = 0;
+		this->refineBudget = 65536;
+
+		/*
+			Then the frame data ring. Each slot has to start
+			on a multiple of the uniform buffer alignment.
+		*/
+		GLint alignment = 256;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+		this->frameStride = ((sizeof(BufferData) + alignment - 1) / alignment) * alignment;
+		this->frameSlot = 0;
+
+		glGenBuffers(1, &frameBuffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, FRAME_SLOTS * frameStride, nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		/*
+			The views have a ring of their own, each slot
+			big enough for all of them, and start out with
+			an empty atlas.
+		*/
+		this->viewStride = ((MAX_VIEWS * sizeof(ViewData) + alignment - 1) / alignment) * alignment;
+		this->viewSlot = 0;
+
+		glGenBuffers(1, &viewBuffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, viewBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, FRAME_SLOTS * viewStride, nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		glGenTextures(1, &viewAtlas);
+		glBindTexture(GL_TEXTURE_2D, viewAtlas);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		PackViews();
+
+		/*
+			Reprojection starts with nothing to reuse, so the
+			first frame traces the whole view.
+		*/
+		this->reprojection = true;
+		this->traceValid = false;
+		this->traceOrigin = camera->GetPosition();
+		this->traceRotation = camera->GetRotation();
+		this->traceShift = { 0, 0 };
+		this->ringOffset = { 0, 0 };
+		this->subPixel = { 0.0f, 0.0f };
+
+		/*
+			The tracer draws the main view to begin with. The
+			mesh renderer starts worker threads, so it isn't
+			made until someone switches to it.
+		*/
+		this->backend = Backend::Trace;
+		this->meshRenderer = nullptr;
+
+		/*
+			And the traversal step counters.
+		*/
+		TraversalStats zero = { 0, 0, 0, 0 };
+		this->countSteps = false;
+
+		glGenBuffers(1, &statsBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, statsBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(TraversalStats), &zero, GL_DYNAMIC_READ);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, statsBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		// Now the screen quad, which the first Draw uploads.
+		this->screenQuadDirty = true;
+		this->redrawRequested = true;
+
 		float hw = (float)camera->GetWidth() / 2.0f;
 		float hh = (float)camera->GetHeight() / 2.0f;
 
@@ -144,10 +1835,55 @@ namespace Winedark
 		// And the texture atlas.
 		// ...
 
-		// Oh, and the texture samplers.
+		/*
+			The images, the octree's buffer and the screen
+			live across frames, so the render graph imports
+			them. The screen is the default framebuffer,
+			which is always 0.
+		*/
+		this->octreeResource = graph.ImportTexture(octreeTexture);
+		this->viewResource = graph.ImportTexture(viewAtlas);
+		this->voxelResource = graph.ImportBuffer(buffer->GetSSBO());
+		this->screenResource = graph.ImportTexture(0);
+		this->costImageResource = graph.ImportTexture(costTexture);
+		this->costBufferResource = graph.ImportBuffer(costBuffers[costSlot]);
+
+		// Oh, and the G-buffer sampler.
 		glUseProgram(sceneShader.GetID());
-		GLint location = glGetUniformLocation(sceneShader.GetID(), "textures");
-		int samplers[1] = { 0 };
-		glUniform1iv(location, 1, samplers);
+		SetInt(sceneShader.GetID(), "gBuffer", 0);
+
+		glUseProgram(heatmapShader.GetID());
+		SetInt(heatmapShader.GetID(), "costs", 0);
+	}
+
+	/*-------------------------------------------------------*/
+	/* Deconstructor										 */
+	/*-------------------------------------------------------*/
+	/*
+		Gives back every GL object the constructor made,
+		and any fences still down. The octree's SSBO
+		belongs to its OctreeBuffer, so that stays.
+	*/
+	Renderer::~Renderer()
+	{
+		delete meshRenderer;
+
+		glDeleteProgram(sceneShader.GetID());
+		glDeleteProgram(computeShader.GetID());
+		glDeleteProgram(heatmapShader.GetID());
+
+		GLuint textures[] = { octreeTexture, beamTexture, costTexture, viewAtlas };
+		glDeleteTextures(4, textures);
+
+		GLuint buffers[] = { vbo, ibo, frameBuffer, viewBuffer, statsBuffer };
+		glDeleteBuffers(5, buffers);
+
+		for (GLsync fence : costFences)
+		{
+			if (fence != nullptr) glDeleteSync(fence);
+		}
+		glDeleteBuffers((GLsizei)costBuffers.size(), costBuffers.data());
+
+		glDeleteVertexArrays(1, &vao);
 	}
 }
\ No newline at end of file
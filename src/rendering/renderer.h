@@ -3,6 +3,10 @@
 
 #include "camera.h"
 #include "shader.h"
+#include "gputimer.h"
+#include "meshrenderer.h"
+#include "octreebuffer.h"
+#include "rendergraph.h"
 #include "textureatlas.h"
 #include "../world/octree.h"
 #include "../util/polygons.h"
@@ -14,6 +18,153 @@ namespace Winedark
 	/* Rendering																					*/
 	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
 	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Buffer Data															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Because certain information is necessary to perform the raycasts
+		in the compute shader, we have a neat little struct here to bundle
+		that up and make sending it to the GPU easier. It's laid out the
+		same under std140 as in C++, so it goes into the uniform buffer
+		as it is.
+	*/
+	struct BufferData
+	{
+		unsigned int	size;
+		unsigned int	viewWidth;
+		unsigned int	viewHeight;
+		unsigned int	padding;
+
+		glm::vec4		cameraPosition;
+		glm::vec4		cameraRight;
+		glm::vec4		cameraUp;
+		glm::vec4		cameraForward;
+		glm::vec4		centerPosition;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* View Data															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		What the compute shader needs to know about a secondary view: its
+		camera, and where in the view atlas it goes. Laid out exactly as
+		the View struct in base.comp under std140.
+	*/
+	struct ViewData
+	{
+		BufferData		data;
+		glm::ivec2		origin;
+		glm::ivec2		size;
+		float			pixelSize;
+		float			padding[3];
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* View																	 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		A secondary view, like a minimap or a spyglass. It has its own
+		camera, whose width and height are its size on screen, and sits
+		with its bottom left corner at position (in screen pixels, from
+		the bottom left of the main view). It's traced at scale times its
+		size, at most once every interval frames, and only when its
+		camera or the octree has changed.
+	*/
+	struct View
+	{
+		Camera*			camera;
+		glm::vec2		position;
+		float			scale;
+		unsigned int	interval;
+
+		unsigned int	age;
+		bool			dirty;
+		glm::ivec2		origin;
+		glm::ivec2		size;
+		Quad			quad;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Traversal Stats														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		How many traversal steps the compute shader took, summed over
+		every ray, for the coarse beam pass and the full-resolution pass.
+		Laid out exactly as the stats buffer in base.comp.
+	*/
+	struct TraversalStats
+	{
+		unsigned int	beamSteps;
+		unsigned int	traceSteps;
+		unsigned int	beamRays;
+		unsigned int	traceRays;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Traversal Counters													 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		What the instrumentation build of the compute shader counted over
+		a whole trace: the nodes each ray read from the voxel buffer, the
+		stack entries it pushed and popped and the iterations of its
+		loop, summed over every ray, how many rays there were (and how
+		many of those got into the octree at all) and the most
+		iterations any one ray took. Laid out exactly as the cost buffer
+		in base.comp.
+	*/
+	struct TraversalCounters
+	{
+		unsigned int	visits;
+		unsigned int	pushes;
+		unsigned int	pops;
+		unsigned int	iterations;
+		unsigned int	rays;
+		unsigned int	activeRays;
+		unsigned int	maxIterations;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Heatmap																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Which of the traversal counts the heatmap shows, if any.
+	*/
+	enum class Heatmap
+	{
+		None = -1,
+		Visits,
+		Pushes,
+		Pops,
+		Iterations
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Backend																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		How the main view is drawn: traced by the compute shader, a ray
+		per pixel, or meshed and rasterized (see MeshRenderer).
+	*/
+	enum class Backend
+	{
+		Trace,
+		Mesh
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Local Size Timing													 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		How long a trace of the whole view took with a given compute
+		workgroup size.
+	*/
+	struct LocalSizeTiming
+	{
+		unsigned int	x;
+		unsigned int	y;
+		float			ms;
+	};
+
 	/*-----------------------------------------------------------------------*/
 	/* Renderer																 */
 	/*-----------------------------------------------------------------------*/
@@ -32,6 +183,87 @@ namespace Winedark
 		Each frame, (if texture needs to be updated) we run the compute shader
 		to update the scene texture, then pass that to the GPU and tell it
 		to render the scene.
+
+		The compute shader doesn't shade anything. The scene texture is a
+		G-buffer of one packed uint per pixel (what was hit, which face
+		and how far away) and the scene shader (resolve.frag) turns that
+		into a color as it draws. That's a quarter of the memory traffic
+		of writing RGBA floats, and shading changes don't mean tracing
+		again.
+
+		The octree's SSBO (its OctreeBuffer's) only holds voxels, and
+		the shader only reads it. Everything about the view (the
+		BufferData) goes in a small uniform buffer of our own instead, so
+		moving the camera never touches the voxels and several renderers
+		can share one octree. That buffer is a ring of FRAME_SLOTS slots
+		and each write takes the next one, so we never overwrite a slot a
+		trace still in flight might be reading.
+
+		The compute shader runs twice when the beam optimization is on
+		(Laine & Karras 2010, section 6.1). First a coarse pass traces one
+		ray per beamTile x beamTile tile and writes a distance that's safe
+		for every ray in the tile to start from into the beam texture.
+		Then the full-resolution pass starts each ray there, skipping the
+		empty space in front of it instead of walking down from the root.
+
+		Both passes run in localSizeX x localSizeY workgroups, which we
+		bake into the compute shader when we load it. A GPU (or llvmpipe)
+		runs a whole workgroup's invocations side by side, so one pixel
+		per workgroup would leave nearly all of it idle.
+
+		The camera is orthographic, so when it only pans, everything it
+		saw last frame is still right, just moved over by however many
+		pixels it panned. With reprojection on, we treat the octree
+		texture as a ring: panning moves ringOffset (where view pixel
+		(0, 0) lives in the texture) and we only trace the strips that
+		have come into view. The screen quad samples the texture from
+		ringOffset and wraps around. To keep the old pixels exact, new
+		ones are traced on the same pixel grid as the old, which means
+		the image moves in whole pixels.
+
+		Edits work the same way. The octree hands us the boxes it's
+		edited since last frame, and we only re-trace the pixels whose
+		rays go through them.
+
+		When tracing the whole view takes too long, we can trace it at
+		a fraction of the resolution (the render scale) and stretch the
+		result over the screen. With adaptive resolution on, the scale
+		follows the GPU time of the last few full traces, aiming to
+		keep them under traceBudget milliseconds.
+
+		As well as the main view, we can have a few secondary views (see
+		View), all reading the same octree. Those that are due are traced
+		together, in one dispatch with a z slice per view, into their own
+		rectangles of a single view atlas, and then drawn over the main
+		view. They skip everything above (beams, the ring, refinement),
+		which mostly pays for itself at their size.
+
+		With progressive refinement on, a full trace only traces one
+		pixel in every 4 x 4 block, each filling its block. Then, for
+		as long as the view holds still, each frame traces up to
+		refineBudget more pixels until the whole view is done. Moving
+		the camera or a big enough edit starts it over.
+
+		With instrumentation on, the compute shader is built with
+		INSTRUMENT defined, and counts what each ray's traversal does
+		into a cost image (one RGBA32UI texel per pixel) and the totals
+		into a small buffer. Every frame is then a full trace, so the
+		image covers the whole view, and we read the totals back the
+		frame after. The heatmap draws one of the counts in place of the
+		scene.
+
+		Each frame is a render graph (see RenderGraph) of up to three
+		passes: the trace of the main view, the views, and the draw. The
+		graph works out the barriers between them, so the draw waits on
+		the traces only when there's been one, and times each pass under
+		its name.
+
+		The main view can be meshed and rasterized instead (the mesh
+		backend), which skips the trace pass altogether and has the draw
+		pass draw the meshes. Only one backend follows the octree's
+		edits at a time, so switching to the mesh backend meshes the
+		whole world again (the first time it's made, as well) and
+		switching back traces the whole view. Views are always traced.
 	*/
 	class Renderer
 	{
@@ -41,11 +273,13 @@ namespace Winedark
 		/*-------------------------------------------------------*/
 		GLuint					vao;
 		GLuint					vbo;
+		GLuint					ibo;
 
 		/*-------------------------------------------------------*/
 		/* Screen Quad											 */
 		/*-------------------------------------------------------*/
 		Quad					screenQuad;
+		bool					screenQuadDirty;
 
 		/*-------------------------------------------------------*/
 		/* Camera												 */
@@ -56,13 +290,114 @@ namespace Winedark
 		/* Octree												 */
 		/*-------------------------------------------------------*/
 		Octree*					octree;
+		OctreeBuffer*			buffer;
 		GLuint					octreeTexture;
 
+		/*-------------------------------------------------------*/
+		/* Frame Data											 */
+		/*-------------------------------------------------------*/
+		GLuint					frameBuffer;
+		GLsizeiptr				frameStride;
+		unsigned int			frameSlot;
+
+		/*-------------------------------------------------------*/
+		/* Beam Optimization									 */
+		/*-------------------------------------------------------*/
+		GLuint					beamTexture;
+		bool					beamOptimization;
+		unsigned int			beamTile;
+
+		/*-------------------------------------------------------*/
+		/* Views												 */
+		/*-------------------------------------------------------*/
+		std::vector<View>		views;
+		std::vector<ViewData>	dueViews;
+		glm::ivec2				dueSize;
+		GLuint					viewAtlas;
+		GLuint					viewBuffer;
+		GLsizeiptr				viewStride;
+		unsigned int			viewSlot;
+
+		/*-------------------------------------------------------*/
+		/* Render Scale											 */
+		/*-------------------------------------------------------*/
+		float					renderScale;
+		unsigned int			renderWidth;
+		unsigned int			renderHeight;
+		bool					adaptiveResolution;
+		float					traceBudget;
+		double					smoothedTraceMs;
+		unsigned int			scaleCooldown;
+
+		/*-------------------------------------------------------*/
+		/* Progressive Refinement								 */
+		/*-------------------------------------------------------*/
+		bool					progressive;
+		unsigned int			refinePhase;
+		unsigned int			refineRow;
+		unsigned int			refineBudget;
+
+		/*-------------------------------------------------------*/
+		/* Reprojection											 */
+		/*-------------------------------------------------------*/
+		bool					reprojection;
+		bool					traceValid;
+		bool					redrawRequested;
+		glm::vec3				traceOrigin;
+		Quaternion				traceRotation;
+		glm::ivec2				traceShift;
+		glm::ivec2				panStep;
+		glm::ivec2				ringOffset;
+		glm::vec2				subPixel;
+
+		/*-------------------------------------------------------*/
+		/* Dirty Boxes											 */
+		/*-------------------------------------------------------*/
+		std::vector<Box>		dirtyBoxes;
+
+		/*-------------------------------------------------------*/
+		/* Statistics											 */
+		/*-------------------------------------------------------*/
+		GLuint					statsBuffer;
+		bool					countSteps;
+		GpuTimer				gpuTimer;
+
+		/*-------------------------------------------------------*/
+		/* Instrumentation										 */
+		/*-------------------------------------------------------*/
+		bool					instrumented;
+		Heatmap					heatmap;
+		GLuint					costTexture;
+		std::vector<GLuint>		costBuffers;
+		std::vector<GLsync>		costFences;
+		unsigned int			costSlot;
+		TraversalCounters		traversalCounters;
+
+		/*-------------------------------------------------------*/
+		/* Mesh Backend											 */
+		/*-------------------------------------------------------*/
+		Backend					backend;
+		MeshRenderer*			meshRenderer;
+
+		/*-------------------------------------------------------*/
+		/* Render Graph											 */
+		/*-------------------------------------------------------*/
+		RenderGraph				graph;
+		ResourceHandle			octreeResource;
+		ResourceHandle			viewResource;
+		ResourceHandle			voxelResource;
+		ResourceHandle			screenResource;
+		ResourceHandle			costImageResource;
+		ResourceHandle			costBufferResource;
+
 		/*-------------------------------------------------------*/
 		/* Shaders												 */
 		/*-------------------------------------------------------*/
 		Shader					sceneShader;
 		Shader					computeShader;
+		Shader					heatmapShader;
+		unsigned int			localSizeX;
+		unsigned int			localSizeY;
 
 		/*-------------------------------------------------------*/
 		/* Textures												 */
@@ -70,17 +405,152 @@ namespace Winedark
 		std::vector<Texture>	textures;
 		TextureAtlas			textureAtlas;
 
+		/*-------------------------------------------------------*/
+		/* Frame Data Functions									 */
+		/*-------------------------------------------------------*/
+		void					WriteFrameData();
+
+		/*-------------------------------------------------------*/
+		/* Pass Functions										 */
+		/*-------------------------------------------------------*/
+		void					TraceScene(bool cameraChanged);
+		void					Draw();
+
+		/*-------------------------------------------------------*/
+		/* Tracing Functions									 */
+		/*-------------------------------------------------------*/
+		void					UseComputeShader();
+		void					Trace(bool beam);
+		void					TraceRegion(int x, int y, unsigned int width, unsigned int height);
+		void					TraceDirtyBoxes();
+		void					ReadImage(std::vector<unsigned int>& pixels);
+		float					TimeTrace(unsigned int n);
+
+		/*-------------------------------------------------------*/
+		/* Reprojection Functions								 */
+		/*-------------------------------------------------------*/
+		void					ResetReprojection();
+		bool					Reproject();
+		void					TraceStrips();
+		bool					UpdateScreenQuad();
+
+		/*-------------------------------------------------------*/
+		/* Progressive Refinement Functions						 */
+		/*-------------------------------------------------------*/
+		void					StartRefinement();
+		void					Refine();
+		void					TracePhase(unsigned int phase, unsigned int row, unsigned int rows);
+
+		/*-------------------------------------------------------*/
+		/* Instrumentation Functions							 */
+		/*-------------------------------------------------------*/
+		void					ReadTraversalCounters();
+		float					GetHeatmapScale();
+
+		/*-------------------------------------------------------*/
+		/* View Functions										 */
+		/*-------------------------------------------------------*/
+		void					PackViews();
+		bool					CollectViews(bool octreeChanged);
+		void					TraceViews();
+		void					DrawViews();
+
+		/*-------------------------------------------------------*/
+		/* Render Scale Functions								 */
+		/*-------------------------------------------------------*/
+		void					UpdateRenderScale();
+		void					AllocateImages();
+
 	public:
 		/*-------------------------------------------------------*/
 		/* Rendering Functions									 */
 		/*-------------------------------------------------------*/
-		bool					IsUpdateNeeded();
 		void					Render();
+		bool					IsUpdateNeeded();
+		void					RequestRedraw() { this->redrawRequested = true; }
+
+		/*-------------------------------------------------------*/
+		/* Backend Functions									 */
+		/*-------------------------------------------------------*/
+		Backend					GetBackend() { return backend; }
+		void					SetBackend(Backend backend);
+		MeshRenderer*			GetMeshRenderer() { return meshRenderer; }
+
+		/*-------------------------------------------------------*/
+		/* Workgroup Functions									 */
+		/*-------------------------------------------------------*/
+		unsigned int			GetLocalSizeX() { return localSizeX; }
+		unsigned int			GetLocalSizeY() { return localSizeY; }
+		void					SetLocalSize(unsigned int x, unsigned int y);
+		std::vector<LocalSizeTiming>	TuneLocalSize(unsigned int n);
+
+		/*-------------------------------------------------------*/
+		/* Beam Optimization Functions							 */
+		/*-------------------------------------------------------*/
+		bool					GetBeamOptimization() { return beamOptimization; }
+		void					SetBeamOptimization(bool beamOptimization) { this->beamOptimization = beamOptimization; }
+		unsigned int			ValidateBeam(TraversalStats& single, TraversalStats& beam);
+
+		/*-------------------------------------------------------*/
+		/* Traversal Functions									 */
+		/*-------------------------------------------------------*/
+		unsigned int			ValidateTraversal(unsigned int& cpuMismatches);
+
+		/*-------------------------------------------------------*/
+		/* Progressive Refinement Functions						 */
+		/*-------------------------------------------------------*/
+		bool					GetProgressive() { return progressive; }
+		void					SetProgressive(bool progressive);
+		bool					IsRefining();
+		void					SetRefineBudget(unsigned int pixels) { this->refineBudget = pixels; }
+
+		/*-------------------------------------------------------*/
+		/* View Functions										 */
+		/*-------------------------------------------------------*/
+		int						AddView(Camera* camera, glm::vec2 position, float scale, unsigned int interval);
+		void					RemoveView(unsigned int i);
+		unsigned int			GetViewCount() { return (unsigned int)views.size(); }
+		void					ReadViewImage(unsigned int i, std::vector<unsigned int>& pixels);
+
+		/*-------------------------------------------------------*/
+		/* Render Scale Functions								 */
+		/*-------------------------------------------------------*/
+		float					GetRenderScale() { return renderScale; }
+		void					SetRenderScale(float scale);
+		bool					GetAdaptiveResolution() { return adaptiveResolution; }
+		void					SetAdaptiveResolution(bool adaptiveResolution) { this->adaptiveResolution = adaptiveResolution; }
+		float					GetTraceBudget() { return traceBudget; }
+		void					SetTraceBudget(float ms) { this->traceBudget = ms; }
+
+		/*-------------------------------------------------------*/
+		/* Reprojection Functions								 */
+		/*-------------------------------------------------------*/
+		bool					GetReprojection() { return reprojection; }
+		void					SetReprojection(bool reprojection);
+		unsigned int			ValidateReprojection();
+
+		/*-------------------------------------------------------*/
+		/* Statistics Functions									 */
+		/*-------------------------------------------------------*/
+		void					SetCountSteps(bool countSteps) { this->countSteps = countSteps; }
+		TraversalStats			ReadTraversalStats();
+		GpuTimer&				GetGpuTimer() { return gpuTimer; }
+		RenderGraph&			GetRenderGraph() { return graph; }
+
+		/*-------------------------------------------------------*/
+		/* Instrumentation Functions							 */
+		/*-------------------------------------------------------*/
+		bool					GetInstrumented() { return instrumented; }
+		void					SetInstrumented(bool instrumented);
+		Heatmap					GetHeatmap() { return heatmap; }
+		void					SetHeatmap(Heatmap heatmap);
+		TraversalCounters		GetTraversalCounters() { return traversalCounters; }
 
 		/*-------------------------------------------------------*/
-		/* Constructor											 */
+		/* Constructor & Deconstructor							 */
 		/*-------------------------------------------------------*/
-		Renderer(Camera* camera, Octree* octree);
+		Renderer(Camera* camera, OctreeBuffer* buffer);
+		~Renderer();
 	};
 }
 
@@ -0,0 +1,452 @@
+#include "rendergraph.h"
+
+#include <iostream>
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Render Graph																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Utility Functions													 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		How many frames a transient can sit in the pool unused before we
+		delete it.
+	*/
+	const unsigned int POOL_FRAMES = 8;
+
+	/*
+		Whether an access writes. Transfers might go either way, so we
+		take them as writes to be safe.
+	*/
+	bool IsWrite(Access access)
+	{
+		return (access == Access::ImageWrite) || (access == Access::StorageWrite) || (access == Access::Transfer) || (access == Access::RenderTarget);
+	}
+
+	/*
+		Whether an access is a shader write, which later accesses need a
+		barrier to see.
+	*/
+	bool IsShaderWrite(Access access)
+	{
+		return (access == Access::ImageWrite) || (access == Access::StorageWrite);
+	}
+
+	/*
+		The barrier bit that makes shader writes visible to an access.
+	*/
+	GLbitfield BarrierBit(Access access, bool texture)
+	{
+		switch (access)
+		{
+		case Access::ImageRead:
+		case Access::ImageWrite:	return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		case Access::StorageRead:
+		case Access::StorageWrite:	return GL_SHADER_STORAGE_BARRIER_BIT;
+		case Access::Uniform:		return GL_UNIFORM_BARRIER_BIT;
+		case Access::Sampled:		return GL_TEXTURE_FETCH_BARRIER_BIT;
+		case Access::Transfer:		return texture ? GL_TEXTURE_UPDATE_BARRIER_BIT : GL_BUFFER_UPDATE_BARRIER_BIT;
+		case Access::RenderTarget:	return GL_FRAMEBUFFER_BARRIER_BIT;
+		}
+		return GL_ALL_BARRIER_BITS;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Render Graph															 */
+	/*-----------------------------------------------------------------------*/
+	/*-----------------------------------------------------*/
+	/* Resource Functions								   */
+	/*-----------------------------------------------------*/
+	/* ImportTexture --------------------------------------*/
+	/*
+		Imports a texture we don't own. This has to happen
+		before any transients are made, and lasts for as long
+		as the graph does (see SetImport if it's replaced).
+
+		Input: Texture ID
+		Output: Handle
+	*/
+	ResourceHandle RenderGraph::ImportTexture(GLuint id)
+	{
+		if (resources.size() != nImported) std::cout << "ERROR::RENDERGRAPH::IMPORT_AFTER_TRANSIENT" << std::endl;
+
+		resources.push_back({ true, true, id, { 0, 0, 0 }, 0, false, 0 });
+		nImported = (unsigned int)resources.size();
+		return nImported - 1;
+	}
+
+	/* ImportBuffer ---------------------------------------*/
+	/*
+		Same as ImportTexture, for buffers.
+
+		Input: Buffer ID
+		Output: Handle
+	*/
+	ResourceHandle RenderGraph::ImportBuffer(GLuint id)
+	{
+		if (resources.size() != nImported) std::cout << "ERROR::RENDERGRAPH::IMPORT_AFTER_TRANSIENT" << std::endl;
+
+		resources.push_back({ true, false, id, { 0, 0, 0 }, 0, false, 0 });
+		nImported = (unsigned int)resources.size();
+		return nImported - 1;
+	}
+
+	/* CreateTexture --------------------------------------*/
+	/*
+		Declares a texture that only lives for this frame.
+		It doesn't get an ID until the first pass that uses
+		it runs, so Get it from inside a pass.
+
+		Input: Description
+		Output: Handle
+	*/
+	ResourceHandle RenderGraph::CreateTexture(TextureDesc desc)
+	{
+		resources.push_back({ false, true, 0, desc, 0, false, 0 });
+		return (ResourceHandle)resources.size() - 1;
+	}
+
+	/* CreateBuffer ---------------------------------------*/
+	/*
+		Same as CreateTexture, for buffers.
+
+		Input: Size in bytes
+		Output: Handle
+	*/
+	ResourceHandle RenderGraph::CreateBuffer(GLsizeiptr size)
+	{
+		resources.push_back({ false, false, 0, { 0, 0, 0 }, size, false, 0 });
+		return (ResourceHandle)resources.size() - 1;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Pass Functions									   */
+	/*-----------------------------------------------------*/
+	/* AddPass --------------------------------------------*/
+	/*
+		Adds a pass to this frame. It runs in Execute, not
+		here.
+
+		Input: Name (must live forever), uses & the function
+			   that issues its GL commands
+		Output: None
+	*/
+	void RenderGraph::AddPass(const char* name, std::vector<Use> uses, std::function<void()> execute)
+	{
+		passes.push_back({ name, uses, execute });
+	}
+
+	/* Execute --------------------------------------------*/
+	/*
+		Runs this frame's passes and starts on the next.
+
+		We keep count of how many of their uses each pass is
+		waiting on to run and how many uses each transient
+		has left, so we know when a pass can go and when a
+		transient can go back to the pool.
+
+		Input: GPU timer for the pass timings
+		Output: None
+	*/
+	void RenderGraph::Execute(GpuTimer& timer)
+	{
+		PROFILE_SCOPE("RenderGraph::Execute");
+
+		unsigned int n = (unsigned int)passes.size();
+		std::vector<bool> needed = Cull();
+
+		std::vector<std::vector<unsigned int>> after(n);
+		std::vector<unsigned int> waiting(n, 0);
+		std::vector<unsigned int> usesLeft(resources.size(), 0);
+		unsigned int remaining = 0;
+
+		for (unsigned int i = 0; i < n; i++)
+		{
+			if (!needed[i]) continue;
+
+			remaining++;
+			for (const Use& use : passes[i].uses) usesLeft[use.resource]++;
+
+			for (unsigned int j = 0; j < i; j++)
+			{
+				if (!needed[j] || !Conflicts(passes[j], passes[i])) continue;
+
+				after[j].push_back(i);
+				waiting[i]++;
+			}
+		}
+
+		this->frame++;
+		this->nBarriers = 0;
+		executed.clear();
+
+		while (remaining > 0)
+		{
+			/*
+				Of the passes that are ready, the first that
+				needs no barrier, or failing that the first.
+			*/
+			int next = -1;
+			for (unsigned int i = 0; i < n; i++)
+			{
+				if (!needed[i] || waiting[i] > 0) continue;
+
+				if (next < 0) next = i;
+				if (BarrierBits(passes[i]) == 0)
+				{
+					next = i;
+					break;
+				}
+			}
+
+			Pass& pass = passes[next];
+
+			for (const Use& use : pass.uses)
+			{
+				Resource& resource = resources[use.resource];
+				if (!resource.imported && resource.id == 0) Acquire(resource);
+			}
+
+			Barrier(BarrierBits(pass));
+
+			{
+				PROFILE_SCOPE(pass.name);
+				GpuScope scope(timer, pass.name);
+				pass.execute();
+			}
+
+			for (const Use& use : pass.uses)
+			{
+				Resource& resource = resources[use.resource];
+
+				if (IsShaderWrite(use.access))
+				{
+					resource.written = true;
+					resource.covered = 0;
+				}
+
+				if (--usesLeft[use.resource] == 0 && !resource.imported) Release(resource);
+			}
+
+			for (unsigned int i : after[next]) waiting[i]--;
+			needed[next] = false;
+			remaining--;
+
+			executed.push_back(pass.name);
+		}
+
+		passes.clear();
+		resources.resize(nImported);
+		TrimPool();
+	}
+
+	/*-----------------------------------------------------*/
+	/* Scheduling Functions								   */
+	/*-----------------------------------------------------*/
+	/* Cull -----------------------------------------------*/
+	/*
+		Works back from the last pass. A pass is needed if
+		it writes something imported, or something a needed
+		pass after it reads.
+
+		Input: None
+		Output: Whether each pass is needed
+	*/
+	std::vector<bool> RenderGraph::Cull()
+	{
+		std::vector<bool> needed(passes.size(), false);
+		std::vector<bool> readLater(resources.size(), false);
+
+		for (int i = (int)passes.size() - 1; i >= 0; i--)
+		{
+			for (const Use& use : passes[i].uses)
+			{
+				if (IsWrite(use.access) && (resources[use.resource].imported || readLater[use.resource])) needed[i] = true;
+			}
+
+			if (!needed[i]) continue;
+
+			for (const Use& use : passes[i].uses)
+			{
+				if (!IsWrite(use.access)) readLater[use.resource] = true;
+			}
+		}
+
+		return needed;
+	}
+
+	/* Conflicts ------------------------------------------*/
+	/*
+		Whether two passes use the same resource with at
+		least one of them writing it, in which case the one
+		declared first has to run first.
+
+		Input: The two passes
+		Output: Whether they conflict
+	*/
+	bool RenderGraph::Conflicts(const Pass& a, const Pass& b)
+	{
+		for (const Use& x : a.uses)
+		{
+			for (const Use& y : b.uses)
+			{
+				if (x.resource == y.resource && (IsWrite(x.access) || IsWrite(y.access))) return true;
+			}
+		}
+
+		return false;
+	}
+
+	/* BarrierBits ----------------------------------------*/
+	/*
+		The barriers a pass needs before it can run: one for
+		each way it gets at something a shader has written,
+		unless there's been that barrier since.
+
+		Input: Pass
+		Output: Barrier bits (zero for none)
+	*/
+	GLbitfield RenderGraph::BarrierBits(const Pass& pass)
+	{
+		GLbitfield bits = 0;
+
+		for (const Use& use : pass.uses)
+		{
+			const Resource& resource = resources[use.resource];
+			if (resource.written) bits |= BarrierBit(use.access, resource.texture) & ~resource.covered;
+		}
+
+		return bits;
+	}
+
+	/* Barrier --------------------------------------------*/
+	/*
+		Issues a barrier. It covers every shader write so
+		far, not just the ones we asked for it for, so
+		everything written (including what's in the pool)
+		is covered.
+
+		Input: Barrier bits
+		Output: None
+	*/
+	void RenderGraph::Barrier(GLbitfield bits)
+	{
+		if (bits == 0) return;
+
+		glMemoryBarrier(bits);
+		this->nBarriers++;
+
+		for (Resource& resource : resources) resource.covered |= bits;
+		for (PoolEntry& entry : pool) entry.covered |= bits;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Pool Functions									   */
+	/*-----------------------------------------------------*/
+	/* Acquire --------------------------------------------*/
+	/*
+		Gives a transient a texture or buffer, from the pool
+		if there's one that fits. Whatever was last written
+		to it still needs its barriers, so those come along.
+
+		Input: Transient
+		Output: None
+	*/
+	void RenderGraph::Acquire(Resource& resource)
+	{
+		for (size_t i = 0; i < pool.size(); i++)
+		{
+			PoolEntry& entry = pool[i];
+			if (entry.texture != resource.texture) continue;
+			if (resource.texture ? !(entry.desc == resource.desc) : (entry.size != resource.size)) continue;
+
+			resource.id = entry.id;
+			resource.written = entry.written;
+			resource.covered = entry.covered;
+
+			pool.erase(pool.begin() + i);
+			return;
+		}
+
+		if (resource.texture)
+		{
+			glGenTextures(1, &resource.id);
+			glBindTexture(GL_TEXTURE_2D, resource.id);
+			glTexStorage2D(GL_TEXTURE_2D, 1, resource.desc.format, resource.desc.width, resource.desc.height);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+		else
+		{
+			glGenBuffers(1, &resource.id);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, resource.id);
+			glBufferData(GL_COPY_WRITE_BUFFER, resource.size, nullptr, GL_DYNAMIC_COPY);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+	}
+
+	/* Release --------------------------------------------*/
+	/*
+		Puts a transient's texture or buffer back in the
+		pool.
+
+		Input: Transient
+		Output: None
+	*/
+	void RenderGraph::Release(Resource& resource)
+	{
+		pool.push_back({ resource.texture, resource.id, resource.desc, resource.size, frame, resource.written, resource.covered });
+		resource.id = 0;
+	}
+
+	/* TrimPool -------------------------------------------*/
+	/*
+		Deletes whatever's sat in the pool for more than
+		POOL_FRAMES frames.
+
+		Input: None
+		Output: None
+	*/
+	void RenderGraph::TrimPool()
+	{
+		for (size_t i = 0; i < pool.size();)
+		{
+			if (frame - pool[i].lastFrame <= POOL_FRAMES)
+			{
+				i++;
+				continue;
+			}
+
+			if (pool[i].texture) glDeleteTextures(1, &pool[i].id);
+			else glDeleteBuffers(1, &pool[i].id);
+
+			pool.erase(pool.begin() + i);
+		}
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor & Deconstructor						   */
+	/*-----------------------------------------------------*/
+	RenderGraph::RenderGraph()
+	{
+		this->nImported = 0;
+		this->nBarriers = 0;
+		this->frame = 0;
+	}
+
+	RenderGraph::~RenderGraph()
+	{
+		for (PoolEntry& entry : pool)
+		{
+			if (entry.texture) glDeleteTextures(1, &entry.id);
+			else glDeleteBuffers(1, &entry.id);
+		}
+	}
+}
\ No newline at end of file
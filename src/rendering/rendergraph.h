@@ -0,0 +1,216 @@
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <glad/glad.h>
+
+#include "gputimer.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Render Graph																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Access																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		How a pass uses a resource. What a shader writes (ImageWrite and
+		StorageWrite) isn't visible to anything after it until there's
+		been a glMemoryBarrier, with a bit that depends on how the next
+		pass gets at it. Transfer is anything GL does itself, like
+		glGetTexImage or glBufferSubData, and RenderTarget is drawing
+		into it.
+	*/
+	enum class Access
+	{
+		ImageRead,
+		ImageWrite,
+		StorageRead,
+		StorageWrite,
+		Uniform,
+		Sampled,
+		Transfer,
+		RenderTarget
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Texture Description													 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		What a transient texture has to be. Two transients with the same
+		description can share a texture, as long as they aren't both in
+		use at once.
+	*/
+	struct TextureDesc
+	{
+		GLsizei			width;
+		GLsizei			height;
+		GLenum			format;
+
+		bool operator==(const TextureDesc& rhs) const noexcept
+		{
+			return (width == rhs.width) && (height == rhs.height) && (format == rhs.format);
+		}
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Use																	 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		One resource a pass uses, and how.
+	*/
+	typedef unsigned int ResourceHandle;
+
+	struct Use
+	{
+		ResourceHandle	resource;
+		Access			access;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Render Graph															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		A frame's worth of GPU passes, each declaring which resources it
+		reads and writes. Rather than every pass putting in barriers of
+		its own (and either missing one or putting in more than it needs
+		to be safe), Execute works out which are needed from the uses.
+
+		Imported resources are the ones that live beyond the frame, like
+		the octree's buffer or the traced image. We remember what's been
+		written to them and which barriers have happened since across
+		frames, so a pass reading something traced a few frames ago
+		doesn't wait again. They're imported once and stay imported.
+
+		Transient resources only live for the frame. Execute gives each
+		one a texture or buffer from the pool at its first use and puts
+		it back after its last, so later passes (and later frames) reuse
+		them rather than allocating their own. Anything left in the pool
+		unused for POOL_FRAMES frames is deleted.
+
+		Passes run in an order that keeps every read after the writes
+		before it and every write after the reads and writes before it,
+		as declared. Within that, we run whichever ready pass needs the
+		fewest barriers first, so passes that don't depend on a write go
+		ahead of the barrier and the ones that do share it. A pass that
+		doesn't write anything imported, or anything a pass we do run
+		reads, is culled.
+
+		Each pass is timed on the CPU and GPU under its name, which must
+		live forever (a string literal, say).
+	*/
+	class RenderGraph
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Resource											   */
+		/*-----------------------------------------------------*/
+		struct Resource
+		{
+			bool				imported;
+			bool				texture;
+			GLuint				id;
+			TextureDesc			desc;
+			GLsizeiptr			size;
+
+			bool				written;
+			GLbitfield			covered;
+		};
+
+		/*-----------------------------------------------------*/
+		/* Pass												   */
+		/*-----------------------------------------------------*/
+		struct Pass
+		{
+			const char*				name;
+			std::vector<Use>		uses;
+			std::function<void()>	execute;
+		};
+
+		/*-----------------------------------------------------*/
+		/* Pool Entry										   */
+		/*-----------------------------------------------------*/
+		struct PoolEntry
+		{
+			bool				texture;
+			GLuint				id;
+			TextureDesc			desc;
+			GLsizeiptr			size;
+			unsigned int		lastFrame;
+
+			bool				written;
+			GLbitfield			covered;
+		};
+
+		/*-----------------------------------------------------*/
+		/* Resources										   */
+		/*-----------------------------------------------------*/
+		std::vector<Resource>	resources;
+		unsigned int			nImported;
+
+		/*-----------------------------------------------------*/
+		/* Passes											   */
+		/*-----------------------------------------------------*/
+		std::vector<Pass>		passes;
+		std::vector<const char*>	executed;
+		unsigned int			nBarriers;
+
+		/*-----------------------------------------------------*/
+		/* Pool												   */
+		/*-----------------------------------------------------*/
+		std::vector<PoolEntry>	pool;
+		unsigned int			frame;
+
+		/*-----------------------------------------------------*/
+		/* Scheduling Functions								   */
+		/*-----------------------------------------------------*/
+		std::vector<bool>		Cull();
+		bool					Conflicts(const Pass& a, const Pass& b);
+		GLbitfield				BarrierBits(const Pass& pass);
+		void					Barrier(GLbitfield bits);
+
+		/*-----------------------------------------------------*/
+		/* Pool Functions									   */
+		/*-----------------------------------------------------*/
+		void					Acquire(Resource& resource);
+		void					Release(Resource& resource);
+		void					TrimPool();
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Resource Functions								   */
+		/*-----------------------------------------------------*/
+		ResourceHandle			ImportTexture(GLuint id);
+		ResourceHandle			ImportBuffer(GLuint id);
+		ResourceHandle			CreateTexture(TextureDesc desc);
+		ResourceHandle			CreateBuffer(GLsizeiptr size);
+		GLuint					Get(ResourceHandle resource) { return resources[resource].id; }
+		void					SetImport(ResourceHandle resource, GLuint id) { resources[resource].id = id; }
+
+		/*-----------------------------------------------------*/
+		/* Pass Functions									   */
+		/*-----------------------------------------------------*/
+		void					AddPass(const char* name, std::vector<Use> uses, std::function<void()> execute);
+		void					Execute(GpuTimer& timer);
+
+		/*-----------------------------------------------------*/
+		/* Statistics Functions								   */
+		/*-----------------------------------------------------*/
+		const std::vector<const char*>&	GetExecutedPasses() { return executed; }
+		unsigned int			GetBarrierCount() { return nBarriers; }
+		unsigned int			GetPoolSize() { return (unsigned int)pool.size(); }
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		RenderGraph();
+		~RenderGraph();
+	};
+}
+
+#endif
\ No newline at end of file
@@ -24,6 +24,11 @@ namespace Winedark
 		glUniform1i(glGetUniformLocation(id, name.c_str()), (int)value);
 	}
 
+	void SetUint(GLuint id, const std::string& name, unsigned int value)
+	{
+		glUniform1ui(glGetUniformLocation(id, name.c_str()), value);
+	}
+
 	void SetInt(GLuint id, const std::string& name, int value)
 	{
 		glUniform1i(glGetUniformLocation(id, name.c_str()), value);
@@ -80,9 +85,73 @@ namespace Winedark
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ in " << path << std::endl;
 		}
 
+		std::string directory = path;
+		size_t slash = directory.find_last_of("/\\");
+		directory = (slash == std::string::npos) ? "" : directory.substr(0, slash + 1);
+
+		return ResolveIncludes(code, directory);
+	}
+
+	/* ResolveIncludes --------------------------------------*/
+	/*
+		ResolveIncludes() replaces each #include "file" line
+		with the code in that file (and whatever it includes
+		in turn), relative to the given directory. GLSL has
+		no #include of its own, but this lets the shaders
+		share code with each other and with the CPU (see
+		traverse.glsl). Include guards are left to the
+		files themselves.
+
+		Input: Shader code & the directory it's in
+		Output: Shader code
+	*/
+	std::string ResolveIncludes(std::string code, const std::string& directory)
+	{
+		size_t start = 0;
+		while (start < code.size())
+		{
+			size_t end = code.find('\n', start);
+			if (end == std::string::npos) end = code.size();
+
+			std::string line = code.substr(start, end - start);
+			size_t first = line.find('"');
+			size_t last = line.rfind('"');
+
+			if (line.compare(0, 8, "#include") == 0 && first != std::string::npos && last > first)
+			{
+				std::string included = ReadCode((directory + line.substr(first + 1, last - first - 1)).c_str());
+				code.replace(start, end - start, included);
+				end = start + included.size();
+			}
+
+			start = end + 1;
+		}
+
 		return code;
 	}
 
+	/* InjectDefines ----------------------------------------*/
+	/*
+		InjectDefines() slips a #define for each of the given
+		"NAME VALUE" pairs in right after the #version line,
+		which has to stay first. This is how we pick things
+		like the compute shader's workgroup size when we load
+		it.
+
+		Input: Shader code & defines
+		Output: Shader code
+	*/
+	std::string InjectDefines(std::string code, const std::vector<std::string>& defines)
+	{
+		std::string block;
+		for (const std::string& define : defines) block += "#define " + define + "\n";
+
+		size_t line = code.find('\n');
+		if (line == std::string::npos) return code + "\n" + block;
+
+		return code.insert(line + 1, block);
+	}
+
 	/* CompileShader ----------------------------------------*/
 	/*
 		CompileShader() takes a shader type and code, then
@@ -192,18 +261,19 @@ namespace Winedark
 
 	/* Shader :: Compute ------------------------------------*/
 	/*
-		This constructor prepares a compute shader.
+		This constructor prepares a compute shader, with
+		any defines it's given.
 
-		Input: Compute Shader Code Path
+		Input: Compute Shader Code Path & Defines
 		Output: (Shader Program)
 	*/
-	Shader::Shader(std::string computePath)
+	Shader::Shader(std::string computePath, std::vector<std::string> defines)
 	{
 		/*
 			First, we read in the code and compile the
 			shader.
 		*/
-		GLuint compute = CompileShader(GL_COMPUTE_SHADER, ReadCode(computePath.c_str()));
+		GLuint compute = CompileShader(GL_COMPUTE_SHADER, InjectDefines(ReadCode(computePath.c_str()), defines));
 
 		/*
 			Next, we create the program and attach the
@@ -28,6 +28,8 @@ namespace Winedark
 	/* Compilation Functions												 */
 	/*-----------------------------------------------------------------------*/
 	std::string ReadCode(const char* path);
+	std::string ResolveIncludes(std::string code, const std::string& directory);
+	std::string InjectDefines(std::string code, const std::vector<std::string>& defines);
 	GLuint CompileShader(GLenum type, std::string code);
 	GLuint CreateProgram(std::vector<GLuint> components);
 
@@ -56,8 +58,8 @@ namespace Winedark
 		/*-----------------------------------------------------*/
 		/* Constructors										   */
 		/*-----------------------------------------------------*/
-		Shader::Shader(std::string vertexPath, std::string fragmentPath);
-		Shader::Shader(std::string computePath);
+		Shader(std::string vertexPath, std::string fragmentPath);
+		Shader(std::string computePath, std::vector<std::string> defines = {});
 	};
 }
 
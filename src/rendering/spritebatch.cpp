@@ -0,0 +1,378 @@
+#include "spritebatch.h"
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Sprite Batch																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*
+		How many segments the vertex buffer is split into. With three,
+		the GPU can be drawing from two earlier batches while we write
+		the next.
+	*/
+	const unsigned int SPRITE_SEGMENTS = 3;
+
+	/*-----------------------------------------------------------------------*/
+	/* Helper Functions														 */
+	/*-----------------------------------------------------------------------*/
+	/* Clamp16 ----------------------------------------------*/
+	/*
+		Input: Value
+		Output: The value rounded to the nearest 16-bit int
+	*/
+	static int16_t Clamp16(float v)
+	{
+		return (int16_t)std::min(std::max(std::lround(v), -32768l), 32767l);
+	}
+
+	/* Normalize16 ------------------------------------------*/
+	/*
+		Input: Value from 0 to 1
+		Output: The value as a normalized 16-bit uint
+	*/
+	static uint16_t Normalize16(float v)
+	{
+		return (uint16_t)(std::min(std::max(v, 0.0f), 1.0f) * 65535.0f + 0.5f);
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Utility Functions													 */
+	/*-----------------------------------------------------------------------*/
+	/* PackColor --------------------------------------------*/
+	/*
+		Input: Color, each channel from 0 to 1
+		Output: Packed RGBA, a byte each with red lowest
+	*/
+	unsigned int PackColor(glm::vec4 color)
+	{
+		unsigned int packed = 0;
+		for (int i = 0; i < 4; i++) packed |= (unsigned int)(std::min(std::max(color[i], 0.0f), 1.0f) * 255.0f + 0.5f) << (8 * i);
+		return packed;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Sprite Batch															 */
+	/*-----------------------------------------------------------------------*/
+	/*-----------------------------------------------------*/
+	/* Segment Functions								   */
+	/*-----------------------------------------------------*/
+	/* MapSegment -----------------------------------------*/
+	/*
+		Waits until the GPU's done with the current segment,
+		if it isn't already, and gets it ready to write.
+
+		Input: None
+		Output: The segment's first vertex
+	*/
+	SpriteVertex* SpriteBatch::MapSegment()
+	{
+		if (fences[segment] != nullptr)
+		{
+			PROFILE_SCOPE("SpriteBatch::Wait");
+
+			while (true)
+			{
+				GLenum result = glClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+				if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) break;
+			}
+
+			glDeleteSync(fences[segment]);
+			this->fences[segment] = nullptr;
+		}
+
+		GLsizeiptr segmentBytes = (GLsizeiptr)capacity * 4 * sizeof(SpriteVertex);
+		if (persistent) return mapped + (size_t)segment * capacity * 4;
+
+		/*
+			The fence has already told us the GPU's done with
+			this range, so there's no need for the driver to
+			check again.
+		*/
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		return (SpriteVertex*)glMapBufferRange(GL_ARRAY_BUFFER, segment * segmentBytes, segmentBytes,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	}
+
+	/* UnmapSegment ---------------------------------------*/
+	/*
+		Finishes writing to the current segment. A buffer
+		that's mapped for good is coherent, so there's
+		nothing to do for one of those.
+
+		Input: None
+		Output: None
+	*/
+	void SpriteBatch::UnmapSegment()
+	{
+		if (persistent) return;
+
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+
+	/*-----------------------------------------------------*/
+	/* Key Functions									   */
+	/*-----------------------------------------------------*/
+	/* MakeKey --------------------------------------------*/
+	/*
+		Sprites are drawn in the order of their keys: by
+		layer, then atlas, then the order they were added.
+		The atlas is its index in this batch's list of
+		them, so a batch can use up to 65536.
+
+		Input: Sprite & its index in the batch
+		Output: Key
+	*/
+	uint64_t SpriteBatch::MakeKey(const Sprite& sprite, unsigned int index)
+	{
+		unsigned int slot = 0;
+		while (slot < atlases.size() && atlases[slot] != sprite.atlas) slot++;
+		if (slot == atlases.size()) atlases.push_back(sprite.atlas);
+
+		uint64_t layer = (uint64_t)(std::min(std::max(sprite.layer, -32768), 32767) + 32768);
+		return (layer << 48) | ((uint64_t)slot << 32) | index;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Batch Functions									   */
+	/*-----------------------------------------------------*/
+	/* Begin ----------------------------------------------*/
+	/*
+		Starts a new batch.
+
+		Input: Screen dimensions, in pixels
+		Output: None
+	*/
+	void SpriteBatch::Begin(int width, int height)
+	{
+		sprites.clear();
+		keys.clear();
+		atlases.clear();
+
+		this->screen = { (float)width, (float)height };
+		this->drawCalls = 0;
+	}
+
+	/* Draw -----------------------------------------------*/
+	/*
+		Adds a sprite to the batch. Nothing's drawn until
+		End.
+
+		Input: Sprite
+		Output: None
+	*/
+	void SpriteBatch::Draw(const Sprite& sprite)
+	{
+		keys.push_back(MakeKey(sprite, (unsigned int)sprites.size()));
+		sprites.push_back(sprite);
+	}
+
+	/* End ------------------------------------------------*/
+	/*
+		Sorts the batch, writes it out a segment at a time
+		and draws it.
+
+		Sprites added in order (which a HUD usually is)
+		are already sorted, so we check before sorting.
+
+		Input: None
+		Output: None
+	*/
+	void SpriteBatch::End()
+	{
+		if (sprites.empty()) return;
+
+		PROFILE_SCOPE("SpriteBatch::End");
+
+		if (!std::is_sorted(keys.begin(), keys.end()))
+		{
+			PROFILE_SCOPE("SpriteBatch::Sort");
+			std::sort(keys.begin(), keys.end());
+		}
+
+		spriteShader.Use();
+		SetVector2(spriteShader.GetID(), "screen", screen);
+		SetInt(spriteShader.GetID(), "atlas", 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindVertexArray(vao);
+
+		for (size_t first = 0; first < keys.size(); first += capacity)
+		{
+			size_t count = std::min((size_t)capacity, keys.size() - first);
+
+			/*
+				Each sprite's four corners, anticlockwise from
+				the bottom left. We only ever write to the
+				mapped memory, front to back, since reading it
+				back can be very slow.
+			*/
+			{
+				PROFILE_SCOPE("SpriteBatch::Write");
+
+				SpriteVertex* v = MapSegment();
+				if (v == nullptr)
+				{
+					std::cout << "ERROR::SPRITEBATCH::MAP_FAILED" << std::endl;
+					break;
+				}
+
+				for (size_t i = 0; i < count; i++)
+				{
+					const Sprite& sprite = sprites[(uint32_t)keys[first + i]];
+
+					int16_t x0 = Clamp16(sprite.position.x);
+					int16_t y0 = Clamp16(sprite.position.y);
+					int16_t x1 = Clamp16(sprite.position.x + sprite.size.x);
+					int16_t y1 = Clamp16(sprite.position.y + sprite.size.y);
+
+					uint16_t s0 = Normalize16(sprite.region.x);
+					uint16_t t0 = Normalize16(sprite.region.y);
+					uint16_t s1 = Normalize16(sprite.region.z);
+					uint16_t t1 = Normalize16(sprite.region.w);
+
+					uint8_t r = sprite.color & 0xff;
+					uint8_t g = (sprite.color >> 8) & 0xff;
+					uint8_t b = (sprite.color >> 16) & 0xff;
+					uint8_t a = sprite.color >> 24;
+
+					v[0] = { x0, y0, s0, t0, r, g, b, a };
+					v[1] = { x1, y0, s1, t0, r, g, b, a };
+					v[2] = { x1, y1, s1, t1, r, g, b, a };
+					v[3] = { x0, y1, s0, t1, r, g, b, a };
+					v += 4;
+				}
+
+				UnmapSegment();
+			}
+
+			/*
+				Then one draw for each run of sprites on the same
+				atlas. The index buffer only covers one segment,
+				so the base vertex picks out which.
+			*/
+			size_t runStart = 0;
+			for (size_t i = 1; i <= count; i++)
+			{
+				TextureAtlas* atlas = atlases[(keys[first + runStart] >> 32) & 0xffff];
+				if (i < count && atlases[(keys[first + i] >> 32) & 0xffff] == atlas) continue;
+
+				glBindTexture(GL_TEXTURE_2D, atlas->GetID());
+				glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)((i - runStart) * 6), GL_UNSIGNED_INT,
+					(void*)(runStart * 6 * sizeof(GLuint)), (GLint)(segment * capacity * 4));
+				this->drawCalls++;
+
+				runStart = i;
+			}
+
+			this->fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			this->segment = (segment + 1) % SPRITE_SEGMENTS;
+		}
+
+		glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor & Deconstructor						   */
+	/*-----------------------------------------------------*/
+	/* Constructor ----------------------------------------*/
+	/*
+		Sprites are drawn with sprite.frag unless we're told
+		otherwise. Any other fragment shader gets the same
+		inputs and uniforms (see text.frag).
+
+		Input: Most sprites to a segment & fragment shader
+		Output: (Sprite Batch)
+	*/
+	SpriteBatch::SpriteBatch(unsigned int capacity, std::string fragmentPath) :
+		spriteShader("assets/shaders/sprite.vert", fragmentPath)
+	{
+		this->capacity = std::max(1u, capacity);
+		this->segment = 0;
+		this->drawCalls = 0;
+		this->screen = { 1.0f, 1.0f };
+		this->mapped = nullptr;
+		this->fences.assign(SPRITE_SEGMENTS, nullptr);
+
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		this->persistent = (major > 4 || (major == 4 && minor >= 4));
+
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+
+		/*
+			The vertex buffer, a segment's worth of corners for
+			each segment.
+		*/
+		GLsizeiptr bytes = (GLsizeiptr)SPRITE_SEGMENTS * this->capacity * 4 * sizeof(SpriteVertex);
+
+		glGenBuffers(1, &vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+		if (persistent)
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+			this->mapped = (SpriteVertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags);
+		}
+		else glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+
+		glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, x));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, s));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, r));
+		glEnableVertexAttribArray(2);
+
+		/*
+			The indices never change: two triangles for each
+			sprite in a segment.
+		*/
+		std::vector<GLuint> indices((size_t)this->capacity * 6);
+		for (unsigned int i = 0; i < this->capacity; i++)
+		{
+			GLuint* q = &indices[(size_t)i * 6];
+			GLuint c = i * 4;
+
+			q[0] = c; q[1] = c + 1; q[2] = c + 2;
+			q[3] = c + 2; q[4] = c + 3; q[5] = c;
+		}
+
+		glGenBuffers(1, &ibo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	/* Deconstructor --------------------------------------*/
+	SpriteBatch::~SpriteBatch()
+	{
+		for (GLsync fence : fences)
+		{
+			if (fence != nullptr) glDeleteSync(fence);
+		}
+
+		if (persistent)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, vbo);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		glDeleteBuffers(1, &vbo);
+		glDeleteBuffers(1, &ibo);
+		glDeleteVertexArrays(1, &vao);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "textureatlas.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Sprite Batch																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Sprite																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		One textured rectangle on screen. Its position (the bottom left
+		corner) and size are in pixels from the bottom left of the
+		window, and region is the rectangle of the atlas it shows, as
+		(s0, t0, s1, t1) (see TextureAtlas::GetRegion). Color is packed
+		RGBA, a byte each with red lowest (see PackColor), and tints the
+		texture. Sprites on lower layers are drawn first; on the same
+		layer, in the order they were added.
+	*/
+	struct Sprite
+	{
+		TextureAtlas*		atlas;
+		glm::vec4			region;
+		glm::vec2			position;
+		glm::vec2			size;
+		unsigned int		color;
+		int					layer;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Sprite Vertex														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		What a sprite's corners look like to the GPU: 12 bytes, against
+		the 36 of a Vertex. Positions are whole pixels, texture
+		coordinates are normalized to 16 bits (good enough for an atlas
+		up to 65536 texels on a side) and the color is a byte a channel.
+	*/
+	struct SpriteVertex
+	{
+		int16_t				x, y;
+		uint16_t			s, t;
+		uint8_t				r, g, b, a;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Utility Functions													 */
+	/*-----------------------------------------------------------------------*/
+	unsigned int PackColor(glm::vec4 color);
+
+	/*-----------------------------------------------------------------------*/
+	/* Sprite Batch															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Draws 2D sprites (the HUD, portraits, map markers) over whatever's
+		already on screen, in as few draw calls as it can. Sprites are
+		added between Begin and End, and End sorts them by layer and then
+		by atlas, writes them out and draws each run of sprites that
+		share an atlas with one call. So long as no two layers that use
+		one atlas have a layer using another between them, that's one
+		draw per atlas.
+
+		The vertices go straight into a buffer that stays mapped for
+		good (GL 4.4's buffer storage, where we have it). It's split into
+		three segments, and each End writes to the next one, so
+		we're never writing to what the GPU is still drawing from. A
+		fence on each segment makes sure of it, should the GPU fall more
+		than a couple of batches behind. Without buffer storage, each
+		segment is mapped as it's written, unsynchronized, and the
+		fences do the same job.
+
+		A batch bigger than a segment is drawn a segment at a time.
+	*/
+	class SpriteBatch
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Sprites											   */
+		/*-----------------------------------------------------*/
+		std::vector<Sprite>			sprites;
+		std::vector<uint64_t>		keys;
+		std::vector<TextureAtlas*>	atlases;
+		glm::vec2					screen;
+
+		/*-----------------------------------------------------*/
+		/* Buffers											   */
+		/*-----------------------------------------------------*/
+		GLuint						vao;
+		GLuint						vbo;
+		GLuint						ibo;
+		unsigned int				capacity;
+		bool						persistent;
+		SpriteVertex*				mapped;
+
+		/*-----------------------------------------------------*/
+		/* Segments											   */
+		/*-----------------------------------------------------*/
+		std::vector<GLsync>			fences;
+		unsigned int				segment;
+
+		/*-----------------------------------------------------*/
+		/* Stats											   */
+		/*-----------------------------------------------------*/
+		unsigned int				drawCalls;
+
+		/*-----------------------------------------------------*/
+		/* Shader											   */
+		/*-----------------------------------------------------*/
+		Shader						spriteShader;
+
+		/*-----------------------------------------------------*/
+		/* Segment Functions								   */
+		/*-----------------------------------------------------*/
+		SpriteVertex*				MapSegment();
+		void						UnmapSegment();
+
+		/*-----------------------------------------------------*/
+		/* Key Functions									   */
+		/*-----------------------------------------------------*/
+		uint64_t					MakeKey(const Sprite& sprite, unsigned int index);
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Batch Functions									   */
+		/*-----------------------------------------------------*/
+		void						Begin(int width, int height);
+		void						Draw(const Sprite& sprite);
+		void						End();
+
+		/*-----------------------------------------------------*/
+		/* Stat Functions									   */
+		/*-----------------------------------------------------*/
+		unsigned int				GetDrawCalls() { return drawCalls; }
+		unsigned int				GetCapacity() { return capacity; }
+		bool						IsPersistent() { return persistent; }
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		SpriteBatch(unsigned int capacity, std::string fragmentPath = "assets/shaders/sprite.frag");
+		~SpriteBatch();
+	};
+}
+
+#endif
\ No newline at end of file
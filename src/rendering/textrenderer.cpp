@@ -0,0 +1,283 @@
+#include "textrenderer.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Text Renderer																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*
+		A layout nobody's drawn for LAYOUT_LIFETIME frames is dropped.
+		We look for them every LAYOUT_PRUNE_INTERVAL frames, rather
+		than walk the whole cache every frame.
+	*/
+	const unsigned long long LAYOUT_LIFETIME = 300;
+	const unsigned long long LAYOUT_PRUNE_INTERVAL = 60;
+
+	/*-----------------------------------------------------------------------*/
+	/* Helper Functions														 */
+	/*-----------------------------------------------------------------------*/
+	/* DecodeUTF8 -------------------------------------------*/
+	/*
+		Reads the character starting at i and moves i past
+		it. Anything that isn't valid UTF-8 comes out as
+		U+FFFD, a byte at a time.
+
+		Input: String & where we are in it
+		Output: Unicode codepoint
+	*/
+	static unsigned int DecodeUTF8(const std::string& text, size_t& i)
+	{
+		unsigned char c = (unsigned char)text[i++];
+		if (c < 0x80) return c;
+
+		int length = (c >= 0xf0) ? 3 : (c >= 0xe0) ? 2 : (c >= 0xc0) ? 1 : -1;
+		if (length < 0 || i + length > text.size()) return 0xfffd;
+
+		unsigned int codepoint = c & (0x3f >> length);
+		for (int k = 0; k < length; k++)
+		{
+			unsigned char next = (unsigned char)text[i + k];
+			if ((next & 0xc0) != 0x80) return 0xfffd;
+			codepoint = (codepoint << 6) | (next & 0x3f);
+		}
+
+		i += length;
+		return codepoint;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Text Renderer														 */
+	/*-----------------------------------------------------------------------*/
+	/*-----------------------------------------------------*/
+	/* Layout Functions									   */
+	/*-----------------------------------------------------*/
+	/* GetLayout ------------------------------------------*/
+	/*
+		Input: String
+		Output: Its layout, shaped now if it isn't cached
+	*/
+	TextLayout& TextRenderer::GetLayout(const std::string& text)
+	{
+		auto it = layouts.find(text);
+		if (it != layouts.end())
+		{
+			this->layoutHits++;
+			it->second.lastUsed = cache->GetFrame();
+			return it->second;
+		}
+
+		this->layoutMisses++;
+
+		TextLayout& layout = layouts[text];
+		Shape(text, layout);
+		layout.lastUsed = cache->GetFrame();
+		return layout;
+	}
+
+	/* Shape ----------------------------------------------*/
+	/*
+		Lays a string out, a glyph at a time along the
+		baseline, with kerning between each pair. A newline
+		goes down a line and back to the start. Glyphs with
+		nothing to draw (spaces) just move the pen.
+
+		Input: String & layout to fill in
+		Output: None
+	*/
+	void TextRenderer::Shape(const std::string& text, TextLayout& layout)
+	{
+		PROFILE_SCOPE("TextRenderer::Shape");
+
+		layout.glyphs.clear();
+		layout.min = { 0.0f, 0.0f };
+		layout.max = { 0.0f, 0.0f };
+		layout.width = 0.0f;
+		layout.lines = 1;
+
+		float x = 0.0f;
+		float y = 0.0f;
+		int previous = -1;
+		bool empty = true;
+
+		for (size_t i = 0; i < text.size();)
+		{
+			unsigned int codepoint = DecodeUTF8(text, i);
+
+			if (codepoint == '\n')
+			{
+				x = 0.0f;
+				y -= cache->GetLineHeight();
+				previous = -1;
+				layout.lines++;
+				continue;
+			}
+
+			unsigned int id = cache->GetGlyphID(codepoint);
+			if (previous >= 0) x += cache->GetKerning(previous, id);
+			previous = id;
+
+			Glyph& glyph = cache->GetGlyph(id);
+			if (glyph.width > 0 && glyph.height > 0)
+			{
+				glm::vec2 low = { x + glyph.left, y + glyph.top - glyph.height };
+				glm::vec2 high = { x + glyph.left + glyph.width, y + glyph.top };
+
+				layout.min = empty ? low : glm::min(layout.min, low);
+				layout.max = empty ? high : glm::max(layout.max, high);
+				empty = false;
+
+				layout.glyphs.push_back({ id, x, y });
+			}
+
+			x += glyph.advance;
+			layout.width = std::max(layout.width, x);
+		}
+	}
+
+	/* PruneLayouts ---------------------------------------*/
+	/*
+		Drops the layouts that haven't been drawn lately.
+
+		Input: None
+		Output: None
+	*/
+	void TextRenderer::PruneLayouts()
+	{
+		unsigned long long frame = cache->GetFrame();
+
+		for (auto it = layouts.begin(); it != layouts.end();)
+		{
+			if (it->second.lastUsed + LAYOUT_LIFETIME < frame) it = layouts.erase(it);
+			else ++it;
+		}
+	}
+
+	/*-----------------------------------------------------*/
+	/* Batch Functions									   */
+	/*-----------------------------------------------------*/
+	/* Begin ----------------------------------------------*/
+	/*
+		Starts a new frame of text.
+
+		Input: Screen dimensions, in pixels
+		Output: None
+	*/
+	void TextRenderer::Begin(int width, int height)
+	{
+		cache->NextFrame();
+		if (cache->GetFrame() % LAYOUT_PRUNE_INTERVAL == 0) PruneLayouts();
+
+		this->screen = { (float)width, (float)height };
+		batch->Begin(width, height);
+	}
+
+	/* DrawText -------------------------------------------*/
+	/*
+		Adds a string to the batch, with the start of its
+		first line's baseline at the given position (in
+		pixels from the bottom left). Strings entirely off
+		screen are skipped.
+
+		Input: String, position, size (the font's pixel
+			   size to draw it at), packed color & layer
+		Output: None
+	*/
+	void TextRenderer::DrawText(const std::string& text, glm::vec2 position, float size, unsigned int color, int layer)
+	{
+		TextLayout& layout = GetLayout(text);
+		if (layout.glyphs.empty()) return;
+
+		float scale = size / cache->GetPixelSize();
+		glm::vec2 low = position + layout.min * scale;
+		glm::vec2 high = position + layout.max * scale;
+		if (high.x < 0.0f || high.y < 0.0f || low.x > screen.x || low.y > screen.y) return;
+
+		Sprite sprite;
+		sprite.atlas = cache->GetPage();
+		sprite.color = color;
+		sprite.layer = layer;
+
+		for (const PlacedGlyph& placed : layout.glyphs)
+		{
+			if (!cache->Use(placed.id, sprite.region)) continue;
+
+			Glyph& glyph = cache->GetGlyph(placed.id);
+			sprite.position = position + glm::vec2(placed.x + glyph.left, placed.y + glyph.top - glyph.height) * scale;
+			sprite.size = glm::vec2((float)glyph.width, (float)glyph.height) * scale;
+			batch->Draw(sprite);
+		}
+	}
+
+	/* End ------------------------------------------------*/
+	/*
+		Draws everything added since Begin.
+
+		Input: None
+		Output: None
+	*/
+	void TextRenderer::End()
+	{
+		PROFILE_SCOPE("TextRenderer::End");
+		batch->End();
+	}
+
+	/*-----------------------------------------------------*/
+	/* Measure Functions								   */
+	/*-----------------------------------------------------*/
+	/* Measure --------------------------------------------*/
+	/*
+		Input: String & size to draw it at
+		Output: How wide its longest line is and how tall
+				all its lines are, in pixels
+	*/
+	glm::vec2 TextRenderer::Measure(const std::string& text, float size)
+	{
+		TextLayout& layout = GetLayout(text);
+		float scale = size / cache->GetPixelSize();
+
+		return { layout.width * scale, layout.lines * cache->GetLineHeight() * scale };
+	}
+
+	/* GetLineHeight --------------------------------------*/
+	/*
+		Input: Size to draw text at
+		Output: How far apart lines are, in pixels
+	*/
+	float TextRenderer::GetLineHeight(float size)
+	{
+		return cache->GetLineHeight() * size / cache->GetPixelSize();
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor & Deconstructor						   */
+	/*-----------------------------------------------------*/
+	/* Constructor ----------------------------------------*/
+	/*
+		Input: Font file, size to render glyphs at, most
+			   glyphs to keep rendered & most glyphs to a
+			   draw call
+		Output: (Text Renderer)
+	*/
+	TextRenderer::TextRenderer(const char* fontPath, unsigned int pixelSize, unsigned int capacity, unsigned int maxGlyphs)
+	{
+		this->cache = new GlyphCache(fontPath, pixelSize, capacity);
+		this->batch = new SpriteBatch(maxGlyphs, "assets/shaders/text.frag");
+		this->layoutHits = 0;
+		this->layoutMisses = 0;
+		this->screen = { 1.0f, 1.0f };
+	}
+
+	/* Deconstructor --------------------------------------*/
+	TextRenderer::~TextRenderer()
+	{
+		delete batch;
+		delete cache;
+	}
+}
\ No newline at end of file
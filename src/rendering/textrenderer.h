@@ -0,0 +1,119 @@
+#ifndef TEXTRENDERER_H
+#define TEXTRENDERER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "glyphcache.h"
+#include "spritebatch.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Text Renderer																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Text Layout															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		A string, shaped and laid out: which glyph goes where, relative
+		to the start of its first line's baseline, in pixels at the
+		glyph cache's size. Min and max are the corners of the box
+		around every glyph's distance field, for culling; width and
+		lines are how far the pen went, for measuring.
+	*/
+	struct PlacedGlyph
+	{
+		unsigned int		id;
+		float				x, y;
+	};
+
+	struct TextLayout
+	{
+		std::vector<PlacedGlyph>	glyphs;
+		glm::vec2					min, max;
+		float						width;
+		unsigned int				lines;
+		unsigned long long			lastUsed;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Text Renderer														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Draws text in one font, from a GlyphCache, at any size. Like the
+		sprite batch it's built on, text is added between Begin and End,
+		and it all goes out in one draw (text.frag turns the distance
+		fields back into edges).
+
+		Shaping here is just mapping characters (UTF-8) to glyphs and
+		applying the font's kerning; there's no ligatures or complex
+		scripts. Layouts are cached by string, so a string that's drawn
+		every frame (a line of a log, say) is only shaped once, and only
+		looked up in a hash map after that. Layouts nobody's drawn for a
+		while are dropped.
+	*/
+	class TextRenderer
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Glyphs											   */
+		/*-----------------------------------------------------*/
+		GlyphCache*					cache;
+		SpriteBatch*				batch;
+
+		/*-----------------------------------------------------*/
+		/* Layouts											   */
+		/*-----------------------------------------------------*/
+		std::unordered_map<std::string, TextLayout>	layouts;
+		unsigned long long			layoutHits;
+		unsigned long long			layoutMisses;
+
+		/*-----------------------------------------------------*/
+		/* Screen											   */
+		/*-----------------------------------------------------*/
+		glm::vec2					screen;
+
+		/*-----------------------------------------------------*/
+		/* Layout Functions									   */
+		/*-----------------------------------------------------*/
+		TextLayout&					GetLayout(const std::string& text);
+		void						Shape(const std::string& text, TextLayout& layout);
+		void						PruneLayouts();
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Batch Functions									   */
+		/*-----------------------------------------------------*/
+		void						Begin(int width, int height);
+		void						DrawText(const std::string& text, glm::vec2 position, float size, unsigned int color, int layer = 0);
+		void						End();
+
+		/*-----------------------------------------------------*/
+		/* Measure Functions								   */
+		/*-----------------------------------------------------*/
+		glm::vec2					Measure(const std::string& text, float size);
+		float						GetLineHeight(float size);
+
+		/*-----------------------------------------------------*/
+		/* Stat Functions									   */
+		/*-----------------------------------------------------*/
+		GlyphCache*					GetGlyphCache() { return cache; }
+		SpriteBatch*				GetSpriteBatch() { return batch; }
+		unsigned long long			GetLayoutHits() { return layoutHits; }
+		unsigned long long			GetLayoutMisses() { return layoutMisses; }
+		size_t						GetLayoutCount() { return layouts.size(); }
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		TextRenderer(const char* fontPath, unsigned int pixelSize = 32, unsigned int capacity = 1024, unsigned int maxGlyphs = 65536);
+		~TextRenderer();
+	};
+}
+
+#endif
\ No newline at end of file
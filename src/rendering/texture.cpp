@@ -21,4 +21,17 @@ namespace Winedark
 		stbi_set_flip_vertically_on_load(true);
 		this->data = stbi_load(path, &width, &height, &channels, 0);
 	}
+
+	/*
+		Wraps RGBA pixels we already have, bottom row first.
+		They aren't copied, so they have to outlive the
+		texture.
+	*/
+	Texture::Texture(int width, int height, unsigned char* data)
+	{
+		this->width = width;
+		this->height = height;
+		this->data = data;
+		this->atlasIndex = 0;
+	}
 }
\ No newline at end of file
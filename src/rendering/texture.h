@@ -52,7 +52,7 @@ namespace Winedark
 		/* Constructors										 */
 		/*---------------------------------------------------*/
 		Texture(const char* path);
-		// ...
+		Texture(int width, int height, unsigned char* data);
 	};
 }
 
@@ -81,10 +81,79 @@ namespace Winedark
 	}
 
 	/*---------------------------------------------------*/
-	/* Constructor										 */
+	/* Page Functions									 */
 	/*---------------------------------------------------*/
-	/*TextureAtlas::TextureAtlas()
+	/*
+		Rather than build the atlas from a list of textures,
+		a page is allocated empty and filled in a rectangle
+		at a time, for things that come and go (glyphs, say).
+		Allocating throws away whatever was in it.
+	*/
+	void TextureAtlas::Allocate(int w, int h, GLint internalFormat, GLenum format, GLint filter)
 	{
+		this->width = w;
+		this->height = h;
+
+		glBindTexture(GL_TEXTURE_2D, id);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	/*
+		Rows of data are tightly packed, bottom first, which
+		isn't the 4-byte alignment GL assumes.
+	*/
+	void TextureAtlas::Upload(int x, int y, int w, int h, GLenum format, const unsigned char* data)
+	{
+		GLint alignment;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		glBindTexture(GL_TEXTURE_2D, id);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, format, GL_UNSIGNED_BYTE, data);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+	}
 
-	}*/
+	/*---------------------------------------------------*/
+	/* Region Functions									 */
+	/*---------------------------------------------------*/
+	/*
+		Where a texture ended up in the atlas, as texture
+		coordinates (s0, t0, s1, t1). Only good until the
+		next Build.
+	*/
+	glm::vec4 TextureAtlas::GetRegion(Texture* texture)
+	{
+		if (width == 0 || height == 0) return { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		return { 0.0f, (float)texture->GetAtlasIndex() / height,
+				 (float)texture->GetWidth() / width, (float)(texture->GetAtlasIndex() + texture->GetHeight()) / height };
+	}
+
+	/*---------------------------------------------------*/
+	/* Constructor & Deconstructor						 */
+	/*---------------------------------------------------*/
+	TextureAtlas::TextureAtlas()
+	{
+		GLuint texture;
+		glGenTextures(1, &texture);
+
+		this->id = texture;
+		this->width = 0;
+		this->height = 0;
+	}
+
+	TextureAtlas::~TextureAtlas()
+	{
+		GLuint texture = id;
+		glDeleteTextures(1, &texture);
+	}
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 #include <GLFW/glfw3.h>
 
 #include "texture.h"
@@ -59,9 +60,25 @@ namespace Winedark
 		void				Build(std::vector<Texture*> textures);
 
 		/*---------------------------------------------------*/
-		/* Constructor										 */
+		/* Page Functions									 */
 		/*---------------------------------------------------*/
-		// TextureAtlas();
+		void				Allocate(int w, int h, GLint internalFormat, GLenum format, GLint filter);
+		void				Upload(int x, int y, int w, int h, GLenum format, const unsigned char* data);
+
+		/*---------------------------------------------------*/
+		/* Region Functions									 */
+		/*---------------------------------------------------*/
+		glm::vec4			GetRegion(Texture* texture);
+
+		/*---------------------------------------------------*/
+		/* Constructor & Deconstructor						 */
+		/*---------------------------------------------------*/
+		TextureAtlas();
+		~TextureAtlas();
+
+		// The texture can only have one owner.
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas&		operator=(const TextureAtlas&) = delete;
 	};
 }
 
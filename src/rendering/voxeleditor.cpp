@@ -0,0 +1,93 @@
+#include "voxeleditor.h"
+
+#include <algorithm>
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Voxel Editor																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Voxel Editor															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		How many edits one dispatch applies. A single invocation working
+		through thousands of them can run long enough for a driver's
+		watchdog to reset the GPU, and llvmpipe quietly gives up on any
+		shader after 65535 loop iterations, which is only a few thousand
+		edits.
+	*/
+	const unsigned int EDITS_PER_DISPATCH = 256;
+
+	/*-----------------------------------------------------*/
+	/* Edit Functions									   */
+	/*-----------------------------------------------------*/
+	/* Apply ----------------------------------------------*/
+	/*
+		Applies whatever edits have been queued since last
+		time, EDITS_PER_DISPATCH at a time. Each dispatch
+		has to see what the last one wrote, and the next
+		trace what the last one did, so each is followed by
+		a barrier.
+
+		Input: None
+		Output: How many edits were applied
+	*/
+	unsigned int VoxelEditor::Apply()
+	{
+		if (!octree->TakeEdits(edits)) return 0;
+
+		PROFILE_SCOPE("VoxelEditor::Apply");
+
+		GLsizeiptr bytes = edits.size() * sizeof(VoxelEdit);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, editBuffer);
+		if (bytes > editCapacity)
+		{
+			this->editCapacity = bytes * 2;
+			glBufferData(GL_SHADER_STORAGE_BUFFER, editCapacity, nullptr, GL_STREAM_DRAW);
+		}
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, edits.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		editShader.Use();
+		SetUint(editShader.GetID(), "size", octree->GetSize());
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, buffer->GetSSBO());
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, buffer->GetAllocatorSSBO());
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, editBuffer);
+
+		for (unsigned int first = 0; first < edits.size(); first += EDITS_PER_DISPATCH)
+		{
+			SetUint(editShader.GetID(), "firstEdit", first);
+			SetUint(editShader.GetID(), "nEdits", std::min(EDITS_PER_DISPATCH, (unsigned int)edits.size() - first));
+
+			glDispatchCompute(1, 1, 1);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		}
+
+		return (unsigned int)edits.size();
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor & Deconstructor						   */
+	/*-----------------------------------------------------*/
+	VoxelEditor::VoxelEditor(OctreeBuffer* buffer) :
+		editShader("assets/shaders/edit.comp")
+	{
+		this->octree = buffer->GetOctree();
+		this->buffer = buffer;
+		this->editCapacity = 0;
+
+		glGenBuffers(1, &editBuffer);
+	}
+
+	VoxelEditor::~VoxelEditor()
+	{
+		glDeleteBuffers(1, &editBuffer);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef VOXELEDITOR_H
+#define VOXELEDITOR_H
+
+#include <vector>
+#include <glad/glad.h>
+
+#include "shader.h"
+#include "octreebuffer.h"
+#include "../world/octree.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Voxel Editor																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Voxel Editor															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Applies the edits queued with Octree::EditVoxel straight to the
+		octree's buffer, with a compute shader (edit.comp), so the CPU
+		never walks the tree or uploads voxels for them. Call Apply once
+		a frame, after OctreeBuffer::Update and before anything traces.
+
+		The edits go up in a buffer of our own, grown as needed, and
+		blocks of children come from the octree's allocator buffer: the
+		top of its free list, or the cursor. This is a serial applier:
+		a single invocation works through the edits in order, a few
+		hundred to a dispatch, so nothing about it is parallel but that
+		the CPU doesn't have to do it. Pruning can free a block that the
+		next edit takes, so any other order would hand out different
+		blocks than the CPU does when it replays them, and the two
+		copies of the tree would stop being the same.
+	*/
+	class VoxelEditor
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Octree											   */
+		/*-----------------------------------------------------*/
+		Octree*					octree;
+		OctreeBuffer*			buffer;
+
+		/*-----------------------------------------------------*/
+		/* Edits											   */
+		/*-----------------------------------------------------*/
+		std::vector<VoxelEdit>	edits;
+		GLuint					editBuffer;
+		GLsizeiptr				editCapacity;
+
+		/*-----------------------------------------------------*/
+		/* Shader											   */
+		/*-----------------------------------------------------*/
+		Shader					editShader;
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Edit Functions									   */
+		/*-----------------------------------------------------*/
+		unsigned int			Apply();
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		VoxelEditor(OctreeBuffer* buffer);
+		~VoxelEditor();
+	};
+}
+
+#endif
\ No newline at end of file
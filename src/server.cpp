@@ -0,0 +1,226 @@
+// server.cpp
+//
+// Runs the simulation with nothing drawn and no GL at all, ticking as
+// fast as it'll go, for soak and throughput tests on machines without
+// a display. Built against winedark_core alone.
+//
+// Each tick, a digger somewhere in the world makes some edits (half
+// of them holes, half new voxels of whatever type) around a random
+// spot, so the octree, its allocator and, with a save path, the
+// journal all get a workout. Once a second we print how many ticks
+// and edits there were, and the slowest tick. Runs for as many
+// seconds as asked (0 for until interrupted) and prints a summary at
+// the end.
+//
+// The size has to be a power of two from 2 to MAX_SIZE. Anything it
+// can't make sense of gets the usage line and an exit code of 1.
+//
+// Usage: winedark_server [seconds] [size] [edits per tick] [save path]
+
+#include <cmath>
+#include <ctime>
+#include <chrono>
+#include <random>
+#include <string>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include "world/journal.h"
+#include "world/generator.h"
+#include "world/simulation.h"
+#include "util/profiler.h"
+
+using Clock = std::chrono::steady_clock;
+
+const unsigned int SEED = 1;
+const int DIG_RADIUS = 8;
+
+/*
+	The octree counts its voxels in an unsigned int, and past
+	this size there are more than one holds.
+*/
+const unsigned int MAX_SIZE = 1024;
+const char* USAGE = "Usage: winedark_server [seconds] [size] [edits per tick] [save path]";
+
+/*
+	Ctrl-C stops the loop rather than the process, so the
+	journal gets to finish writing.
+*/
+volatile std::sig_atomic_t stopRequested = 0;
+
+/*
+	Reads a whole argument as a number of seconds, zero or
+	more. Anything else, or anything after the number, and
+	it fails.
+*/
+bool ParseSeconds(const char* arg, double& seconds)
+{
+	char* end;
+	errno = 0;
+	seconds = strtod(arg, &end);
+
+	return end != arg && *end == '\0' && errno == 0 && std::isfinite(seconds) && seconds >= 0.0;
+}
+
+/*
+	Reads a whole argument as a count, from zero to max. Signs
+	aren't allowed, since strtoul would wrap a negative one
+	round to something huge.
+*/
+bool ParseCount(const char* arg, unsigned long max, unsigned int& count)
+{
+	if (!isdigit((unsigned char)arg[0])) return false;
+
+	char* end;
+	errno = 0;
+	unsigned long value = strtoul(arg, &end, 10);
+	count = (unsigned int)value;
+
+	return *end == '\0' && errno == 0 && value <= max;
+}
+
+int main(int argc, char** argv)
+{
+	double seconds = 10.0;
+	unsigned int size = 128;
+	unsigned int editsPerTick = 16;
+	std::string savePath = (argc > 4) ? argv[4] : "";
+
+	if (argc > 1 && (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0))
+	{
+		std::cout << USAGE << std::endl;
+		return 0;
+	}
+
+	if (argc > 5)
+	{
+		std::cout << "ERROR::SERVER::TOO_MANY_ARGUMENTS" << std::endl << USAGE << std::endl;
+		return 1;
+	}
+
+	if (argc > 1 && !ParseSeconds(argv[1], seconds))
+	{
+		std::cout << "ERROR::SERVER::BAD_SECONDS " << argv[1] << " (a number, 0 or more)" << std::endl << USAGE << std::endl;
+		return 1;
+	}
+
+	if (argc > 2 && (!ParseCount(argv[2], MAX_SIZE, size) || size < 2 || (size & (size - 1)) != 0))
+	{
+		std::cout << "ERROR::SERVER::BAD_SIZE " << argv[2] << " (a power of two from 2 to " << MAX_SIZE << ")" << std::endl << USAGE << std::endl;
+		return 1;
+	}
+
+	if (argc > 3 && !ParseCount(argv[3], UINT_MAX, editsPerTick))
+	{
+		std::cout << "ERROR::SERVER::BAD_EDITS " << argv[3] << " (a whole number, 0 or more)" << std::endl << USAGE << std::endl;
+		return 1;
+	}
+
+	std::signal(SIGINT, [](int) { stopRequested = 1; });
+
+	/*
+		The world: loaded if there's a save to load,
+		generated (the same every time) if not.
+	*/
+	Winedark::Octree* octree = new Winedark::Octree(size);
+	Winedark::EditJournal* journal = nullptr;
+
+	if (!savePath.empty())
+	{
+		std::filesystem::path parent = std::filesystem::path(savePath).parent_path();
+		if (!parent.empty()) std::filesystem::create_directories(parent);
+
+		journal = new Winedark::EditJournal(savePath);
+		if (!journal->Load(octree)) Winedark::GenerateSea(octree, SEED);
+		journal->Attach(octree);
+	}
+	else Winedark::GenerateSea(octree, SEED);
+
+	Winedark::Simulation* simulation = new Winedark::Simulation(octree, journal);
+
+	std::cout << "Serving a " << size << "^3 world, " << editsPerTick << " edits a tick";
+	if (seconds > 0.0) std::cout << ", for " << seconds << " s";
+	std::cout << "." << std::endl;
+
+	/*
+		And tick.
+	*/
+	std::mt19937 rng(SEED);
+	std::uniform_int_distribution<int> across(0, (int)size - 1);
+	std::uniform_int_distribution<int> offset(-DIG_RADIUS, DIG_RADIUS);
+	std::uniform_int_distribution<int> type(0, 3);
+
+	auto start = Clock::now();
+	auto secondStart = start;
+	unsigned long long secondTicks = 0;
+	unsigned long long secondEdits = 0;
+	double slowestMs = 0.0;
+	double slowestOverallMs = 0.0;
+
+	while (!stopRequested)
+	{
+		auto tickStart = Clock::now();
+		if (seconds > 0.0 && std::chrono::duration<double>(tickStart - start).count() >= seconds) break;
+
+		int cx = across(rng), cy = across(rng), cz = across(rng);
+		for (unsigned int i = 0; i < editsPerTick; i++)
+		{
+			int t = (i % 2 == 0) ? 0 : std::max(1, type(rng));
+			simulation->QueueEdit(cx + offset(rng), cy + offset(rng), cz + offset(rng), (uint16_t)t);
+		}
+
+		simulation->Tick();
+
+		auto now = Clock::now();
+		double ms = std::chrono::duration<double, std::milli>(now - tickStart).count();
+		slowestMs = std::max(slowestMs, ms);
+		slowestOverallMs = std::max(slowestOverallMs, ms);
+
+		if (now - secondStart >= std::chrono::seconds(1))
+		{
+			double elapsed = std::chrono::duration<double>(now - secondStart).count();
+			unsigned long long ticks = simulation->GetTicks() - secondTicks;
+			unsigned long long edits = simulation->GetEdits() - secondEdits;
+
+			std::cout << "Ticks/s: " << (unsigned long long)(ticks / elapsed) << ", Edits/s: " << (unsigned long long)(edits / elapsed)
+					  << ", Slowest Tick: " << slowestMs << " ms, Voxels Used: " << octree->GetCursor() << " of " << octree->GetCapacity() << std::endl;
+
+			secondStart = now;
+			secondTicks = simulation->GetTicks();
+			secondEdits = simulation->GetEdits();
+			slowestMs = 0.0;
+		}
+	}
+
+	double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::cout << "Ran " << simulation->GetTicks() << " ticks in " << elapsed << " s: " << (simulation->GetTicks() / elapsed) << " ticks/s, "
+			  << (simulation->GetEdits() / elapsed) << " edits/s, slowest tick " << slowestOverallMs << " ms." << std::endl;
+
+	for (auto& zone : Winedark::GetProfileStats())
+	{
+		if (zone.name == "Simulation::Tick") std::cout << "Tick p50: " << zone.p50 << " ms, p95: " << zone.p95 << " ms, p99: " << zone.p99 << " ms." << std::endl;
+	}
+
+	/*
+		Whatever's pending goes to disk before we go.
+	*/
+	if (journal != nullptr)
+	{
+		journal->Flush();
+		journal->Wait();
+	}
+
+	delete simulation;
+	delete journal;
+	delete octree;
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef ENCODING_H
+#define ENCODING_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Encoding																						*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Morton Codes															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		A Morton code interleaves the bits of x, y, and z so that voxels
+		which are close together in the world end up close together when
+		sorted. Sorting edits this way also means that consecutive codes
+		tend to differ by small amounts, which makes them cheap to store
+		as deltas. We support up to 21 bits per axis.
+	*/
+	inline uint64_t SpreadBits(uint64_t v)
+	{
+		v &= 0x1fffff;
+		v = (v | (v << 32)) & 0x1f00000000ffff;
+		v = (v | (v << 16)) & 0x1f0000ff0000ff;
+		v = (v | (v << 8)) & 0x100f00f00f00f00f;
+		v = (v | (v << 4)) & 0x10c30c30c30c30c3;
+		v = (v | (v << 2)) & 0x1249249249249249;
+		return v;
+	}
+
+	inline uint64_t CompactBits(uint64_t v)
+	{
+		v &= 0x1249249249249249;
+		v = (v | (v >> 2)) & 0x10c30c30c30c30c3;
+		v = (v | (v >> 4)) & 0x100f00f00f00f00f;
+		v = (v | (v >> 8)) & 0x1f0000ff0000ff;
+		v = (v | (v >> 16)) & 0x1f00000000ffff;
+		v = (v | (v >> 32)) & 0x1fffff;
+		return v;
+	}
+
+	inline uint64_t MortonEncode(unsigned int x, unsigned int y, unsigned int z)
+	{
+		return SpreadBits(x) | (SpreadBits(y) << 1) | (SpreadBits(z) << 2);
+	}
+
+	inline void MortonDecode(uint64_t m, unsigned int& x, unsigned int& y, unsigned int& z)
+	{
+		x = (unsigned int)CompactBits(m);
+		y = (unsigned int)CompactBits(m >> 1);
+		z = (unsigned int)CompactBits(m >> 2);
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Varints																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Varints store an integer seven bits at a time, using the high bit
+		of each byte to say whether another byte follows. Small numbers
+		(like the gap between two sorted Morton codes) take a single byte.
+	*/
+	inline void WriteVarint(std::vector<uint8_t>& out, uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			out.push_back((uint8_t)(v | 0x80));
+			v >>= 7;
+		}
+		out.push_back((uint8_t)v);
+	}
+
+	/*
+		ReadVarint returns false if the varint runs off the end
+		of the data, which is how we spot a torn write.
+	*/
+	inline bool ReadVarint(const uint8_t* data, size_t size, size_t& cursor, uint64_t& v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (cursor >= size) return false;
+			uint8_t b = data[cursor++];
+			v |= (uint64_t)(b & 0x7f) << shift;
+			if ((b & 0x80) == 0) return true;
+		}
+		return false;
+	}
+}
+
+#endif
\ No newline at end of file
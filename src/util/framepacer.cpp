@@ -0,0 +1,121 @@
+#include "framepacer.h"
+
+#include <cmath>
+#include <thread>
+
+#include "profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Frame Pacer																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Limit Functions														 */
+	/*-----------------------------------------------------------------------*/
+	/* SetLimit ---------------------------------------------*/
+	/*
+		Sets the most frames we'll allow a second. Zero (or
+		less) means no cap at all.
+
+		Input: Frames per second
+		Output: None
+	*/
+	void FramePacer::SetLimit(double fps)
+	{
+		if (fps > 0.0) this->interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+		else this->interval = Clock::duration::zero();
+
+		this->next = Clock::now();
+	}
+
+	/* GetLimit ---------------------------------------------*/
+	/*
+		Input: None
+		Output: Frames per second, or zero for no cap
+	*/
+	double FramePacer::GetLimit()
+	{
+		if (interval == Clock::duration::zero()) return 0.0;
+		return 1.0 / std::chrono::duration<double>(interval).count();
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Pacing Functions														 */
+	/*-----------------------------------------------------------------------*/
+	/* Wait -------------------------------------------------*/
+	/*
+		Waits out whatever's left of this frame's interval.
+
+		If we've fallen a whole interval or more behind, we
+		don't try to make it up with a burst of short frames;
+		the next frame just gets a full interval from now.
+
+		Input: None
+		Output: None
+	*/
+	void FramePacer::Wait()
+	{
+		if (interval == Clock::duration::zero()) return;
+
+		PROFILE_SCOPE("FramePacer::Wait");
+
+		Clock::time_point now = Clock::now();
+
+		/*
+			First we sleep, a millisecond at a time, for as long
+			as the rest of the frame is longer than a sleep is
+			likely to take. Each one tells us a little more
+			about how long that is (Welford's running mean and
+			variance).
+		*/
+		while (std::chrono::duration<double>(next - now).count() > estimate)
+		{
+			Clock::time_point start = now;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			now = Clock::now();
+
+			double observed = std::chrono::duration<double>(now - start).count();
+			this->count++;
+
+			double delta = observed - mean;
+			this->mean += delta / count;
+			this->m2 += delta * (observed - mean);
+			this->estimate = mean + std::sqrt(m2 / count);
+		}
+
+		/*
+			Then we spin out the rest.
+		*/
+		while (now < next)
+		{
+			std::this_thread::yield();
+			now = Clock::now();
+		}
+
+		this->next += interval;
+		if (next < now) this->next = now + interval;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Constructor															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Until we've seen any, we assume a millisecond's sleep
+		takes two.
+
+		Input: Frames per second, or zero for no cap
+		Output: (Frame Pacer)
+	*/
+	FramePacer::FramePacer(double fps)
+	{
+		this->estimate = 0.002;
+		this->mean = 0.002;
+		this->m2 = 0.0;
+		this->count = 1;
+
+		SetLimit(fps);
+	}
+}
\ No newline at end of file
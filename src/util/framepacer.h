@@ -0,0 +1,64 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <chrono>
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Frame Pacer																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*
+		Caps the frame rate. Wait() is called once a frame, after the
+		swap, and holds the frame until its time is up.
+
+		Sleeping alone isn't precise enough: a thread asked to sleep for
+		a millisecond can wake up several later (on some systems, most
+		of a 60 Hz frame later). Spinning for the whole wait is precise,
+		but pins a core, which is what capping is meant to stop. So we
+		sleep a millisecond at a time while there's plenty of the frame
+		left, and spin through the rest. How much is "plenty" we learn as
+		we go, from how long those sleeps really take: their mean plus a
+		standard deviation.
+	*/
+	class FramePacer
+	{
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		/*-----------------------------------------------------*/
+		/* Timing											   */
+		/*-----------------------------------------------------*/
+		Clock::duration			interval;
+		Clock::time_point		next;
+
+		/*-----------------------------------------------------*/
+		/* Sleep Estimate									   */
+		/*-----------------------------------------------------*/
+		double					estimate;
+		double					mean;
+		double					m2;
+		unsigned long long		count;
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Limit Functions									   */
+		/*-----------------------------------------------------*/
+		void					SetLimit(double fps);
+		double					GetLimit();
+
+		/*-----------------------------------------------------*/
+		/* Pacing Functions									   */
+		/*-----------------------------------------------------*/
+		void					Wait();
+
+		/*-----------------------------------------------------*/
+		/* Constructor										   */
+		/*-----------------------------------------------------*/
+		FramePacer(double fps);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "geometry.h"
 
-#include <corecrt_math_defines.h>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtx/norm.hpp>
 #include <algorithm>
 
@@ -52,7 +53,7 @@ namespace Winedark
 
 		NormalizeQuaternion(q);
 
-		if (isnan(q.x) || isnan(q.y) || isnan(q.z)) return r;
+		if (std::isnan(q.x) || std::isnan(q.y) || std::isnan(q.z)) return r;
 
 		if (theta > 2.0) return -q;
 		return q;
@@ -78,7 +79,7 @@ namespace Winedark
 		float dot = glm::dot(trueForward, forward);
 		float err = 0.000001f;
 
-		if (fabsf(dot + 1.0f) < err) return Quaternion(M_PI, trueUp.x, trueUp.y, trueUp.z);
+		if (fabsf(dot + 1.0f) < err) return Quaternion(glm::pi<float>(), trueUp.x, trueUp.y, trueUp.z);
 		else if (fabsf(dot - 1.0f) < err) return Quaternion(1, 0, 0, 0);
 
 		float rotAngle = acosf(dot);
@@ -125,7 +126,7 @@ namespace Winedark
 		double sinp = 2 * (q.w * q.y - q.z * q.x);
 		if (std::abs(sinp) >= 1)
 		{
-			e.y = (float)std::copysign(M_PI / 2, sinp);
+			e.y = (float)std::copysign(glm::half_pi<double>(), sinp);
 		}
 		else
 		{
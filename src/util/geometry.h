@@ -17,6 +17,18 @@ namespace Winedark
 	float Lerp(float a, float b, float step);
 	glm::vec3 Lerp(glm::vec3 a, glm::vec3 b, float step);
 
+	/*-----------------------------------------------------------------------*/
+	/* Boxes																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		An axis-aligned box, from its min corner to its max corner.
+	*/
+	struct Box
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
 	/*-----------------------------------------------------------------------*/
 	/* Quaternions															 */
 	/*-----------------------------------------------------------------------*/
@@ -0,0 +1,300 @@
+#include "profiler.h"
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Profiler																						*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Profile Buffer														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Every thread that records an event gets its own ring buffer, so
+		recording never waits on another thread. The mutex is only ever
+		contended while someone is reading the buffers out, which is
+		rare, and an uncontended lock is cheap.
+
+		Buffers are never freed, so the events of threads that have
+		finished (the journal's worker, say) can still be read.
+
+		Tracks are buffers with a name that aren't tied to a thread,
+		for events that happen somewhere else entirely, like the GPU.
+		Whoever made one is the only one who should record to it.
+	*/
+	const size_t PROFILE_BUFFER_SIZE = 1 << 15;
+
+	struct ProfileBuffer
+	{
+		std::mutex					mutex;
+		std::vector<ProfileEvent>	events;
+		uint64_t					head;
+		uint32_t					thread;
+		const char*					name;
+	};
+
+	static std::mutex buffersMutex;
+	static std::vector<ProfileBuffer*> buffers;
+	static std::atomic<bool> profiling(true);
+
+	static thread_local ProfileBuffer* threadBuffer = nullptr;
+
+	/*---------------------------------------------------*/
+	/* Utility Functions								 */
+	/*---------------------------------------------------*/
+	/* MakeBuffer ---------------------------------------*/
+	/*
+		Makes a new buffer and adds it to the list.
+	*/
+	ProfileBuffer* MakeBuffer(const char* name)
+	{
+		ProfileBuffer* buffer = new ProfileBuffer();
+		buffer->events.resize(PROFILE_BUFFER_SIZE);
+		buffer->head = 0;
+		buffer->name = name;
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffer->thread = (uint32_t)buffers.size();
+		buffers.push_back(buffer);
+
+		return buffer;
+	}
+
+	/* GetThreadBuffer ----------------------------------*/
+	/*
+		Returns this thread's buffer, making it the first
+		time round.
+	*/
+	ProfileBuffer* GetThreadBuffer()
+	{
+		if (threadBuffer == nullptr) threadBuffer = MakeBuffer(nullptr);
+		return threadBuffer;
+	}
+
+	/* PushEvent ----------------------------------------*/
+	/*
+		Adds an event to a buffer, over the oldest one
+		once it's full.
+	*/
+	void PushEvent(ProfileBuffer* buffer, const char* name, uint64_t start, uint64_t end)
+	{
+		std::lock_guard<std::mutex> lock(buffer->mutex);
+
+		buffer->events[buffer->head % PROFILE_BUFFER_SIZE] = { name, start, end };
+		buffer->head++;
+	}
+
+	/* CollectEvents ------------------------------------*/
+	/*
+		Copies every event still in the ring buffers, with
+		the thread each one came from.
+	*/
+	void CollectEvents(std::vector<std::pair<uint32_t, ProfileEvent>>& events)
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+
+		for (ProfileBuffer* buffer : buffers)
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+			uint64_t first = buffer->head > PROFILE_BUFFER_SIZE ? buffer->head - PROFILE_BUFFER_SIZE : 0;
+			for (uint64_t i = first; i < buffer->head; i++)
+			{
+				events.push_back({ buffer->thread, buffer->events[i % PROFILE_BUFFER_SIZE] });
+			}
+		}
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Profile Scope														 */
+	/*-----------------------------------------------------------------------*/
+	ProfileScope::ProfileScope(const char* name)
+	{
+		this->name = name;
+		this->start = ProfileNow();
+	}
+
+	ProfileScope::~ProfileScope()
+	{
+		RecordProfileEvent(name, start, ProfileNow());
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Profiler Functions													 */
+	/*-----------------------------------------------------------------------*/
+	/* ProfileNow -------------------------------------------*/
+	/*
+		The clock every event is timed against.
+
+		Input: None
+		Output: Nanoseconds since an arbitrary point
+	*/
+	uint64_t ProfileNow()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/* RecordProfileEvent -----------------------------------*/
+	/*
+		Adds an event to this thread's ring buffer.
+
+		Input: Zone name, start & end times
+		Output: None
+	*/
+	void RecordProfileEvent(const char* name, uint64_t start, uint64_t end)
+	{
+		if (!profiling.load(std::memory_order_relaxed)) return;
+
+		PushEvent(GetThreadBuffer(), name, start, end);
+	}
+
+	/* CreateProfileTrack -----------------------------------*/
+	/*
+		Makes a named track that events can be recorded to
+		from outside any thread's own buffer.
+
+		Input: Track name (must live forever)
+		Output: Track
+	*/
+	int CreateProfileTrack(const char* name)
+	{
+		return (int)MakeBuffer(name)->thread;
+	}
+
+	/* RecordProfileEvent :: Track --------------------------*/
+	/*
+		Adds an event to the given track.
+
+		Input: Track, zone name, start & end times
+		Output: None
+	*/
+	void RecordProfileEvent(int track, const char* name, uint64_t start, uint64_t end)
+	{
+		if (!profiling.load(std::memory_order_relaxed)) return;
+
+		ProfileBuffer* buffer;
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			buffer = buffers[track];
+		}
+
+		PushEvent(buffer, name, start, end);
+	}
+
+	/* SetProfiling -----------------------------------------*/
+	/*
+		Turns recording on or off at runtime. Scopes still
+		read the clock while it's off, but record nothing.
+
+		Input: Whether to record events
+		Output: None
+	*/
+	void SetProfiling(bool enabled)
+	{
+		profiling.store(enabled);
+	}
+
+	bool IsProfiling()
+	{
+		return profiling.load();
+	}
+
+	/* GetProfileStats --------------------------------------*/
+	/*
+		Works out the 50th, 95th and 99th percentile time of
+		each zone over the events still in the buffers, so
+		the stats roll along with them.
+
+		Input: None
+		Output: Stats per zone (in milliseconds), by name
+	*/
+	std::vector<ZoneStats> GetProfileStats()
+	{
+		std::vector<std::pair<uint32_t, ProfileEvent>> events;
+		CollectEvents(events);
+
+		std::map<std::string, std::vector<double>> zones;
+		for (auto& event : events)
+		{
+			zones[event.second.name].push_back((event.second.end - event.second.start) / 1000000.0);
+		}
+
+		std::vector<ZoneStats> stats;
+		for (auto& zone : zones)
+		{
+			std::vector<double>& times = zone.second;
+			std::sort(times.begin(), times.end());
+
+			auto percentile = [&times](double p) { return times[std::min(times.size() - 1, (size_t)(p * times.size()))]; };
+			stats.push_back({ zone.first, (unsigned int)times.size(), percentile(0.5), percentile(0.95), percentile(0.99) });
+		}
+
+		return stats;
+	}
+
+	/* WriteChromeTrace -------------------------------------*/
+	/*
+		Writes every event still in the buffers out in the
+		Chrome trace event format, which chrome://tracing
+		and Perfetto can open.
+
+		Input: Path of the JSON file
+		Output: Whether the file was written
+	*/
+	bool WriteChromeTrace(const char* path)
+	{
+		std::vector<std::pair<uint32_t, ProfileEvent>> events;
+		CollectEvents(events);
+
+		std::ofstream file(path, std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "ERROR::PROFILER::TRACE_NOT_WRITTEN in " << path << std::endl;
+			return false;
+		}
+
+		uint64_t origin = UINT64_MAX;
+		for (auto& event : events) origin = std::min(origin, event.second.start);
+
+		file << std::fixed << std::setprecision(3);
+		file << "{\"traceEvents\":[";
+
+		/*
+			Named tracks get a metadata entry so the viewer
+			shows their name instead of a number.
+		*/
+		const char* separator = "\n";
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			for (ProfileBuffer* buffer : buffers)
+			{
+				if (buffer->name == nullptr) continue;
+
+				file << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->thread << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+				separator = ",\n";
+			}
+		}
+
+		for (auto& entry : events)
+		{
+			const ProfileEvent& event = entry.second;
+
+			file << separator << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << entry.first
+				 << ",\"ts\":" << (event.start - origin) / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+			separator = ",\n";
+		}
+		file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		return (bool)file;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Profiler																						*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Macros																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		PROFILE_SCOPE("Name") times everything from where it's written to
+		the end of the enclosing block. Scopes nest, so a scope inside
+		Renderer::Render shows up underneath it in the trace (the trace
+		viewer works the nesting out from the times).
+
+		The names must be string literals (or otherwise live forever),
+		since we only keep the pointer.
+
+		Building without WINEDARK_PROFILING turns every scope into
+		nothing at all.
+	*/
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef WINEDARK_PROFILING
+#define PROFILE_SCOPE(name) Winedark::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
+
+	/*-----------------------------------------------------------------------*/
+	/* Profile Event														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		One timed zone. Times are in nanoseconds since an arbitrary
+		point (see ProfileNow).
+	*/
+	struct ProfileEvent
+	{
+		const char*		name;
+		uint64_t		start;
+		uint64_t		end;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Zone Stats															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Percentiles of how long a zone took, over however many of its
+		events are still in the ring buffers.
+	*/
+	struct ZoneStats
+	{
+		std::string		name;
+		unsigned int	count;
+		double			p50;
+		double			p95;
+		double			p99;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Profile Scope														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Remembers when it was made and records an event when it goes out
+		of scope. Use the PROFILE_SCOPE macro rather than this directly.
+	*/
+	class ProfileScope
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Zone												   */
+		/*-----------------------------------------------------*/
+		const char*			name;
+		uint64_t			start;
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		ProfileScope(const char* name);
+		~ProfileScope();
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Profiler Functions													 */
+	/*-----------------------------------------------------------------------*/
+	uint64_t ProfileNow();
+	void RecordProfileEvent(const char* name, uint64_t start, uint64_t end);
+
+	int CreateProfileTrack(const char* name);
+	void RecordProfileEvent(int track, const char* name, uint64_t start, uint64_t end);
+
+	void SetProfiling(bool enabled);
+	bool IsProfiling();
+
+	std::vector<ZoneStats> GetProfileStats();
+	bool WriteChromeTrace(const char* path);
+}
+
+#endif
\ No newline at end of file
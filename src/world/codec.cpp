@@ -0,0 +1,176 @@
+#include "codec.h"
+
+#include <cstring>
+#include <lz.h>
+
+#include "../util/encoding.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Codecs																						*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Raw Codec															 */
+	/*-----------------------------------------------------------------------*/
+	void RawCodec::Encode(const Voxel* voxels, unsigned int n, std::vector<uint8_t>& out)
+	{
+		out.resize(n * sizeof(Voxel));
+		memcpy(out.data(), voxels, n * sizeof(Voxel));
+	}
+
+	bool RawCodec::Decode(const uint8_t* data, size_t size, Voxel* voxels, unsigned int n)
+	{
+		if (size != n * sizeof(Voxel)) return false;
+		memcpy(voxels, data, size);
+		return true;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Octree Codec															 */
+	/*-----------------------------------------------------------------------*/
+	/*---------------------------------------------------*/
+	/* Utility Functions								 */
+	/*---------------------------------------------------*/
+	/*
+		ChildToken turns a child pointer into a small
+		number: 0 for a leaf, otherwise one more than the
+		zigzagged difference from where we expected the
+		next block of children to be.
+	*/
+	uint64_t ChildToken(int children, int& expected)
+	{
+		if (children < 0) return 0;
+
+		int64_t d = (int64_t)children - expected;
+		expected = children + 8;
+		return (((uint64_t)d << 1) ^ (uint64_t)(d >> 63)) + 1;
+	}
+
+	int TokenChild(uint64_t token, int& expected)
+	{
+		if (token == 0) return -1;
+
+		uint64_t z = token - 1;
+		int64_t d = (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+		int children = (int)(expected + d);
+		expected = children + 8;
+		return children;
+	}
+
+	/*---------------------------------------------------*/
+	/* Coding Functions									 */
+	/*---------------------------------------------------*/
+	void OctreeCodec::Encode(const Voxel* voxels, unsigned int n, std::vector<uint8_t>& out)
+	{
+		out.clear();
+
+		/*
+			First the types.
+		*/
+		unsigned int i = 0;
+		while (i < n)
+		{
+			unsigned int j = i + 1;
+			while (j < n && voxels[j].type == voxels[i].type) j++;
+
+			WriteVarint(out, j - i);
+			WriteVarint(out, voxels[i].type);
+			i = j;
+		}
+
+		/*
+			Then the child pointers. The root's children
+			always start at index 1, hence the first guess.
+		*/
+		int expected = 1;
+		i = 0;
+		while (i < n)
+		{
+			uint64_t token = ChildToken(voxels[i].children, expected);
+			unsigned int j = i + 1;
+
+			while (j < n)
+			{
+				int e = expected;
+				if (ChildToken(voxels[j].children, e) != token) break;
+				expected = e;
+				j++;
+			}
+
+			WriteVarint(out, j - i);
+			WriteVarint(out, token);
+			i = j;
+		}
+	}
+
+	bool OctreeCodec::Decode(const uint8_t* data, size_t size, Voxel* voxels, unsigned int n)
+	{
+		size_t cursor = 0;
+		uint64_t run, value;
+
+		unsigned int i = 0;
+		while (i < n)
+		{
+			if (!ReadVarint(data, size, cursor, run) || !ReadVarint(data, size, cursor, value)) return false;
+			if (run == 0 || run > n - i) return false;
+
+			for (unsigned int end = i + (unsigned int)run; i < end; i++) voxels[i].type = (unsigned int)value;
+		}
+
+		int expected = 1;
+		i = 0;
+		while (i < n)
+		{
+			if (!ReadVarint(data, size, cursor, run) || !ReadVarint(data, size, cursor, value)) return false;
+			if (run == 0 || run > n - i) return false;
+
+			for (unsigned int end = i + (unsigned int)run; i < end; i++) voxels[i].children = TokenChild(value, expected);
+		}
+
+		return cursor == size;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* LZ Codec																 */
+	/*-----------------------------------------------------------------------*/
+	void LZCodec::Encode(const Voxel* voxels, unsigned int n, std::vector<uint8_t>& out)
+	{
+		int bytes = (int)(n * sizeof(Voxel));
+		out.resize(lz_bound(bytes));
+		out.resize(lz_compress((const unsigned char*)voxels, bytes, out.data(), (int)out.size()));
+	}
+
+	bool LZCodec::Decode(const uint8_t* data, size_t size, Voxel* voxels, unsigned int n)
+	{
+		int bytes = (int)(n * sizeof(Voxel));
+		return lz_decompress(data, (int)size, (unsigned char*)voxels, bytes) == bytes;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Codec Functions														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		The codecs hold no state, so we just keep one of
+		each around.
+
+		Input:		Codec type
+		Output:		Codec (nullptr if the type is unknown)
+	*/
+	Codec* GetCodec(CodecType type)
+	{
+		static RawCodec raw;
+		static OctreeCodec octree;
+		static LZCodec lz;
+
+		switch (type)
+		{
+		case CODEC_RAW: return &raw;
+		case CODEC_OCTREE: return &octree;
+		case CODEC_LZ: return &lz;
+		default: return nullptr;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "octree.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Codecs																						*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Codec Types															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		The codec type is written into the header of every saved chunk,
+		so these values must never change once a world has been saved.
+	*/
+	enum CodecType : uint32_t
+	{
+		CODEC_RAW = 0,
+		CODEC_OCTREE = 1,
+		CODEC_LZ = 2,
+		CODEC_COUNT
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Codec																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		A codec turns a run of voxels into bytes for the disk and back.
+		Decode writes straight into the voxel pool it's given, so loading
+		a world never needs a second copy of the voxels in memory.
+	*/
+	class Codec
+	{
+	public:
+		/*-----------------------------------------------------*/
+		/* Info Functions									   */
+		/*-----------------------------------------------------*/
+		virtual CodecType		GetType() = 0;
+		virtual const char*		GetName() = 0;
+
+		/*-----------------------------------------------------*/
+		/* Coding Functions									   */
+		/*-----------------------------------------------------*/
+		virtual void			Encode(const Voxel* voxels, unsigned int n, std::vector<uint8_t>& out) = 0;
+		virtual bool			Decode(const uint8_t* data, size_t size, Voxel* voxels, unsigned int n) = 0;
+
+		virtual ~Codec() {}
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Raw Codec															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Just copies the voxels. This is the baseline the other codecs
+		have to beat.
+	*/
+	class RawCodec : public Codec
+	{
+	public:
+		CodecType				GetType() { return CODEC_RAW; }
+		const char*				GetName() { return "raw"; }
+
+		void					Encode(const Voxel* voxels, unsigned int n, std::vector<uint8_t>& out);
+		bool					Decode(const uint8_t* data, size_t size, Voxel* voxels, unsigned int n);
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Octree Codec															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Knows how the octree lays out its voxels. Types and child
+		pointers are run-length encoded as two separate streams:
+
+			- Types come in long runs (air, water) so each run is stored
+			  as a (length, type) pair of varints.
+			- Child pointers are mostly either -1 (a leaf) or exactly
+			  eight past the previous one, because AddVoxel hands out
+			  blocks in order. So we store each as its difference from
+			  that guess, which is almost always zero, and run-length
+			  encode those.
+	*/
+	class OctreeCodec : public Codec
+	{
+	public:
+		CodecType				GetType() { return CODEC_OCTREE; }
+		const char*				GetName() { return "octree"; }
+
+		void					Encode(const Voxel* voxels, unsigned int n, std::vector<uint8_t>& out);
+		bool					Decode(const uint8_t* data, size_t size, Voxel* voxels, unsigned int n);
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* LZ Codec																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		A general-purpose LZ77 codec (see libs/lz). It knows nothing
+		about octrees but picks up repeated patterns of any length.
+	*/
+	class LZCodec : public Codec
+	{
+	public:
+		CodecType				GetType() { return CODEC_LZ; }
+		const char*				GetName() { return "lz"; }
+
+		void					Encode(const Voxel* voxels, unsigned int n, std::vector<uint8_t>& out);
+		bool					Decode(const uint8_t* data, size_t size, Voxel* voxels, unsigned int n);
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Codec Functions														 */
+	/*-----------------------------------------------------------------------*/
+	Codec* GetCodec(CodecType type);
+}
+
+#endif
\ No newline at end of file
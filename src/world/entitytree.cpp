@@ -0,0 +1,894 @@
+#include "entitytree.h"
+
+#include <chrono>
+#include <algorithm>
+
+#include "../util/encoding.h"
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Entity Tree																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*
+		How many bins a rebuild sorts the leaves into along an axis to
+		decide where to split them. More is a better tree and a slower
+		build; past 16 or so it's mostly slower.
+	*/
+	const int BUILD_BINS = 16;
+
+	/*-----------------------------------------------------------------------*/
+	/* Box Functions														 */
+	/*-----------------------------------------------------------------------*/
+	/* Union ------------------------------------------------*/
+	static Box Union(const Box& a, const Box& b)
+	{
+		return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+	}
+
+	/* Contains ---------------------------------------------*/
+	static bool Contains(const Box& outer, const Box& inner)
+	{
+		return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::greaterThanEqual(outer.max, inner.max));
+	}
+
+	/* Overlaps ---------------------------------------------*/
+	/*
+		Spelled out a component at a time, since it's what
+		every query spends most of its time doing, and most
+		of the boxes it's asked about are out on x alone.
+	*/
+	static bool Overlaps(const Box& a, const Box& b)
+	{
+		return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+			   a.min.y <= b.max.y && a.max.y >= b.min.y &&
+			   a.min.z <= b.max.z && a.max.z >= b.min.z;
+	}
+
+	/* Area -------------------------------------------------*/
+	/*
+		The surface area of a box, which is what the
+		chance of a random query or ray hitting it goes
+		with.
+	*/
+	static float Area(const Box& box)
+	{
+		glm::vec3 d = box.max - box.min;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	/* RayBox -----------------------------------------------*/
+	/*
+		Where a ray enters a box, if it does before maxT.
+		A ray starting inside enters at 0. A ray lying in
+		one of the box's planes works out to NaN on that
+		axis, which the comparisons leave out.
+
+		Input: The ray (with its direction inverted), the
+			   box and how far to look
+		Output: Whether it's hit, and where it enters
+	*/
+	static bool RayBox(glm::vec3 origin, glm::vec3 inverse, const Box& box, float maxT, float& tEnter)
+	{
+		float tMin = 0.0f;
+		float tMax = maxT;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t1 = (box.min[axis] - origin[axis]) * inverse[axis];
+			float t2 = (box.max[axis] - origin[axis]) * inverse[axis];
+
+			tMin = std::max(tMin, std::min(t1, t2));
+			tMax = std::min(tMax, std::max(t1, t2));
+		}
+
+		tEnter = tMin;
+		return tMin <= tMax;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Proxy Functions									   */
+	/*-----------------------------------------------------*/
+	/* Insert -------------------------------------------*/
+	/*
+		Adds an entity to the tree.
+
+		Input: Its box & whatever the caller knows it by
+		Output: Its proxy
+	*/
+	unsigned int EntityTree::Insert(const Box& box, unsigned int entity)
+	{
+		unsigned int proxy;
+
+		if (!freeProxies.empty())
+		{
+			proxy = freeProxies.back();
+			freeProxies.pop_back();
+		}
+		else
+		{
+			proxy = (unsigned int)proxies.size();
+			proxies.push_back({ box, -1, entity, false });
+		}
+
+		int leaf = AllocateNode();
+		nodes[leaf] = { { box.min - glm::vec3(margin), box.max + glm::vec3(margin) }, -1, -1, -1, 0, proxy };
+
+		proxies[proxy].box = box;
+		proxies[proxy].node = leaf;
+		proxies[proxy].entity = entity;
+
+		InsertLeaf(leaf);
+		Touch(proxy);
+
+		this->entities++;
+		return proxy;
+	}
+
+	/* Remove -------------------------------------------*/
+	void EntityTree::Remove(unsigned int proxy)
+	{
+		int leaf = proxies[proxy].node;
+
+		RemoveLeaf(leaf);
+		FreeNode(leaf);
+
+		proxies[proxy].node = -1;
+		freeProxies.push_back(proxy);
+		Touch(proxy);
+
+		this->entities--;
+	}
+
+	/* Move ---------------------------------------------*/
+	/*
+		Gives an entity a new box. If it's still inside its
+		fat box, that's all. If not, it gets a new fat box,
+		stretched by how far it's just moved on the guess
+		that it'll keep going, and the leaf's ancestors are
+		refit to take it in.
+
+		Input: Proxy, its new box & how far it moved
+		Output: Whether the tree changed
+	*/
+	bool EntityTree::Move(unsigned int proxy, const Box& box, glm::vec3 displacement)
+	{
+		proxies[proxy].box = box;
+
+		int leaf = proxies[proxy].node;
+		if (Contains(nodes[leaf].box, box)) return false;
+
+		glm::vec3 ahead = displacement * displacementScale;
+		Box fat = { box.min - glm::vec3(margin), box.max + glm::vec3(margin) };
+		fat.min += glm::min(ahead, glm::vec3(0.0f));
+		fat.max += glm::max(ahead, glm::vec3(0.0f));
+
+		nodes[leaf].box = fat;
+		Refit(nodes[leaf].parent);
+		Touch(proxy);
+
+		return true;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Node Functions									   */
+	/*-----------------------------------------------------*/
+	/* AllocateNode -------------------------------------*/
+	int EntityTree::AllocateNode()
+	{
+		if (freeNode == -1)
+		{
+			nodes.push_back({});
+			return (int)nodes.size() - 1;
+		}
+
+		int node = freeNode;
+		this->freeNode = nodes[node].parent;
+		return node;
+	}
+
+	/* FreeNode -----------------------------------------*/
+	void EntityTree::FreeNode(int node)
+	{
+		nodes[node].parent = freeNode;
+		nodes[node].height = -1;
+		this->freeNode = node;
+	}
+
+	/* InsertLeaf ---------------------------------------*/
+	/*
+		Finds the leaf a sibling, walking down from the
+		root towards whichever child would grow least by
+		taking it in, and stopping where pairing it with
+		the node we're at is cheaper than going on. Then
+		the two share a new parent.
+
+		Input: The leaf (with its box set)
+		Output: None
+	*/
+	void EntityTree::InsertLeaf(int leaf)
+	{
+		if (root == -1)
+		{
+			this->root = leaf;
+			nodes[leaf].parent = -1;
+			return;
+		}
+
+		Box box = nodes[leaf].box;
+		int sibling = root;
+
+		while (nodes[sibling].left != -1)
+		{
+			const Node& node = nodes[sibling];
+
+			float combined = Area(Union(node.box, box));
+			float cost = 2.0f * combined;
+			float inherited = 2.0f * (combined - Area(node.box));
+
+			float childCost[2];
+			int children[2] = { node.left, node.right };
+
+			for (int c = 0; c < 2; c++)
+			{
+				const Node& child = nodes[children[c]];
+				float grown = Area(Union(child.box, box));
+				childCost[c] = inherited + ((child.left == -1) ? grown : grown - Area(child.box));
+			}
+
+			if (cost < childCost[0] && cost < childCost[1]) break;
+			sibling = (childCost[0] < childCost[1]) ? children[0] : children[1];
+		}
+
+		int oldParent = nodes[sibling].parent;
+		int parent = AllocateNode();
+		nodes[parent] = { Union(box, nodes[sibling].box), oldParent, sibling, leaf, nodes[sibling].height + 1, 0 };
+
+		if (oldParent == -1) this->root = parent;
+		else if (nodes[oldParent].left == sibling) nodes[oldParent].left = parent;
+		else nodes[oldParent].right = parent;
+
+		nodes[sibling].parent = parent;
+		nodes[leaf].parent = parent;
+
+		Refit(oldParent);
+	}
+
+	/* RemoveLeaf ---------------------------------------*/
+	/*
+		Unhooks a leaf. Its sibling takes its parent's
+		place and the parent is freed.
+
+		Input: The leaf
+		Output: None
+	*/
+	void EntityTree::RemoveLeaf(int leaf)
+	{
+		if (leaf == root)
+		{
+			this->root = -1;
+			return;
+		}
+
+		int parent = nodes[leaf].parent;
+		int grandparent = nodes[parent].parent;
+		int sibling = (nodes[parent].left == leaf) ? nodes[parent].right : nodes[parent].left;
+
+		nodes[sibling].parent = grandparent;
+		FreeNode(parent);
+
+		if (grandparent == -1)
+		{
+			this->root = sibling;
+			return;
+		}
+
+		if (nodes[grandparent].left == parent) nodes[grandparent].left = sibling;
+		else nodes[grandparent].right = sibling;
+
+		Refit(grandparent);
+	}
+
+	/* Refit --------------------------------------------*/
+	/*
+		Brings a node's box and height into line with its
+		children's, then its parent's, and so on up, until
+		one turns out not to need it.
+
+		Input: The node to start at (-1 for none)
+		Output: None
+	*/
+	void EntityTree::Refit(int node)
+	{
+		while (node != -1)
+		{
+			Node& n = nodes[node];
+
+			Box box = Union(nodes[n.left].box, nodes[n.right].box);
+			int height = 1 + std::max(nodes[n.left].height, nodes[n.right].height);
+
+			if (box.min == n.box.min && box.max == n.box.max && height == n.height) return;
+
+			n.box = box;
+			n.height = height;
+			node = n.parent;
+		}
+	}
+
+	/* Touch --------------------------------------------*/
+	/*
+		Notes a proxy whose leaf the rebuild in flight
+		won't have right.
+	*/
+	void EntityTree::Touch(unsigned int proxy)
+	{
+		if (!rebuilding || proxies[proxy].touched) return;
+
+		proxies[proxy].touched = true;
+		touched.push_back(proxy);
+	}
+
+	/*-----------------------------------------------------*/
+	/* Rebuild Functions								   */
+	/*-----------------------------------------------------*/
+	/* Update -------------------------------------------*/
+	/*
+		Once a tick. Swaps in a finished rebuild, or starts
+		one if the tree's got bad enough.
+	*/
+	void EntityTree::Update()
+	{
+		PROFILE_SCOPE("EntityTree::Update");
+
+		if (rebuilding)
+		{
+			bool done;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				done = rebuildDone;
+			}
+
+			if (done) SwapRebuilt();
+			return;
+		}
+
+		if (root != -1 && GetCost() > builtCost * rebuildThreshold) Rebuild();
+	}
+
+	/* Rebuild ------------------------------------------*/
+	/*
+		Copies the leaves (fat boxes and all) for the
+		worker to build a new tree from, unless it's
+		already building one.
+	*/
+	void EntityTree::Rebuild()
+	{
+		if (rebuilding) return;
+
+		PROFILE_SCOPE("EntityTree::Rebuild");
+
+		std::vector<Leaf> leaves;
+		leaves.reserve(entities);
+
+		for (unsigned int p = 0; p < proxies.size(); p++)
+		{
+			if (proxies[p].node != -1) leaves.push_back({ nodes[proxies[p].node].box, p });
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			rebuildLeaves.swap(leaves);
+			this->rebuildQueued = true;
+		}
+		condition.notify_all();
+
+		this->rebuilding = true;
+	}
+
+	/* Wait ---------------------------------------------*/
+	/*
+		Waits for the rebuild in flight, if there is one,
+		and swaps it in.
+	*/
+	void EntityTree::Wait()
+	{
+		if (!rebuilding) return;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this] { return rebuildDone; });
+		}
+
+		SwapRebuilt();
+	}
+
+	/* SwapRebuilt --------------------------------------*/
+	/*
+		Swaps the rebuilt tree in for ours and catches it
+		up. Untouched proxies are where the copy had them,
+		so they just need pointing at their new leaves.
+		Each touched one has its copied leaf (if it had
+		one) taken out and, if it's still about, its fat
+		box from the old tree put back in.
+	*/
+	void EntityTree::SwapRebuilt()
+	{
+		PROFILE_SCOPE("EntityTree::SwapRebuilt");
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			nodes.swap(rebuilt);
+			this->root = rebuiltRoot;
+			this->rebuildDone = false;
+			this->rebuildMs = rebuiltMs;
+		}
+		this->freeNode = -1;
+
+		std::vector<int> leafOf(proxies.size(), -1);
+		for (unsigned int i = 0; i < nodes.size(); i++)
+		{
+			if (nodes[i].left == -1) leafOf[nodes[i].proxy] = (int)i;
+		}
+
+		for (unsigned int p = 0; p < proxies.size(); p++)
+		{
+			if (!proxies[p].touched) proxies[p].node = leafOf[p];
+		}
+
+		for (unsigned int p : touched)
+		{
+			if (leafOf[p] != -1)
+			{
+				RemoveLeaf(leafOf[p]);
+				FreeNode(leafOf[p]);
+			}
+
+			int old = proxies[p].node;
+			if (old != -1)
+			{
+				int leaf = AllocateNode();
+				nodes[leaf] = { rebuilt[old].box, -1, -1, -1, 0, p };
+				proxies[p].node = leaf;
+				InsertLeaf(leaf);
+			}
+
+			proxies[p].touched = false;
+		}
+
+		touched.clear();
+		rebuilt.clear();
+
+		this->rebuilding = false;
+		this->rebuilds++;
+		this->builtCost = GetCost();
+	}
+
+	/* BuildNode ----------------------------------------*/
+	/*
+		Builds the subtree over leaves [begin, end), top
+		down. The leaves are sorted into BUILD_BINS bins
+		by their centres along the axis the centres are
+		most spread out on, and split between the two bins
+		where the surface area heuristic (each side's area
+		times how many leaves it has) is least. If the
+		centres are all in one place, we just halve them.
+
+		Input: Leaves, the range to build & its parent,
+			   the nodes to build into
+		Output: The subtree's root
+	*/
+	int EntityTree::BuildNode(std::vector<Leaf>& leaves, unsigned int begin, unsigned int end, int parent, std::vector<Node>& built)
+	{
+		int index = (int)built.size();
+		built.push_back({});
+
+		if (end - begin == 1)
+		{
+			built[index] = { leaves[begin].box, parent, -1, -1, 0, leaves[begin].proxy };
+			return index;
+		}
+
+		Box bounds = leaves[begin].box;
+		Box centres = { (bounds.min + bounds.max) * 0.5f, (bounds.min + bounds.max) * 0.5f };
+
+		for (unsigned int i = begin + 1; i < end; i++)
+		{
+			glm::vec3 centre = (leaves[i].box.min + leaves[i].box.max) * 0.5f;
+			bounds = Union(bounds, leaves[i].box);
+			centres = Union(centres, { centre, centre });
+		}
+
+		glm::vec3 extent = centres.max - centres.min;
+		int axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : ((extent.y > extent.z) ? 1 : 2);
+		unsigned int mid = (begin + end) / 2;
+
+		if (extent[axis] > 0.0f)
+		{
+			float scale = BUILD_BINS / extent[axis];
+			auto binOf = [&](const Leaf& leaf)
+			{
+				float centre = (leaf.box.min[axis] + leaf.box.max[axis]) * 0.5f;
+				return std::min((int)((centre - centres.min[axis]) * scale), BUILD_BINS - 1);
+			};
+
+			Box binBoxes[BUILD_BINS];
+			unsigned int binCounts[BUILD_BINS] = {};
+
+			for (unsigned int i = begin; i < end; i++)
+			{
+				int b = binOf(leaves[i]);
+				binBoxes[b] = (binCounts[b] == 0) ? leaves[i].box : Union(binBoxes[b], leaves[i].box);
+				binCounts[b]++;
+			}
+
+			/*
+				Sweeping from the right, then from the left,
+				gives us both sides of every split.
+			*/
+			float rightArea[BUILD_BINS];
+			unsigned int rightCount[BUILD_BINS];
+			Box side;
+			unsigned int count = 0;
+
+			for (int b = BUILD_BINS - 1; b > 0; b--)
+			{
+				if (binCounts[b] > 0) side = (count == 0) ? binBoxes[b] : Union(side, binBoxes[b]);
+				count += binCounts[b];
+
+				rightArea[b] = (count > 0) ? Area(side) : 0.0f;
+				rightCount[b] = count;
+			}
+
+			int split = -1;
+			float best = 0.0f;
+			count = 0;
+
+			for (int b = 1; b < BUILD_BINS; b++)
+			{
+				if (binCounts[b - 1] > 0) side = (count == 0) ? binBoxes[b - 1] : Union(side, binBoxes[b - 1]);
+				count += binCounts[b - 1];
+
+				if (count == 0 || rightCount[b] == 0) continue;
+
+				float cost = count * Area(side) + rightCount[b] * rightArea[b];
+				if (split == -1 || cost < best)
+				{
+					split = b;
+					best = cost;
+				}
+			}
+
+			if (split != -1)
+			{
+				auto first = leaves.begin() + begin;
+				mid = begin + (unsigned int)(std::partition(first, leaves.begin() + end, [&](const Leaf& leaf) { return binOf(leaf) < split; }) - first);
+			}
+		}
+
+		int left = BuildNode(leaves, begin, mid, index, built);
+		int right = BuildNode(leaves, mid, end, index, built);
+
+		built[index] = { bounds, parent, left, right, 1 + std::max(built[left].height, built[right].height), 0 };
+		return index;
+	}
+
+	/* Run ----------------------------------------------*/
+	/*
+		The worker: builds whatever leaves it's handed and
+		leaves the tree for Update to pick up.
+	*/
+	void EntityTree::Run()
+	{
+		while (true)
+		{
+			std::vector<Leaf> leaves;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return stopping || rebuildQueued; });
+				if (stopping) return;
+
+				leaves.swap(rebuildLeaves);
+				this->rebuildQueued = false;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			std::vector<Node> built;
+			int builtRoot = -1;
+
+			{
+				PROFILE_SCOPE("EntityTree::Build");
+
+				built.reserve(2 * leaves.size());
+				if (!leaves.empty()) builtRoot = BuildNode(leaves, 0, (unsigned int)leaves.size(), -1, built);
+			}
+
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				rebuilt.swap(built);
+				this->rebuiltRoot = builtRoot;
+				this->rebuiltMs = ms;
+				this->rebuildDone = true;
+			}
+			condition.notify_all();
+		}
+	}
+
+	/*-----------------------------------------------------*/
+	/* Query Functions									   */
+	/*-----------------------------------------------------*/
+	/* Query --------------------------------------------*/
+	/*
+		Input: A box & a vector to add entities to
+		Output: None (every entity whose box overlaps)
+	*/
+	void EntityTree::Query(const Box& box, std::vector<unsigned int>& found)
+	{
+		if (root == -1) return;
+
+		std::vector<int> stack = { root };
+
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.back()];
+			stack.pop_back();
+
+			if (!Overlaps(node.box, box)) continue;
+
+			if (node.left != -1)
+			{
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+			else if (Overlaps(proxies[node.proxy].box, box)) found.push_back(proxies[node.proxy].entity);
+		}
+	}
+
+	/* QueryBoxes ---------------------------------------*/
+	/*
+		Query, for many boxes at once (every boid's
+		neighbourhood, say). The boxes are taken in the
+		order of the Morton codes of their centres, so
+		each is near the one before and mostly opens the
+		same nodes, which are then still in the cache;
+		taken as they come, the walks jump all over the
+		tree and spend most of their time waiting on
+		memory.
+
+		The overlaps come out in that order, not in the
+		order of the boxes.
+
+		Input: The boxes & a vector to add overlaps to
+		Output: None (a pair for each box and entity that
+				overlap)
+	*/
+	void EntityTree::QueryBoxes(const std::vector<Box>& boxes, std::vector<EntityOverlap>& overlaps)
+	{
+		PROFILE_SCOPE("EntityTree::QueryBoxes");
+
+		if (root == -1 || boxes.empty()) return;
+
+		Box bounds = boxes[0];
+		for (const Box& box : boxes) bounds = Union(bounds, box);
+
+		glm::vec3 scale = glm::vec3(1023.0f) / glm::max(bounds.max - bounds.min, glm::vec3(1e-6f));
+		std::vector<std::pair<uint64_t, unsigned int>> order(boxes.size());
+
+		for (unsigned int q = 0; q < boxes.size(); q++)
+		{
+			glm::vec3 cell = ((boxes[q].min + boxes[q].max) * 0.5f - bounds.min) * scale;
+			order[q] = { MortonEncode((unsigned int)cell.x, (unsigned int)cell.y, (unsigned int)cell.z), q };
+		}
+		std::sort(order.begin(), order.end());
+
+		std::vector<int> stack;
+
+		for (auto& entry : order)
+		{
+			const Box& box = boxes[entry.second];
+			stack.push_back(root);
+
+			while (!stack.empty())
+			{
+				const Node& node = nodes[stack.back()];
+				stack.pop_back();
+
+				if (!Overlaps(node.box, box)) continue;
+
+				if (node.left != -1)
+				{
+					stack.push_back(node.left);
+					stack.push_back(node.right);
+				}
+				else if (Overlaps(proxies[node.proxy].box, box)) overlaps.push_back({ entry.second, proxies[node.proxy].entity });
+			}
+		}
+	}
+
+	/* FindPairs ----------------------------------------*/
+	/*
+		Every pair of entities whose boxes overlap, once.
+		Rather than look every entity up, we walk the tree
+		against itself: each node's children are checked
+		against each other, and where two subtrees overlap,
+		the taller is opened up, until it's down to two
+		leaves.
+
+		Input: A vector to add the pairs to
+		Output: None
+	*/
+	void EntityTree::FindPairs(std::vector<EntityOverlap>& pairs)
+	{
+		PROFILE_SCOPE("EntityTree::FindPairs");
+
+		if (root == -1) return;
+
+		/*
+			A node on its own (b is -1) means its children
+			against each other, and so on down; two nodes
+			mean one subtree against the other.
+		*/
+		struct Check
+		{
+			int a;
+			int b;
+		};
+		std::vector<Check> stack = { { root, -1 } };
+
+		while (!stack.empty())
+		{
+			Check check = stack.back();
+			stack.pop_back();
+
+			const Node& a = nodes[check.a];
+
+			if (check.b == -1)
+			{
+				if (a.left == -1) continue;
+
+				stack.push_back({ a.left, -1 });
+				stack.push_back({ a.right, -1 });
+				stack.push_back({ a.left, a.right });
+				continue;
+			}
+
+			const Node& b = nodes[check.b];
+			if (!Overlaps(a.box, b.box)) continue;
+
+			if (a.left == -1 && b.left == -1)
+			{
+				if (!Overlaps(proxies[a.proxy].box, proxies[b.proxy].box)) continue;
+
+				unsigned int ea = proxies[a.proxy].entity;
+				unsigned int eb = proxies[b.proxy].entity;
+				pairs.push_back({ std::min(ea, eb), std::max(ea, eb) });
+			}
+			else if (b.left == -1 || (a.left != -1 && a.height >= b.height))
+			{
+				stack.push_back({ a.left, check.b });
+				stack.push_back({ a.right, check.b });
+			}
+			else
+			{
+				stack.push_back({ check.a, b.left });
+				stack.push_back({ check.a, b.right });
+			}
+		}
+	}
+
+	/* RayCast ------------------------------------------*/
+	/*
+		The first entity a ray hits. Anything further than
+		the nearest hit so far is skipped.
+
+		Input: The ray, how far to look & where to put
+			   what it hits
+		Output: Whether it hit anything
+	*/
+	bool EntityTree::RayCast(glm::vec3 origin, glm::vec3 direction, float maxT, unsigned int& entity, float& t)
+	{
+		if (root == -1) return false;
+
+		glm::vec3 inverse = glm::vec3(1.0f) / direction;
+		float best = maxT;
+		bool hit = false;
+
+		std::vector<int> stack = { root };
+
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.back()];
+			stack.pop_back();
+
+			float tEnter;
+			if (!RayBox(origin, inverse, node.box, best, tEnter)) continue;
+
+			if (node.left != -1)
+			{
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+			else if (RayBox(origin, inverse, proxies[node.proxy].box, best, tEnter))
+			{
+				best = tEnter;
+				entity = proxies[node.proxy].entity;
+				hit = true;
+			}
+		}
+
+		if (hit) t = best;
+		return hit;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Stat Functions									   */
+	/*-----------------------------------------------------*/
+	/* GetCost ------------------------------------------*/
+	float EntityTree::GetCost()
+	{
+		if (root == -1) return 0.0f;
+
+		float rootArea = Area(nodes[root].box);
+		if (rootArea <= 0.0f) return 0.0f;
+
+		float area = 0.0f;
+		for (const Node& node : nodes)
+		{
+			if (node.height > 0) area += Area(node.box);
+		}
+
+		return area / rootArea;
+	}
+
+	/* GetStats -----------------------------------------*/
+	EntityTreeStats EntityTree::GetStats()
+	{
+		unsigned int used = 0;
+		for (const Node& node : nodes) used += (node.height >= 0);
+
+		return { entities, used, (root == -1) ? 0u : (unsigned int)nodes[root].height, GetCost(), rebuilds, rebuildMs };
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor & Deconstructor						   */
+	/*-----------------------------------------------------*/
+	EntityTree::EntityTree()
+	{
+		this->root = -1;
+		this->freeNode = -1;
+		this->entities = 0;
+
+		this->rebuiltRoot = -1;
+		this->rebuildQueued = false;
+		this->rebuildDone = false;
+		this->stopping = false;
+		this->rebuiltMs = 0.0;
+
+		this->rebuilding = false;
+		this->builtCost = 0.0f;
+		this->rebuilds = 0;
+		this->rebuildMs = 0.0;
+
+		this->worker = std::thread(&EntityTree::Run, this);
+	}
+
+	/* Deconstructor --------------------------------------*/
+	/*
+		A rebuild in flight is finished and thrown away.
+	*/
+	EntityTree::~EntityTree()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+
+		worker.join();
+	}
+}
\ No newline at end of file
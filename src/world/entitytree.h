@@ -0,0 +1,228 @@
+#ifndef ENTITYTREE_H
+#define ENTITYTREE_H
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include <glm/glm.hpp>
+
+#include "../util/geometry.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Entity Tree																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Entity Overlap														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		One overlap found by a batch query. From QueryBoxes, a is the
+		index of the query box and b the entity; from FindPairs, they're
+		both entities (a < b).
+	*/
+	struct EntityOverlap
+	{
+		unsigned int	a;
+		unsigned int	b;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Entity Tree Stats													 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Cost is the tree's surface area heuristic: the area of all its
+		inner nodes over the root's, i.e. how many nodes an average
+		query expects to open. Lower is better.
+	*/
+	struct EntityTreeStats
+	{
+		unsigned int	entities;
+		unsigned int	nodes;
+		unsigned int	height;
+		float			cost;
+		unsigned int	rebuilds;
+		double			rebuildMs;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Entity Tree															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		The octree is for the world, which mostly sits still. Things
+		that move (ships, birds, monsters) go in here instead: a
+		dynamic bounding volume hierarchy of boxes, a leaf per entity,
+		for finding what's near what, what overlaps what and what a ray
+		hits first.
+
+		Each entity gets a proxy when it's inserted, which is how it's
+		moved and removed. Its leaf holds a fat box, its box grown by
+		margin (and stretched ahead of it by how far it last moved), so
+		most moves stay inside it and cost nothing. A move out of its
+		fat box gets a new one and refits the leaf's ancestors, from the
+		leaf up, until one doesn't change. The tree stays correct that
+		way but gets steadily worse, as boxes stretch to follow entities
+		around the world.
+
+		So every so often we start again. When the cost has grown by
+		rebuildThreshold since the last build, Update copies the leaves
+		and hands them to a worker, which builds a fresh tree top down,
+		splitting each node where the surface area heuristic says to
+		(binned, BUILD_BINS to an axis). The old tree goes on being used
+		(and moved, inserted into and removed from) meanwhile, and every
+		proxy touched since the copy is noted. When the new tree comes
+		back, the next Update swaps it in and puts those proxies right,
+		which, since it's only those that left their fat boxes in the
+		meantime, is only a few.
+
+		Inserting a lot at once (loading, say) is best followed by
+		Rebuild and Wait, since one at a time they make a poorer tree.
+
+		Queries only read, so any number can run at once from different
+		threads, as long as nothing's changing the tree.
+	*/
+	class EntityTree
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Node												   */
+		/*-----------------------------------------------------*/
+		/*
+			Leaves have no children (left is -1) and a proxy.
+			Height is -1 for a node on the free list, whose
+			parent is then the next free node.
+		*/
+		struct Node
+		{
+			Box					box;
+			int					parent;
+			int					left;
+			int					right;
+			int					height;
+			unsigned int		proxy;
+		};
+
+		/*-----------------------------------------------------*/
+		/* Proxy											   */
+		/*-----------------------------------------------------*/
+		/*
+			An entity's box (not fat) and its leaf. A free
+			proxy has no leaf (-1).
+		*/
+		struct Proxy
+		{
+			Box					box;
+			int					node;
+			unsigned int		entity;
+			bool				touched;
+		};
+
+		/*-----------------------------------------------------*/
+		/* Leaf												   */
+		/*-----------------------------------------------------*/
+		struct Leaf
+		{
+			Box					box;
+			unsigned int		proxy;
+		};
+
+		/*-----------------------------------------------------*/
+		/* Tree												   */
+		/*-----------------------------------------------------*/
+		std::vector<Node>		nodes;
+		int						root;
+		int						freeNode;
+
+		/*-----------------------------------------------------*/
+		/* Proxies											   */
+		/*-----------------------------------------------------*/
+		std::vector<Proxy>		proxies;
+		std::vector<unsigned int>	freeProxies;
+		unsigned int			entities;
+
+		/*-----------------------------------------------------*/
+		/* Rebuild											   */
+		/*-----------------------------------------------------*/
+		std::thread				worker;
+		std::mutex				mutex;
+		std::condition_variable	condition;
+		std::vector<Leaf>		rebuildLeaves;
+		std::vector<Node>		rebuilt;
+		int						rebuiltRoot;
+		bool					rebuildQueued;
+		bool					rebuildDone;
+		bool					stopping;
+
+		double					rebuiltMs;
+
+		bool					rebuilding;
+		std::vector<unsigned int>	touched;
+		float					builtCost;
+		unsigned int			rebuilds;
+		double					rebuildMs;
+
+		void					Run();
+		void					SwapRebuilt();
+		static int				BuildNode(std::vector<Leaf>& leaves, unsigned int begin, unsigned int end, int parent, std::vector<Node>& built);
+
+		/*-----------------------------------------------------*/
+		/* Node Functions									   */
+		/*-----------------------------------------------------*/
+		int						AllocateNode();
+		void					FreeNode(int node);
+		void					InsertLeaf(int leaf);
+		void					RemoveLeaf(int leaf);
+		void					Refit(int node);
+		void					Touch(unsigned int proxy);
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Settings											   */
+		/*-----------------------------------------------------*/
+		float					margin = 1.0f;
+		float					displacementScale = 2.0f;
+		float					rebuildThreshold = 1.25f;
+
+		/*-----------------------------------------------------*/
+		/* Proxy Functions									   */
+		/*-----------------------------------------------------*/
+		unsigned int			Insert(const Box& box, unsigned int entity);
+		void					Remove(unsigned int proxy);
+		bool					Move(unsigned int proxy, const Box& box, glm::vec3 displacement);
+		const Box&				GetBox(unsigned int proxy) { return proxies[proxy].box; }
+		unsigned int			GetEntity(unsigned int proxy) { return proxies[proxy].entity; }
+
+		/*-----------------------------------------------------*/
+		/* Rebuild Functions								   */
+		/*-----------------------------------------------------*/
+		void					Update();
+		void					Rebuild();
+		void					Wait();
+		bool					IsRebuilding() { return rebuilding; }
+
+		/*-----------------------------------------------------*/
+		/* Query Functions									   */
+		/*-----------------------------------------------------*/
+		void					Query(const Box& box, std::vector<unsigned int>& found);
+		void					QueryBoxes(const std::vector<Box>& boxes, std::vector<EntityOverlap>& overlaps);
+		void					FindPairs(std::vector<EntityOverlap>& pairs);
+		bool					RayCast(glm::vec3 origin, glm::vec3 direction, float maxT, unsigned int& entity, float& t);
+
+		/*-----------------------------------------------------*/
+		/* Stat Functions									   */
+		/*-----------------------------------------------------*/
+		float					GetCost();
+		EntityTreeStats			GetStats();
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		EntityTree();
+		~EntityTree();
+	};
+}
+
+#endif
\ No newline at end of file
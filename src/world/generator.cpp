@@ -0,0 +1,139 @@
+#include "generator.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* World Generation																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Noise																 */
+	/*-----------------------------------------------------------------------*/
+	/* Hash -----------------------------------------------------------------*/
+	/*
+		A small integer hash so that the noise doesn't
+		depend on (or disturb) the global rand() state.
+	*/
+	unsigned int Hash(unsigned int x, unsigned int y, unsigned int seed)
+	{
+		unsigned int h = seed * 0x9e3779b9u;
+		h ^= x * 0x85ebca6bu;
+		h = (h << 13) | (h >> 19);
+		h ^= y * 0xc2b2ae35u;
+		h ^= h >> 16;
+		h *= 0x7feb352du;
+		h ^= h >> 15;
+		h *= 0x846ca68bu;
+		h ^= h >> 16;
+		return h;
+	}
+
+	/* ValueNoise -----------------------------------------------------------*/
+	/*
+		Smoothly interpolated value noise on a square
+		lattice. Returns a value in [0, 1].
+	*/
+	float ValueNoise(float x, float y, unsigned int seed)
+	{
+		int ix = (int)std::floor(x);
+		int iy = (int)std::floor(y);
+		float fx = x - ix;
+		float fy = y - iy;
+
+		fx = fx * fx * (3.0f - 2.0f * fx);
+		fy = fy * fy * (3.0f - 2.0f * fy);
+
+		float a = Hash(ix, iy, seed) / 4294967295.0f;
+		float b = Hash(ix + 1, iy, seed) / 4294967295.0f;
+		float c = Hash(ix, iy + 1, seed) / 4294967295.0f;
+		float d = Hash(ix + 1, iy + 1, seed) / 4294967295.0f;
+
+		float top = a + (b - a) * fx;
+		float bottom = c + (d - c) * fx;
+		return top + (bottom - top) * fy;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Generators															 */
+	/*-----------------------------------------------------------------------*/
+	/* GenerateNoise --------------------------------------------------------*/
+	/*
+		Fills the octree with voxels scattered at random.
+		This is what the octree used to do on its own to
+		test rendering, and it is about the worst case for
+		both the tracer and the codecs.
+
+		Input:		Octree, seed & fraction of voxels to fill
+		Output:		None
+	*/
+	void GenerateNoise(Octree* octree, unsigned int seed, float fill)
+	{
+		PROFILE_SCOPE("GenerateNoise");
+
+		srand(seed);
+
+		unsigned int size = octree->GetSize();
+		int threshold = (int)(fill * 100.0f);
+
+		for (unsigned int x = 0; x < size; x++)
+		{
+			for (unsigned int y = 0; y < size; y++)
+			{
+				for (unsigned int z = 0; z < size; z++)
+				{
+					int r = rand() % 100 + 1;
+
+					if (r <= threshold)
+					{
+						octree->AddVoxel(x, y, z, VOXEL_STONE);
+					}
+				}
+			}
+		}
+	}
+
+	/* GenerateSea ----------------------------------------------------------*/
+	/*
+		Generates a stretch of open sea with a few islands.
+		Each column gets a height from two octaves of
+		value noise; below it is stone (sand near the
+		waterline), above it is water up to sea level and
+		air beyond that.
+
+		Input:		Octree & seed
+		Output:		None
+	*/
+	void GenerateSea(Octree* octree, unsigned int seed)
+	{
+		PROFILE_SCOPE("GenerateSea");
+
+		unsigned int size = octree->GetSize();
+		float seaLevel = size * 0.5f;
+		float scale = 1.0f / 32.0f;
+
+		for (unsigned int x = 0; x < size; x++)
+		{
+			for (unsigned int y = 0; y < size; y++)
+			{
+				float n = 0.7f * ValueNoise(x * scale, y * scale, seed) + 0.3f * ValueNoise(x * scale * 4.0f, y * scale * 4.0f, seed + 1);
+				unsigned int height = (unsigned int)std::min((float)size, size * 0.2f + n * n * size * 0.6f);
+				unsigned int top = std::max(height, (unsigned int)seaLevel);
+
+				for (unsigned int h = 0; h < top; h++)
+				{
+					uint16_t type = VOXEL_WATER;
+					if (h < height) type = (h + 2 >= height && h + 3 >= seaLevel) ? VOXEL_SAND : VOXEL_STONE;
+
+					octree->AddVoxel(x, y, size - 1 - h, type);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <cstdint>
+
+#include "octree.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* World Generation																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Voxel Types															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Until we have a proper block registry, these are the types the
+		generators know about. 0 is always air.
+	*/
+	enum VoxelType : uint16_t
+	{
+		VOXEL_AIR = 0,
+		VOXEL_STONE = 1,
+		VOXEL_SAND = 2,
+		VOXEL_WATER = 3
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Generators															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Every generator takes a seed and produces the same world for the
+		same seed, so that benchmarks and tests can be repeated.
+
+		The camera looks down the z axis from negative z, so "up" in the
+		world is -z: the sea floor sits at the back of the octree (large
+		z) and the air at the front.
+	*/
+	void GenerateNoise(Octree* octree, unsigned int seed, float fill);
+	void GenerateSea(Octree* octree, unsigned int seed);
+}
+
+#endif
@@ -0,0 +1,566 @@
+#include "journal.h"
+
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include "../util/encoding.h"
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Edit Journal																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* File Headers															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Both files start with a four byte magic followed by the
+		generation. The base then has the octree size, the number of
+		voxels, the codec and the encoded size, followed by the encoded
+		voxels. The journal is a list of batches, each prefixed by its
+		length in bytes so that we can tell when the last one was only
+		partly written.
+	*/
+	const char JOURNAL_MAGIC[4] = { 'W', 'D', 'J', '1' };
+	const char BASE_MAGIC[4] = { 'W', 'D', 'B', '1' };
+
+	/*---------------------------------------------------*/
+	/* Utility Functions								 */
+	/*---------------------------------------------------*/
+	/* ReadFile -----------------------------------------*/
+	/*
+		Reads a whole file into memory. Returns false if
+		the file doesn't exist or can't be read.
+	*/
+	bool ReadFile(const std::string& path, std::vector<uint8_t>& data)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) return false;
+
+		std::streamsize size = file.tellg();
+		file.seekg(0, std::ios::beg);
+
+		data.resize((size_t)size);
+		if (size > 0 && !file.read((char*)data.data(), size)) return false;
+		return true;
+	}
+
+	/* ReadUint -----------------------------------------*/
+	uint32_t ReadUint(const uint8_t* data)
+	{
+		uint32_t v;
+		memcpy(&v, data, sizeof(uint32_t));
+		return v;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Edit Journal															 */
+	/*-----------------------------------------------------------------------*/
+	/*---------------------------------------------------*/
+	/* Worker											 */
+	/*---------------------------------------------------*/
+	/* Run ----------------------------------------------*/
+	/*
+		The worker just pulls tasks off the queue in order
+		until we ask it to stop.
+	*/
+	void EditJournal::Run()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+				if (tasks.empty()) return;
+				task = std::move(tasks.front());
+			}
+
+			task();
+
+			/*
+				We only pop the task once it has finished so
+				that Wait() knows the disk is actually up to
+				date.
+			*/
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasks.pop_front();
+			}
+			condition.notify_all();
+		}
+	}
+
+	/* Enqueue ------------------------------------------*/
+	void EditJournal::Enqueue(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(std::move(task));
+		}
+		condition.notify_all();
+	}
+
+	/* Wait ---------------------------------------------*/
+	/*
+		Blocks until every queued flush and checkpoint has
+		hit the disk.
+	*/
+	void EditJournal::Wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this] { return tasks.empty(); });
+	}
+
+	/*---------------------------------------------------*/
+	/* File Functions (Worker Only)						 */
+	/*---------------------------------------------------*/
+	/* OpenJournal --------------------------------------*/
+	/*
+		Opens the journal for appending. If the journal on
+		disk belongs to a different generation, we start a
+		fresh one.
+	*/
+	void EditJournal::OpenJournal(unsigned int gen)
+	{
+		if (journal.is_open()) journal.close();
+
+		std::vector<uint8_t> header;
+		bool reuse = false;
+		if (ReadFile(journalPath, header) && header.size() >= 8)
+		{
+			reuse = (memcmp(header.data(), JOURNAL_MAGIC, 4) == 0 && ReadUint(header.data() + 4) == gen);
+		}
+
+		if (reuse)
+		{
+			journal.open(journalPath, std::ios::binary | std::ios::app);
+			return;
+		}
+
+		uint32_t g = gen;
+		journal.open(journalPath, std::ios::binary | std::ios::trunc);
+		journal.write(JOURNAL_MAGIC, 4);
+		journal.write((const char*)&g, sizeof(uint32_t));
+		journal.flush();
+	}
+
+	/* AppendBatch --------------------------------------*/
+	/*
+		Sorts a batch of edits by Morton code, keeps only
+		the last edit to each voxel, and appends the batch
+		to the journal as (delta, type) varint pairs.
+	*/
+	void EditJournal::AppendBatch(std::vector<Edit> edits)
+	{
+		PROFILE_SCOPE("EditJournal::AppendBatch");
+
+		/*
+			A stable sort keeps edits to the same voxel in
+			the order they were made, so the last one in
+			each run of equal codes is the one that counts.
+		*/
+		std::stable_sort(edits.begin(), edits.end(), [](const Edit& a, const Edit& b) { return a.morton < b.morton; });
+
+		size_t n = 0;
+		for (size_t i = 0; i < edits.size(); i++)
+		{
+			if (i + 1 < edits.size() && edits[i + 1].morton == edits[i].morton) continue;
+			edits[n++] = edits[i];
+		}
+		edits.resize(n);
+
+		std::vector<uint8_t> payload;
+		payload.reserve(4 + edits.size() * 3);
+		payload.resize(4);
+
+		WriteVarint(payload, edits.size());
+		uint64_t previous = 0;
+		for (size_t i = 0; i < edits.size(); i++)
+		{
+			WriteVarint(payload, edits[i].morton - previous);
+			WriteVarint(payload, edits[i].type);
+			previous = edits[i].morton;
+		}
+
+		uint32_t length = (uint32_t)(payload.size() - 4);
+		memcpy(payload.data(), &length, sizeof(uint32_t));
+
+		journal.write((const char*)payload.data(), payload.size());
+		journal.flush();
+	}
+
+	/* WriteBase ----------------------------------------*/
+	/*
+		Writes a snapshot of the voxel array as the new
+		base. We write to a temporary file first and then
+		swap it in, so a crash never leaves us with half a
+		base.
+
+		Returns whether the new base is in place.
+	*/
+	bool EditJournal::WriteBase(std::vector<Voxel> snapshot, unsigned int size, unsigned int gen, CodecType type)
+	{
+		PROFILE_SCOPE("EditJournal::WriteBase");
+
+		std::string tmpPath = basePath + ".tmp";
+
+		std::vector<uint8_t> encoded;
+		GetCodec(type)->Encode(snapshot.data(), (unsigned int)snapshot.size(), encoded);
+
+		{
+			std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				std::cout << "ERROR::JOURNAL::BASE_NOT_WRITTEN in " << tmpPath << std::endl;
+				return false;
+			}
+
+			uint32_t header[5] = { gen, size, (uint32_t)snapshot.size(), type, (uint32_t)encoded.size() };
+			file.write(BASE_MAGIC, 4);
+			file.write((const char*)header, sizeof(header));
+			file.write((const char*)encoded.data(), encoded.size());
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tmpPath, basePath, error);
+		if (error)
+		{
+			std::cout << "ERROR::JOURNAL::BASE_NOT_REPLACED in " << basePath << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	/*---------------------------------------------------*/
+	/* Load Functions									 */
+	/*---------------------------------------------------*/
+	/* ReadBase -----------------------------------------*/
+	/*
+		Decodes the base straight into the octree's voxel
+		pool, whichever codec it was written with.
+	*/
+	bool EditJournal::ReadBase(Octree* octree, unsigned int& gen)
+	{
+		std::vector<uint8_t> data;
+		if (!ReadFile(basePath, data) || data.size() < 24) return false;
+		if (memcmp(data.data(), BASE_MAGIC, 4) != 0) return false;
+
+		gen = ReadUint(data.data() + 4);
+		unsigned int size = ReadUint(data.data() + 8);
+		unsigned int count = ReadUint(data.data() + 12);
+		Codec* c = GetCodec((CodecType)ReadUint(data.data() + 16));
+		unsigned int encodedSize = ReadUint(data.data() + 20);
+
+		if (size != octree->GetSize() || count > octree->GetCapacity() || c == nullptr || data.size() < 24 + (size_t)encodedSize)
+		{
+			std::cout << "ERROR::JOURNAL::BASE_DOES_NOT_MATCH_OCTREE in " << basePath << std::endl;
+			return false;
+		}
+
+		if (!c->Decode(data.data() + 24, encodedSize, octree->GetVoxels(), count))
+		{
+			std::cout << "ERROR::JOURNAL::BASE_NOT_DECODED in " << basePath << std::endl;
+			octree->GetVoxels()[0] = { 0, -1 };
+			octree->Rebuild(1);
+			return false;
+		}
+
+		// A base can decode fine and still be nonsense (the
+		// raw codec takes any bytes of the right length), so
+		// Rebuild checks the child pointers before using them.
+		if (!octree->Rebuild(count))
+		{
+			std::cout << "ERROR::JOURNAL::BASE_CORRUPT in " << basePath << std::endl;
+			octree->GetVoxels()[0] = { 0, -1 };
+			octree->Rebuild(1);
+			return false;
+		}
+
+		return true;
+	}
+
+	/* ReplayJournal ------------------------------------*/
+	/*
+		Applies the edits in a journal to the octree, so
+		long as the journal is at least as new as the base.
+		Each batch is decoded in full before any of it is
+		applied, and only if every varint reads cleanly and
+		every voxel is inside the octree. Otherwise, or if
+		the last batch was only partly written (we crashed
+		mid-flush), we stop there and cut the journal off,
+		so that new batches can be appended cleanly.
+	*/
+	bool EditJournal::ReplayJournal(const std::string& path, Octree* octree, unsigned int minGen, unsigned int& gen)
+	{
+		std::vector<uint8_t> data;
+		if (!ReadFile(path, data) || data.size() < 8) return false;
+		if (memcmp(data.data(), JOURNAL_MAGIC, 4) != 0) return false;
+
+		unsigned int g = ReadUint(data.data() + 4);
+		if (g < minGen) return false;
+		gen = std::max(gen, g);
+
+		unsigned int size = octree->GetSize();
+		std::vector<Edit> edits;
+
+		size_t cursor = 8;
+		while (data.size() - cursor >= 4)
+		{
+			size_t length = ReadUint(data.data() + cursor);
+			if (data.size() - cursor - 4 < length) break;
+			if (!DecodeBatch(data.data() + cursor + 4, length, size, edits))
+			{
+				std::cout << "ERROR::JOURNAL::BATCH_CORRUPT in " << path << std::endl;
+				break;
+			}
+
+			for (Edit& edit : edits)
+			{
+				unsigned int x, y, z;
+				MortonDecode(edit.morton, x, y, z);
+
+				if (edit.type == 0) octree->RemoveVoxel(x, y, z);
+				else octree->AddVoxel(x, y, z, edit.type);
+			}
+
+			cursor += 4 + length;
+		}
+
+		if (cursor < data.size())
+		{
+			std::error_code error;
+			std::filesystem::resize_file(path, cursor, error);
+		}
+
+		return true;
+	}
+
+	/* DecodeBatch --------------------------------------*/
+	/*
+		Decodes one batch as AppendBatch wrote it. A batch
+		is good only if it's exactly as long as its edits,
+		every type fits in 16 bits and every voxel is in
+		an octree of the given size.
+	*/
+	bool EditJournal::DecodeBatch(const uint8_t* batch, size_t length, unsigned int size, std::vector<Edit>& edits)
+	{
+		edits.clear();
+
+		size_t c = 0;
+		uint64_t count, delta, type;
+		uint64_t morton = 0;
+
+		if (!ReadVarint(batch, length, c, count) || count > length) return false;
+		edits.reserve(count);
+
+		for (uint64_t i = 0; i < count; i++)
+		{
+			if (!ReadVarint(batch, length, c, delta) || !ReadVarint(batch, length, c, type)) return false;
+			if (type > UINT16_MAX) return false;
+			morton += delta;
+
+			unsigned int x, y, z;
+			MortonDecode(morton, x, y, z);
+			if (x >= size || y >= size || z >= size || MortonEncode(x, y, z) != morton) return false;
+
+			edits.push_back({ morton, (uint16_t)type });
+		}
+
+		return c == length;
+	}
+
+	/*---------------------------------------------------*/
+	/* General Functions								 */
+	/*---------------------------------------------------*/
+	/* Load ---------------------------------------------*/
+	/*
+		Load reads the last checkpoint into the octree and
+		applies any journaled edits on top of it.
+
+		Input:		Octree to load into (must match the saved size).
+		Output:		Whether a saved world was found.
+	*/
+	bool EditJournal::Load(Octree* octree)
+	{
+		PROFILE_SCOPE("EditJournal::Load");
+
+		octree->SetJournal(nullptr);
+
+		unsigned int baseGen = 0;
+		bool found = ReadBase(octree, baseGen);
+
+		unsigned int gen = baseGen;
+		if (found)
+		{
+			ReplayJournal(oldJournalPath, octree, baseGen, gen);
+			ReplayJournal(journalPath, octree, baseGen, gen);
+		}
+
+		generation = gen;
+		return found;
+	}
+
+	/* Attach -------------------------------------------*/
+	/*
+		Attach starts recording the octree's edits. Call
+		it after Load (and after generating a new world,
+		if Load found nothing). If there is no base yet,
+		the octree as it stands becomes the first one. (A
+		base that exists but can't be read is left alone
+		rather than overwritten.)
+	*/
+	void EditJournal::Attach(Octree* octree)
+	{
+		unsigned int gen = generation;
+		Enqueue([this, gen] { OpenJournal(gen); });
+
+		octree->SetJournal(this);
+		if (!std::filesystem::exists(basePath)) Checkpoint(octree);
+	}
+
+	/* Update -------------------------------------------*/
+	/*
+		Update decides whether it's time to flush or to
+		checkpoint. Both happen in the background.
+	*/
+	void EditJournal::Update(Octree* octree)
+	{
+		auto now = std::chrono::steady_clock::now();
+
+		if (!pending.empty() && now - lastFlush >= std::chrono::duration<float>(flushInterval)) Flush();
+
+		if (sinceCheckpoint >= checkpointEdits ||
+			(sinceCheckpoint > 0 && now - lastCheckpoint >= std::chrono::duration<float>(checkpointInterval)))
+		{
+			Checkpoint(octree);
+		}
+	}
+
+	/*---------------------------------------------------*/
+	/* Edit Functions									 */
+	/*---------------------------------------------------*/
+	/* Record -------------------------------------------*/
+	/*
+		Called by the octree for every edit. A type of 0
+		means the voxel was removed.
+	*/
+	void EditJournal::Record(unsigned int x, unsigned int y, unsigned int z, uint16_t t)
+	{
+		pending.push_back({ MortonEncode(x, y, z), t });
+		sinceCheckpoint++;
+	}
+
+	/* Flush --------------------------------------------*/
+	/*
+		Hands the pending edits to the worker. This is
+		what a "save" is: its cost depends only on the
+		number of edits since the last flush.
+	*/
+	void EditJournal::Flush()
+	{
+		PROFILE_SCOPE("EditJournal::Flush");
+
+		lastFlush = std::chrono::steady_clock::now();
+		if (pending.empty()) return;
+
+		std::vector<Edit> batch;
+		batch.swap(pending);
+		Enqueue([this, batch = std::move(batch)]() mutable { AppendBatch(std::move(batch)); });
+	}
+
+	/* Checkpoint ---------------------------------------*/
+	/*
+		Snapshots the voxel array and folds the journal
+		into a new base. Edits made after the snapshot go
+		into a fresh journal of the next generation.
+
+		Nothing is deleted until the new base is safely on
+		disk: up to then, the old base and its journals
+		(including an old journal left by a checkpoint that
+		crashed, in saves from before this order) still
+		make up the world. If the base can't be written,
+		we carry on appending to the journal we have.
+	*/
+	void EditJournal::Checkpoint(Octree* octree)
+	{
+		PROFILE_SCOPE("EditJournal::Checkpoint");
+
+		Flush();
+
+		std::vector<Voxel> snapshot(octree->GetVoxels(), octree->GetVoxels() + octree->GetCursor());
+		unsigned int size = octree->GetSize();
+		unsigned int gen = ++generation;
+		CodecType type = codec;
+
+		sinceCheckpoint = 0;
+		lastCheckpoint = std::chrono::steady_clock::now();
+
+		Enqueue([this, snapshot = std::move(snapshot), size, gen, type]() mutable
+		{
+			journal.close();
+
+			if (!WriteBase(std::move(snapshot), size, gen, type))
+			{
+				journal.open(journalPath, std::ios::binary | std::ios::app);
+				return;
+			}
+
+			// The journals are now folded into the base.
+			std::error_code error;
+			std::filesystem::remove(oldJournalPath, error);
+			OpenJournal(gen);
+		});
+	}
+
+	/*---------------------------------------------------*/
+	/* Constructor										 */
+	/*---------------------------------------------------*/
+	/*
+		Input:		Path of the world on disk, without extension.
+		Output:		None
+	*/
+	EditJournal::EditJournal(std::string path)
+	{
+		this->basePath = path + ".base";
+		this->journalPath = path + ".journal";
+		this->oldJournalPath = path + ".journal.old";
+
+		this->sinceCheckpoint = 0;
+		this->generation = 0;
+		this->stopping = false;
+
+		this->lastFlush = std::chrono::steady_clock::now();
+		this->lastCheckpoint = lastFlush;
+
+		this->worker = std::thread(&EditJournal::Run, this);
+	}
+
+	/*---------------------------------------------------*/
+	/* Deconstructor									 */
+	/*---------------------------------------------------*/
+	/*
+		Flushes whatever is left and waits for the worker
+		to finish writing it.
+	*/
+	EditJournal::~EditJournal()
+	{
+		Flush();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+		worker.join();
+
+		if (journal.is_open()) journal.close();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <condition_variable>
+
+#include "codec.h"
+#include "octree.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Edit Journal																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Edit																	 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		A single change to the world. The position is stored as a Morton
+		code and a type of 0 means the voxel was removed.
+	*/
+	struct Edit
+	{
+		uint64_t		morton;
+		uint16_t		type;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Edit Journal															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Saving a world should not mean writing out the whole octree
+		every time a cannonball knocks a hole in a pier. Instead, the
+		world on disk is split in two:
+
+			<path>.base		A full snapshot of the voxel array (checkpoint).
+			<path>.journal	Every edit made since that snapshot.
+
+		The octree reports each AddVoxel / RemoveVoxel to the journal,
+		which keeps them in memory until the next flush. A flush sorts
+		the batch by Morton code, drops all but the last edit to any one
+		voxel, and appends it to the journal file as delta-encoded
+		varints. So the cost of a save is proportional to the number of
+		edits, not the size of the world.
+
+		Every so often we checkpoint: the voxel array is copied and the
+		copy is compressed (see codec.h) and written out as the new base,
+		after which the old journal can be thrown away. All file work
+		(flushes and checkpoints) runs in order on a single worker thread
+		so the game never waits on the disk.
+
+		Both files carry a generation number. A journal holds the edits
+		made after the base of the same generation was snapshotted, so
+		on load we apply every journal whose generation is at least that
+		of the base. This keeps us consistent even if we crash halfway
+		through a checkpoint.
+	*/
+	class EditJournal
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Paths											   */
+		/*-----------------------------------------------------*/
+		std::string				basePath;
+		std::string				journalPath;
+		std::string				oldJournalPath;
+
+		/*-----------------------------------------------------*/
+		/* Edits											   */
+		/*-----------------------------------------------------*/
+		std::vector<Edit>		pending;
+		unsigned int			sinceCheckpoint;
+		unsigned int			generation;
+
+		/*-----------------------------------------------------*/
+		/* Policy											   */
+		/*-----------------------------------------------------*/
+		std::chrono::steady_clock::time_point	lastFlush;
+		std::chrono::steady_clock::time_point	lastCheckpoint;
+
+		/*-----------------------------------------------------*/
+		/* Worker											   */
+		/*-----------------------------------------------------*/
+		std::thread				worker;
+		std::mutex				mutex;
+		std::condition_variable	condition;
+		std::deque<std::function<void()>>	tasks;
+		bool					stopping;
+		std::ofstream			journal;
+
+		void					Run();
+		void					Enqueue(std::function<void()> task);
+
+		/*-----------------------------------------------------*/
+		/* File Functions (Worker Only)						   */
+		/*-----------------------------------------------------*/
+		void					OpenJournal(unsigned int gen);
+		void					AppendBatch(std::vector<Edit> edits);
+		bool					WriteBase(std::vector<Voxel> snapshot, unsigned int size, unsigned int gen, CodecType type);
+
+		/*-----------------------------------------------------*/
+		/* Load Functions									   */
+		/*-----------------------------------------------------*/
+		bool					ReadBase(Octree* octree, unsigned int& gen);
+		bool					ReplayJournal(const std::string& path, Octree* octree, unsigned int minGen, unsigned int& gen);
+		bool					DecodeBatch(const uint8_t* batch, size_t length, unsigned int size, std::vector<Edit>& edits);
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Settings											   */
+		/*-----------------------------------------------------*/
+		float					flushInterval = 1.0f;
+		float					checkpointInterval = 300.0f;
+		unsigned int			checkpointEdits = 1 << 20;
+		CodecType				codec = CODEC_OCTREE;
+
+		/*-----------------------------------------------------*/
+		/* General Functions								   */
+		/*-----------------------------------------------------*/
+		bool					Load(Octree* octree);
+		void					Attach(Octree* octree);
+		void					Update(Octree* octree);
+
+		/*-----------------------------------------------------*/
+		/* Edit Functions									   */
+		/*-----------------------------------------------------*/
+		void					Record(unsigned int x, unsigned int y, unsigned int z, uint16_t t);
+		void					Flush();
+		void					Checkpoint(Octree* octree);
+		void					Wait();
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		EditJournal(std::string path);
+		~EditJournal();
+	};
+}
+
+#endif
\ No newline at end of file
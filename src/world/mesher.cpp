@@ -0,0 +1,526 @@
+#include "mesher.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Greedy Meshing																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*
+		How far apart neighbours are in a chunk's grid, along x, y and z.
+	*/
+	const int GRID_STRIDE[3] = { 1, (int)CHUNK_GRID, (int)(CHUNK_GRID * CHUNK_GRID) };
+
+	/*-----------------------------------------------------------------------*/
+	/* Helper Functions														 */
+	/*-----------------------------------------------------------------------*/
+	/* GridIndex --------------------------------------------*/
+	/*
+		Input: Coordinates in the chunk (-1 to CHUNK_SIZE)
+		Output: Where they are in its grid
+	*/
+	static int GridIndex(const int p[3])
+	{
+		return (p[0] + 1) * GRID_STRIDE[0] + (p[1] + 1) * GRID_STRIDE[1] + (p[2] + 1) * GRID_STRIDE[2];
+	}
+
+	/* FillRegion -------------------------------------------*/
+	/*
+		Walks down the octree, skipping any node that doesn't
+		overlap the grid, and writes each solid leaf's type
+		over the part of the grid it covers. The grid starts
+		out as air, so empty leaves are skipped too.
+
+		Input: Voxels, node, its min corner & size, the grid
+			   (and its min corner in the world) & whether
+			   anything solid has turned up inside the chunk
+		Output: None
+	*/
+	static void FillRegion(const Voxel* voxels, int index, const int corner[3], int s, const int lo[3], std::vector<unsigned int>& types, bool& solid)
+	{
+		int a[3], b[3];
+		for (int i = 0; i < 3; i++)
+		{
+			a[i] = std::max(corner[i], lo[i]);
+			b[i] = std::min(corner[i] + s, lo[i] + (int)CHUNK_GRID);
+			if (a[i] >= b[i]) return;
+		}
+
+		const Voxel& voxel = voxels[index];
+
+		if (voxel.children < 0)
+		{
+			if (voxel.type == 0) return;
+
+			for (int z = a[2]; z < b[2]; z++)
+			{
+				for (int y = a[1]; y < b[1]; y++)
+				{
+					for (int x = a[0]; x < b[0]; x++)
+					{
+						int p[3] = { x - lo[0] - 1, y - lo[1] - 1, z - lo[2] - 1 };
+						types[GridIndex(p)] = voxel.type;
+
+						if (p[0] >= 0 && p[1] >= 0 && p[2] >= 0 && p[0] < (int)CHUNK_SIZE && p[1] < (int)CHUNK_SIZE && p[2] < (int)CHUNK_SIZE) solid = true;
+					}
+				}
+			}
+			return;
+		}
+
+		s /= 2;
+		for (int octant = 0; octant < 8; octant++)
+		{
+			int child[3] = { corner[0] + (octant & 1) * s, corner[1] + ((octant >> 1) & 1) * s, corner[2] + ((octant >> 2) & 1) * s };
+			FillRegion(voxels, voxel.children + octant, child, s, lo, types, solid);
+		}
+	}
+
+	/* PushFace ---------------------------------------------*/
+	/*
+		Adds a w x h rectangle of faces to a mesh, facing
+		down the given axis (the negative side) or up it.
+		Its texture coordinates count voxels, so a texture
+		could repeat across it.
+
+		Input: Mesh, corner, axis, side, the two axes across
+			   the face, its size & color
+		Output: None
+	*/
+	static void PushFace(std::vector<Vertex>& vertices, const int corner[3], int d, int side, int u, int v, int w, int h, glm::vec4 color)
+	{
+		float p[4][3];
+		float st[4][2] = { { 0.0f, 0.0f }, { (float)w, 0.0f }, { (float)w, (float)h }, { 0.0f, (float)h } };
+
+		for (int k = 0; k < 4; k++)
+		{
+			p[k][d] = (float)corner[d];
+			p[k][u] = (float)corner[u] + st[k][0];
+			p[k][v] = (float)corner[v] + st[k][1];
+		}
+
+		/*
+			u x v points up the axis, so going round u then v
+			is counter-clockwise seen from the positive side.
+			The negative side goes the other way round.
+		*/
+		int order[2][4] = { { 0, 3, 2, 1 }, { 0, 1, 2, 3 } };
+
+		for (int k = 0; k < 4; k++)
+		{
+			int c = order[side][k];
+			vertices.push_back({ p[c][0], p[c][1], p[c][2], color.x, color.y, color.z, color.w, st[c][0], st[c][1] });
+		}
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Meshing Functions													 */
+	/*-----------------------------------------------------------------------*/
+	/* FaceColor --------------------------------------------*/
+	/*
+		The same flat color per type, shaded by axis, as
+		resolve.frag gives the tracer's hits.
+
+		Input: Voxel type & axis the face is across
+		Output: Color
+	*/
+	glm::vec4 FaceColor(unsigned int type, unsigned int axis)
+	{
+		const float palette[4][3] = { { 1.0f, 1.0f, 1.0f }, { 0.5f, 0.5f, 0.52f }, { 0.86f, 0.78f, 0.55f }, { 0.12f, 0.3f, 0.55f } };
+		const float faceShade[3] = { 0.8f, 0.65f, 1.0f };
+
+		const float* c = palette[std::min(type, 3u)];
+		float shade = faceShade[std::min(axis, 2u)];
+
+		return { c[0] * shade, c[1] * shade, c[2] * shade, 1.0f };
+	}
+
+	/* ReadChunk --------------------------------------------*/
+	/*
+		Input: Voxels, octree size, the chunk's min corner &
+			   the grid to fill in
+		Output: Whether there's anything solid in the chunk
+	*/
+	bool ReadChunk(const Voxel* voxels, unsigned int size, glm::ivec3 origin, std::vector<unsigned int>& types)
+	{
+		PROFILE_SCOPE("ReadChunk");
+
+		types.assign(CHUNK_GRID * CHUNK_GRID * CHUNK_GRID, 0);
+
+		int corner[3] = { 0, 0, 0 };
+		int lo[3] = { origin.x - 1, origin.y - 1, origin.z - 1 };
+		bool solid = false;
+
+		FillRegion(voxels, 0, corner, (int)size, lo, types, solid);
+		return solid;
+	}
+
+	/* MeshChunk --------------------------------------------*/
+	/*
+		For each axis and each side of it, we go through the
+		chunk a slice at a time. The slice's mask holds the
+		type of each voxel whose face on that side is
+		exposed (or 0). Then, from the bottom left, each
+		face we find is grown as far as it'll go along u,
+		and then row by row along v for as long as the whole
+		row matches, and that rectangle comes out of the
+		mask as one quad.
+
+		Input: A chunk's grid, its min corner & the mesh to
+			   add its faces to
+		Output: None
+	*/
+	void MeshChunk(const std::vector<unsigned int>& types, glm::ivec3 origin, std::vector<Vertex>& vertices)
+	{
+		PROFILE_SCOPE("MeshChunk");
+
+		const int n = (int)CHUNK_SIZE;
+		int base[3] = { origin.x, origin.y, origin.z };
+		std::vector<unsigned int> mask(n * n);
+
+		for (int d = 0; d < 3; d++)
+		{
+			int u = (d + 1) % 3;
+			int v = (d + 2) % 3;
+
+			for (int side = 0; side < 2; side++)
+			{
+				int neighbour = side ? GRID_STRIDE[d] : -GRID_STRIDE[d];
+
+				for (int s = 0; s < n; s++)
+				{
+					int p[3];
+					p[d] = s;
+
+					for (int j = 0; j < n; j++)
+					{
+						for (int i = 0; i < n; i++)
+						{
+							p[u] = i;
+							p[v] = j;
+
+							int index = GridIndex(p);
+							unsigned int type = types[index];
+							mask[i + j * n] = (type != 0 && types[index + neighbour] == 0) ? type : 0;
+						}
+					}
+
+					for (int j = 0; j < n; j++)
+					{
+						for (int i = 0; i < n;)
+						{
+							unsigned int type = mask[i + j * n];
+							if (type == 0)
+							{
+								i++;
+								continue;
+							}
+
+							int w = 1;
+							while (i + w < n && mask[i + w + j * n] == type) w++;
+
+							int h = 1;
+							for (; j + h < n; h++)
+							{
+								bool match = true;
+								for (int k = 0; k < w && match; k++) match = (mask[i + k + (j + h) * n] == type);
+								if (!match) break;
+							}
+
+							for (int y = 0; y < h; y++) std::fill(&mask[i + (j + y) * n], &mask[i + (j + y) * n] + w, 0u);
+
+							int corner[3];
+							corner[d] = base[d] + s + side;
+							corner[u] = base[u] + i;
+							corner[v] = base[v] + j;
+							PushFace(vertices, corner, d, side, u, v, w, h, FaceColor(type, d));
+
+							i += w;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/* FindChunks -------------------------------------------*/
+	/*
+		Input: Edited boxes, chunks to a side of the world &
+			   where to list the chunks they touch
+		Output: None
+	*/
+	void FindChunks(const std::vector<Box>& boxes, unsigned int chunksPerSide, std::vector<unsigned int>& chunks)
+	{
+		int last = (int)chunksPerSide - 1;
+
+		for (const Box& box : boxes)
+		{
+			int lo[3], hi[3];
+			for (int i = 0; i < 3; i++)
+			{
+				lo[i] = std::clamp((int)std::floor((box.min[i] - 1.0f) / CHUNK_SIZE), 0, last);
+				hi[i] = std::clamp((int)std::floor(box.max[i] / CHUNK_SIZE), 0, last);
+			}
+
+			for (int z = lo[2]; z <= hi[2]; z++)
+			{
+				for (int y = lo[1]; y <= hi[1]; y++)
+				{
+					for (int x = lo[0]; x <= hi[0]; x++) chunks.push_back(x + (y + z * chunksPerSide) * chunksPerSide);
+				}
+			}
+		}
+	}
+
+	/* ValidateMesh -----------------------------------------*/
+	/*
+		Input: A chunk's grid, its min corner, its mesh &
+			   where to put how many faces are exposed
+		Output: How many faces the mesh gets wrong
+	*/
+	unsigned int ValidateMesh(const std::vector<unsigned int>& types, glm::ivec3 origin, const std::vector<Vertex>& vertices, unsigned int& exposedFaces)
+	{
+		const int n = (int)CHUNK_SIZE;
+		int base[3] = { origin.x, origin.y, origin.z };
+		unsigned int mismatches = 0;
+
+		/*
+			First, which faces the mesh covers: a count for
+			each side of each voxel.
+		*/
+		std::vector<unsigned int> covered(6 * n * n * n, 0);
+
+		for (size_t q = 0; q + 3 < vertices.size(); q += 4)
+		{
+			const Vertex* quad = &vertices[q];
+			glm::vec3 corners[4];
+			for (int k = 0; k < 4; k++) corners[k] = { quad[k].x, quad[k].y, quad[k].z };
+
+			/*
+				The axis it's across is the one all four
+				corners agree on, and the winding says which
+				way it faces.
+			*/
+			int d = -1;
+			for (int a = 0; a < 3 && d < 0; a++)
+			{
+				if (corners[0][a] == corners[1][a] && corners[0][a] == corners[2][a] && corners[0][a] == corners[3][a]) d = a;
+			}
+			if (d < 0)
+			{
+				mismatches++;
+				continue;
+			}
+
+			int u = (d + 1) % 3;
+			int v = (d + 2) % 3;
+			int side = (glm::cross(corners[1] - corners[0], corners[3] - corners[0])[d] > 0.0f) ? 1 : 0;
+
+			int plane = (int)std::lround(corners[0][d]);
+			int lo[3], hi[3];
+			for (int a = 0; a < 3; a++)
+			{
+				lo[a] = (int)std::lround(std::min(std::min(corners[0][a], corners[1][a]), std::min(corners[2][a], corners[3][a])));
+				hi[a] = (int)std::lround(std::max(std::max(corners[0][a], corners[1][a]), std::max(corners[2][a], corners[3][a])));
+			}
+
+			for (int j = lo[v]; j < hi[v]; j++)
+			{
+				for (int i = lo[u]; i < hi[u]; i++)
+				{
+					int p[3];
+					p[d] = plane - side - base[d];
+					p[u] = i - base[u];
+					p[v] = j - base[v];
+
+					if (p[0] < 0 || p[1] < 0 || p[2] < 0 || p[0] >= n || p[1] >= n || p[2] >= n)
+					{
+						mismatches++;
+						continue;
+					}
+
+					glm::vec4 expected = FaceColor(types[GridIndex(p)], d);
+					bool colored = true;
+					for (int k = 0; k < 4; k++) colored = colored && quad[k].r == expected.x && quad[k].g == expected.y && quad[k].b == expected.z && quad[k].a == expected.w;
+					if (!colored) mismatches++;
+
+					covered[((d * 2 + side) * n + p[2]) * n * n + p[1] * n + p[0]]++;
+				}
+			}
+		}
+
+		/*
+			Then which faces it should: those of solid voxels
+			with air on the other side.
+		*/
+		exposedFaces = 0;
+
+		for (int d = 0; d < 3; d++)
+		{
+			for (int side = 0; side < 2; side++)
+			{
+				int neighbour = side ? GRID_STRIDE[d] : -GRID_STRIDE[d];
+
+				for (int z = 0; z < n; z++)
+				{
+					for (int y = 0; y < n; y++)
+					{
+						for (int x = 0; x < n; x++)
+						{
+							int p[3] = { x, y, z };
+							int index = GridIndex(p);
+							unsigned int expected = (types[index] != 0 && types[index + neighbour] == 0) ? 1 : 0;
+
+							exposedFaces += expected;
+							if (covered[((d * 2 + side) * n + z) * n * n + y * n + x] != expected) mismatches++;
+						}
+					}
+				}
+			}
+		}
+
+		return mismatches;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Chunk Mesher															 */
+	/*-----------------------------------------------------------------------*/
+	/*-----------------------------------------------------*/
+	/* Worker Functions									   */
+	/*-----------------------------------------------------*/
+	/* Run ------------------------------------------------*/
+	/*
+		Each worker takes the oldest job, meshes it and
+		files the mesh under finished, until we ask them to
+		stop.
+	*/
+	void ChunkMesher::Run()
+	{
+		while (true)
+		{
+			Job job;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return stopping || !jobs.empty(); });
+				if (stopping) return;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+				this->busy++;
+			}
+
+			ChunkMesh mesh = { job.chunk, job.version, {} };
+			MeshChunk(job.types, job.origin, mesh.vertices);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				this->finished.push_back(std::move(mesh));
+				this->busy--;
+			}
+			condition.notify_all();
+		}
+	}
+
+	/*-----------------------------------------------------*/
+	/* Job Functions									   */
+	/*-----------------------------------------------------*/
+	/* Submit ---------------------------------------------*/
+	/*
+		Queues a chunk to be meshed.
+
+		Input: Chunk, its version, its min corner & its grid
+			   (see ReadChunk)
+		Output: None
+	*/
+	void ChunkMesher::Submit(unsigned int chunk, unsigned int version, glm::ivec3 origin, std::vector<unsigned int> types)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back({ chunk, version, origin, std::move(types) });
+		}
+		condition.notify_one();
+	}
+
+	/* TakeMeshes -----------------------------------------*/
+	/*
+		Hands over the meshes finished since the last call.
+
+		Input: Vector to add them to
+		Output: Whether there were any
+	*/
+	bool ChunkMesher::TakeMeshes(std::vector<ChunkMesh>& meshes)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (finished.empty()) return false;
+
+		for (ChunkMesh& mesh : finished) meshes.push_back(std::move(mesh));
+		finished.clear();
+		return true;
+	}
+
+	/* GetPending -----------------------------------------*/
+	/*
+		Input: None
+		Output: How many chunks have been submitted and not
+				yet taken
+	*/
+	unsigned int ChunkMesher::GetPending()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return (unsigned int)(jobs.size() + finished.size()) + busy;
+	}
+
+	/* Wait -----------------------------------------------*/
+	/*
+		Blocks until every chunk submitted so far has been
+		meshed.
+	*/
+	void ChunkMesher::Wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this] { return jobs.empty() && busy == 0; });
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor & Deconstructor						   */
+	/*-----------------------------------------------------*/
+	/* Constructor ----------------------------------------*/
+	/*
+		Input: How many workers to start (0 for one fewer
+			   than the machine has cores, so the main
+			   thread keeps one to itself)
+		Output: (Chunk Mesher)
+	*/
+	ChunkMesher::ChunkMesher(unsigned int threads)
+	{
+		this->busy = 0;
+		this->stopping = false;
+
+		if (threads == 0) threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+		for (unsigned int i = 0; i < threads; i++) workers.push_back(std::thread(&ChunkMesher::Run, this));
+	}
+
+	/* Deconstructor --------------------------------------*/
+	/*
+		Whatever's still queued is dropped; we only wait for
+		the chunks the workers are in the middle of.
+	*/
+	ChunkMesher::~ChunkMesher()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.clear();
+			stopping = true;
+		}
+		condition.notify_all();
+
+		for (std::thread& worker : workers) worker.join();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#ifndef MESHER_H
+#define MESHER_H
+
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include <glm/glm.hpp>
+
+#include "octree.h"
+#include "../util/polygons.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Greedy Meshing																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*
+		The world is meshed in cubes of CHUNK_SIZE voxels a side. A
+		chunk's voxels are read into a grid one voxel bigger on every
+		side (CHUNK_GRID a side), so we can tell whether the faces on
+		its edges are hidden by the neighbouring chunks without looking
+		at them.
+	*/
+	const unsigned int CHUNK_SIZE = 32;
+	const unsigned int CHUNK_GRID = CHUNK_SIZE + 2;
+
+	/*-----------------------------------------------------------------------*/
+	/* Chunk Mesh															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		The faces of one chunk, four vertices (a quad, counter-clockwise
+		seen from outside) to a face, in world space: voxel (x, y, z)
+		spans (x, y, z) to one more than that, as the tracer sees it.
+		Version is whatever the chunk's version was when it was read, so
+		a mesh that's been overtaken by an edit can be thrown away.
+	*/
+	struct ChunkMesh
+	{
+		unsigned int			chunk;
+		unsigned int			version;
+		std::vector<Vertex>		vertices;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Meshing Functions													 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		ReadChunk copies a chunk's voxels (and the border around it) out
+		of the octree into a flat grid of types, x fastest. Anything
+		outside the world is air.
+
+		MeshChunk turns that grid into faces. Only faces between a solid
+		voxel and air are kept, and each slice of faces facing the same
+		way is merged greedily into as few rectangles as it'll go, as
+		long as they're all the same type. They're colored as
+		resolve.frag would color the tracer's hits, so the two look the
+		same.
+
+		FindChunks lists the chunks (numbered x fastest, chunksPerSide to
+		a side) whose faces an edit inside any of the boxes could have
+		changed. That's the chunks each box touches once it's grown by a
+		voxel, since the faces of the voxels next to an edit change too.
+		A chunk can come up more than once.
+
+		ValidateMesh is the reference to check MeshChunk against: it
+		marks every voxel face the mesh covers, and counts each one
+		that's covered when it shouldn't be (or the other way around),
+		covered twice, or the wrong color. It also says how many faces
+		there'd be with no merging at all.
+	*/
+	bool			ReadChunk(const Voxel* voxels, unsigned int size, glm::ivec3 origin, std::vector<unsigned int>& types);
+	void			MeshChunk(const std::vector<unsigned int>& types, glm::ivec3 origin, std::vector<Vertex>& vertices);
+	void			FindChunks(const std::vector<Box>& boxes, unsigned int chunksPerSide, std::vector<unsigned int>& chunks);
+	unsigned int	ValidateMesh(const std::vector<unsigned int>& types, glm::ivec3 origin, const std::vector<Vertex>& vertices, unsigned int& exposedFaces);
+	glm::vec4		FaceColor(unsigned int type, unsigned int axis);
+
+	/*-----------------------------------------------------------------------*/
+	/* Chunk Mesher															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Meshes chunks on a pool of worker threads. The octree isn't safe
+		to read while it's being edited, so the workers never see it:
+		whoever submits a chunk reads its voxels (ReadChunk, which is
+		quick) and hands the grid over, and the greedy merge, which is
+		the slow part, happens on a worker. Finished meshes wait until
+		someone takes them, in whatever order they finished.
+	*/
+	class ChunkMesher
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* Job												   */
+		/*-----------------------------------------------------*/
+		struct Job
+		{
+			unsigned int				chunk;
+			unsigned int				version;
+			glm::ivec3					origin;
+			std::vector<unsigned int>	types;
+		};
+
+		/*-----------------------------------------------------*/
+		/* Workers											   */
+		/*-----------------------------------------------------*/
+		std::vector<std::thread>	workers;
+		std::mutex					mutex;
+		std::condition_variable		condition;
+		std::deque<Job>				jobs;
+		std::vector<ChunkMesh>		finished;
+		unsigned int				busy;
+		bool						stopping;
+
+		void						Run();
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Job Functions									   */
+		/*-----------------------------------------------------*/
+		void						Submit(unsigned int chunk, unsigned int version, glm::ivec3 origin, std::vector<unsigned int> types);
+		bool						TakeMeshes(std::vector<ChunkMesh>& meshes);
+		unsigned int				GetPending();
+		void						Wait();
+
+		/*-----------------------------------------------------*/
+		/* Worker Functions									   */
+		/*-----------------------------------------------------*/
+		unsigned int				GetThreadCount() { return (unsigned int)workers.size(); }
+
+		/*-----------------------------------------------------*/
+		/* Constructor & Deconstructor						   */
+		/*-----------------------------------------------------*/
+		ChunkMesher(unsigned int threads = 0);
+		~ChunkMesher();
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "octree.h"
+#include "journal.h"
 
 #include <cmath>
-#include <corecrt_malloc.h>
-#include <time.h>
+#include <cstdlib>
 #include <iostream>
 
+#include "../util/profiler.h"
+
 namespace Winedark
 {
 	/*----------------------------------------------------------------------------------------------*/
@@ -15,6 +17,17 @@ namespace Winedark
 	/*-----------------------------------------------------------------------*/
 	/* Octree																 */
 	/*-----------------------------------------------------------------------*/
+	/*
+		Edits remember the boxes they touched so the renderer only has
+		to re-trace the pixels that can see them. Edits right next to
+		the last box grow it, as long as it stays smaller than
+		MAX_DIRTY_EXTENT on every side, so a crater ends up as a box or
+		two rather than one per voxel. Past MAX_DIRTY_BOXES boxes we
+		give up and call the whole world dirty.
+	*/
+	const unsigned int MAX_DIRTY_BOXES = 64;
+	const float MAX_DIRTY_EXTENT = 32.0f;
+
 	/*---------------------------------------------------*/
 	/* Utility Functions								 */
 	/*---------------------------------------------------*/
@@ -52,80 +65,134 @@ namespace Winedark
 	}
 
 	/*---------------------------------------------------*/
-	/* General Functions								 */
+	/* Dirty Box Functions								 */
 	/*---------------------------------------------------*/
-	/* Update -------------------------------------------*/
+	/* MarkDirty ----------------------------------------*/
 	/*
-		Update currently checks if the octree has been
-		updated and, if so, writes it to the buffer.
+		Adds a voxel to the dirty boxes, growing the last
+		box if the voxel is next to it.
+
+		Input: (Global) Coordinates
+		Output: None
 	*/
-	void Octree::Update()
+	void Octree::MarkDirty(unsigned int x, unsigned int y, unsigned int z)
 	{
-		if (updated)
+		if (allDirty) return;
+
+		Box box = { glm::vec3(x, y, z), glm::vec3(x + 1, y + 1, z + 1) };
+
+		if (!dirtyBoxes.empty())
 		{
-			updated = false;
-			WriteBuffer();
-			HasChanged();
+			Box& last = dirtyBoxes.back();
+			glm::vec3 lo = glm::min(last.min, box.min);
+			glm::vec3 hi = glm::max(last.max, box.max);
+
+			bool touching = glm::all(glm::lessThanEqual(box.min, last.max + 1.0f)) && glm::all(glm::greaterThanEqual(box.max, last.min - 1.0f));
+			bool small = glm::all(glm::lessThanEqual(hi - lo, glm::vec3(MAX_DIRTY_EXTENT)));
+
+			if (touching && small)
+			{
+				last = { lo, hi };
+				return;
+			}
+		}
+
+		if (dirtyBoxes.size() == MAX_DIRTY_BOXES)
+		{
+			dirtyBoxes.clear();
+			allDirty = true;
+			return;
 		}
+
+		dirtyBoxes.push_back(box);
+	}
+
+	/* TakeDirtyBoxes -----------------------------------*/
+	/*
+		Hands over the boxes edited since the last call
+		and starts afresh.
+
+		Input: Vector to add the boxes to
+		Output: False if the whole world is dirty
+	*/
+	bool Octree::TakeDirtyBoxes(std::vector<Box>& boxes)
+	{
+		bool some = !allDirty;
+
+		boxes.insert(boxes.end(), dirtyBoxes.begin(), dirtyBoxes.end());
+		dirtyBoxes.clear();
+		allDirty = false;
+
+		return some;
 	}
 
-	/* OverwriteBufferData ------------------------------*/
+	/*---------------------------------------------------*/
+	/* General Functions								 */
+	/*---------------------------------------------------*/
+	/* CheckUpdated -------------------------------------*/
 	/*
-		Just overwrites the BufferData in the ssbo
-		without touching the voxels.
+		Says whether the voxels have changed on the CPU
+		since the last call, i.e. whether the buffer needs
+		writing again (see OctreeBuffer), and flags the
+		octree as changed if so, since the GPU's copy is
+		about to be. Any edits still queued for the GPU
+		will be in what's written, so they're dropped.
+
+		Input: None
+		Output: Whether the voxels need uploading
 	*/
-	void Octree::OverwriteBufferData()
+	bool Octree::CheckUpdated()
 	{
-		Quaternion r = camera->GetRotation();
-		glm::vec3 right = Rotate({ 1.0, 0.0,0.0 }, r);
-		glm::vec3 up = Rotate({ 0.0, 1.0,0.0 }, r);
-		glm::vec3 forward = Rotate({ 0.0, 0.0, 1.0 }, r);
-
-		glm::vec3 pos = camera->GetPosition();
-		pos.z = -camera->GetZoom();
-
-		BufferData bd = { size, camera->GetWidth(), camera->GetHeight(), 0,
-							glm::vec4(camera->GetPosition(), 0),
-							glm::vec4(right, 0),
-							glm::vec4(up, 0),
-							glm::vec4(forward, 0),
-							glm::vec4(center, 0) };
-
-		/*std::cout << "#-------------------------------------------------------------------------------------------#" << std::endl;
-		std::cout << voxels[0].type << " / " << voxels[0].children << std::endl;
-		std::cout << "#-------------------------------------------------------------------------------------------#" << std::endl;*/
-
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
-		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(BufferData), &bd);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		if (!updated) return false;
+
+		updated = false;
+		queuedEdits.clear();
+		HasChanged();
+		return true;
 	}
 
-	/* WriteBuffer --------------------------------------*/
+	/*---------------------------------------------------*/
+	/* Allocation Functions								 */
+	/*---------------------------------------------------*/
+	/* AllocateChildren ---------------------------------*/
 	/*
-		WriteBuffer writes the current voxel data to the
-		SSBO on the GPU.
+		Hands out a block of eight empty children,
+		reusing a pruned block if there is one.
+
+		Input: None
+		Output: Index of the first child
+	*/
+	int Octree::AllocateChildren()
+	{
+		unsigned int block;
+
+		if (!freeBlocks.empty())
+		{
+			block = freeBlocks.back();
+			freeBlocks.pop_back();
+		}
+		else
+		{
+			block = cursor;
+			cursor += 8;
+		}
+
+		for (int i = 0; i < 8; i++) voxels[block + i] = { 0, -1 };
+		return block;
+	}
+
+	/* FreeChildren -------------------------------------*/
+	/*
+		Clears a block of children and puts it on the
+		free list.
+
+		Input: Index of the first child
+		Output: None
 	*/
-	void Octree::WriteBuffer()
+	void Octree::FreeChildren(unsigned int block)
 	{
-		Quaternion r = camera->GetRotation();
-		glm::vec3 right = Rotate({ 1.0, 0.0,0.0 }, r);
-		glm::vec3 up = Rotate({ 0.0, 1.0,0.0 }, r);
-		glm::vec3 forward = Rotate({ 0.0, 0.0, 1.0 }, r);
-
-		glm::vec3 pos = camera->GetPosition();
-		pos.z = -camera->GetZoom();
-
-		BufferData bd = { size, camera->GetWidth(), camera->GetHeight(), 0,
-							glm::vec4(camera->GetPosition(), 0),
-							glm::vec4(right, 0),
-							glm::vec4(up, 0),
-							glm::vec4(forward, 0),
-							glm::vec4(center, 0) };
-
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
-		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(BufferData), &bd);
-		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(BufferData), nVoxels * sizeof(Voxel), voxels);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		for (int i = 0; i < 8; i++) voxels[block + i] = { 0, -1 };
+		freeBlocks.push_back(block);
 	}
 
 	/*---------------------------------------------------*/
@@ -150,9 +217,66 @@ namespace Winedark
 		// ...
 		// ...
 
+		/*
+			Our voxels have to have caught up with the GPU
+			before we change them here.
+		*/
+		SyncMirror();
+
+		// Tell the system we're updating the octree.
+		updated = true;
+		if (journal != nullptr) journal->Record(x, y, z, t);
+		MarkDirty(x, y, z);
+
+		SetVoxel(x, y, z, t);
+	}
+
+	/* RemoveVoxel --------------------------------------*/
+	/*
+		RemoveVoxel removes a voxel and prunes any
+		resultiny empty branches. Rather than shifting
+		memory around to avoid holes in the voxel array
+		(which would mean fixing up every child pointer
+		past the hole), pruned blocks of children go on
+		a free list and are reused by AddVoxel.
+
+		Input: (Global) Coordinates
+		Output: None
+	*/
+	void Octree::RemoveVoxel(unsigned int x, unsigned int y, unsigned int z)
+	{
+		/*
+			We should check to see if the voxel requested
+			lies outside the current window, in which case
+			we'll need to set it some other way.
+		*/
+		// ...
+		// ...
+		// ...
+
+		SyncMirror();
+
 		// Tell the system we're updating the octree.
 		updated = true;
+		if (journal != nullptr) journal->Record(x, y, z, 0);
+		MarkDirty(x, y, z);
+
+		ClearVoxel(x, y, z);
+	}
 
+	/*---------------------------------------------------*/
+	/* Tree Functions								     */
+	/*---------------------------------------------------*/
+	/* SetVoxel -----------------------------------------*/
+	/*
+		Does the work of AddVoxel, without telling anyone.
+		edit.comp does exactly the same on the GPU.
+
+		Input: (Global) Coordinates & Type
+		Output: None
+	*/
+	void Octree::SetVoxel(unsigned int x, unsigned int y, unsigned int z, unsigned int t)
+	{
 		/*
 			First, we need to traverse down our voxel tree
 			and add any missing non-leaf voxels in higher
@@ -175,25 +299,21 @@ namespace Winedark
 			unsigned int octant = Diff2Oct({ x - c.x, y - c.y, z - c.z });
 
 			// This means we need to add children.
-			if (target->children < 0)
-			{
-				target->children = cursor;
-				cursor += 8;
-			}
+			if (target->children < 0) target->children = AllocateChildren();
 
 			/*
 				Now we grab the next target
 				(which may be our final true
-				target, if s == 1).
+				target, if s == 2).
 			*/
 			target = &voxels[target->children + octant];
 
 			/*
-				If our current size is 1 then we just need
-				to set the child of the current target to
-				the correct type and break.
+				If our current size is 2 then the children
+				are single voxels, so we just need to set the
+				type of the current target and break.
 			*/
-			if (s == 1)
+			if (s == 2)
 			{
 				target->type = t;
 				break;
@@ -209,31 +329,16 @@ namespace Winedark
 		}
 	}
 
-	/* RemoveVoxel --------------------------------------*/
+	/* ClearVoxel ---------------------------------------*/
 	/*
-		RemoveVoxel removes a voxel and prunes any
-		resultiny empty branches. This is significantly
-		more complex than adding a voxel as it requires
-		us to shift memory around to avoid holes in the
-		voxel array.
+		Does the work of RemoveVoxel, without telling
+		anyone. Like SetVoxel, edit.comp mirrors it.
 
 		Input: (Global) Coordinates
 		Output: None
 	*/
-	void Octree::RemoveVoxel(unsigned int x, unsigned int y, unsigned int z)
+	void Octree::ClearVoxel(unsigned int x, unsigned int y, unsigned int z)
 	{
-		/*
-			We should check to see if the voxel requested
-			lies outside the current window, in which case
-			we'll need to set it some other way.
-		*/
-		// ...
-		// ...
-		// ...
-
-		// Tell the system we're updating the octree.
-		updated = true;
-
 		/*
 			First, we need to grab all the voxels
 			in the branch corresponding to the target.
@@ -259,55 +364,52 @@ namespace Winedark
 			*/
 			unsigned int octant = Diff2Oct({ x - c.x, y - c.y, z - c.z });
 
-			// This means we need to add children.
-			if (target->children < 0)
-			{
-				target->children = cursor;
-				for (int i = 0; i < 8; i++)
-				{
-					voxels[cursor] = { 0, -1 };
-					cursor++;
-				}
-			}
+			/*
+				If there are no children here, then the
+				voxel we're after is already empty.
+			*/
+			if (target->children < 0) return;
 
 			/*
 				Now we grab the next target
 				(which may be our final true
-				target, if s == 1).
+				target, if s == 2).
 			*/
 			target = &voxels[target->children + octant];
 			branch.push_back(target);
 
 			/*
-				If our current size is 1 then we can break.
+				If our current size is 2 then we can break.
 			*/
-			if (s == 1) break;
+			if (s == 2) break;
 
 			/*
 				Now, we need to update the position of
 				our oct centerpoint. This
 			*/
 			glm::vec3 o = offsets[octant] * (float)s;
-			c += 0;
+			c += o;
 			s /= 2;
 		}
 
+		target->type = 0;
+
 		/*
 			Now that we have our branch, we can work from
-			the end backward. For each node, we check if
-			it has any active children and then break
-			if so. Otherwise, we prune the branch and its
-			children and shift the whole array back to
-			write over the resulting gap.
+			the parent of the removed voxel backward. For
+			each node, we check if it has any active
+			children and then break if so. Otherwise, we
+			prune its children and make it a leaf.
 		*/
-		for (int i = branch.size() - 1; i >= 0; i--)
+		for (int i = branch.size() - 2; i >= 0; i--)
 		{
 			target = branch[i];
 			bool hasChildren = false;
 
 			for (int j = 0; j < 8; j++)
 			{
-				if (voxels[target->children + j].type != 0)
+				Voxel& child = voxels[target->children + j];
+				if (child.type != 0 || child.children >= 0)
 				{
 					hasChildren = true;
 					break;
@@ -324,9 +426,8 @@ namespace Winedark
 				If we're here, that means we can prune
 				this branch.
 			*/
-			memcpy(voxels + target->children, voxels + target->children + 8, ((double)nVoxels - (double)target->children) * sizeof(Voxel));
-			cursor -= 8;
-			memset(voxels + cursor, 0, ((double)cursor - (double)target->children) * sizeof(Voxel));
+			FreeChildren(target->children);
+			target->children = -1;
 		}
 	}
 
@@ -336,8 +437,10 @@ namespace Winedark
 	*/
 	unsigned int Octree::CountTypedVoxels()
 	{
+		SyncMirror();
+
 		unsigned int n = 0;
-		for (int i = 1; i < nVoxels; i++)
+		for (unsigned int i = 1; i < nVoxels; i++)
 		{
 			if (voxels[i].type > 0) n++;
 		}
@@ -345,39 +448,165 @@ namespace Winedark
 	}
 
 	/*---------------------------------------------------*/
-	/* Constructor										 */
+	/* GPU Edit Functions								 */
 	/*---------------------------------------------------*/
+	/* EditVoxel ----------------------------------------*/
+	/*
+		Queues an edit for a VoxelEditor to apply on the
+		GPU. Until there's a buffer there's nothing to
+		apply it to, so it's just an AddVoxel or
+		RemoveVoxel.
+
+		Input: (Global) Coordinates & Type (0 clears)
+		Output: None
+	*/
+	void Octree::EditVoxel(unsigned int x, unsigned int y, unsigned int z, uint16_t t)
+	{
+		if (!buffered)
+		{
+			if (t == 0) RemoveVoxel(x, y, z);
+			else AddVoxel(x, y, z, t);
+			return;
+		}
+
+		if (journal != nullptr) journal->Record(x, y, z, t);
+		MarkDirty(x, y, z);
+
+		queuedEdits.push_back({ x, y, z, t });
+		unsyncedEdits.push_back({ x, y, z, t });
+	}
+
+	/* TakeEdits ----------------------------------------*/
 	/*
-		This function takes world data from the disk and
-		generates a sparse voxel octree representing it.
+		Hands over the edits queued since the last call,
+		on the understanding that they're about to be
+		applied to the buffer.
+
+		Input: Vector to put the edits in
+		Output: Whether there are any
+	*/
+	bool Octree::TakeEdits(std::vector<VoxelEdit>& edits)
+	{
+		edits.swap(queuedEdits);
+		queuedEdits.clear();
+
+		if (edits.empty()) return false;
 
-		For now, it just randomly inserts voxels of
-		random colors so that we can test rendering.
+		HasChanged();
+		return true;
+	}
+
+	/* SyncMirror ---------------------------------------*/
+	/*
+		Catches our voxels up with the edits we've queued
+		for the GPU, by making them ourselves.
+
+		Input: None
+		Output: None
+	*/
+	void Octree::SyncMirror()
+	{
+		if (unsyncedEdits.empty()) return;
+
+		PROFILE_SCOPE("Octree::SyncMirror");
+
+		for (VoxelEdit& edit : unsyncedEdits)
+		{
+			if (edit.type == 0) ClearVoxel(edit.x, edit.y, edit.z);
+			else SetVoxel(edit.x, edit.y, edit.z, edit.type);
+		}
+
+		unsyncedEdits.clear();
+	}
+
+	/*---------------------------------------------------*/
+	/* Storage Functions								 */
+	/*---------------------------------------------------*/
+	/* Rebuild ------------------------------------------*/
+	/*
+		Rebuild is called after the first n voxels of the
+		pool have been written to directly (e.g. decoded
+		from disk). Anything past them is reset to empty
+		leaves so AddVoxel can keep growing the tree, and
+		any block nobody points to goes back on the free
+		list.
+
+		The voxels are checked first: every child pointer
+		has to be the start of a block of 8 that lies
+		within them. If one isn't, nothing is touched and
+		we return false, since whatever wrote them can't
+		be trusted (a corrupt save, say).
+
+		Input:		Number of voxels written
+		Output:		Whether the voxels fit in the octree
+	*/
+	bool Octree::Rebuild(unsigned int n)
+	{
+		PROFILE_SCOPE("Octree::Rebuild");
+
+		if (n == 0 || n > nVoxels) return false;
+
+		for (unsigned int i = 0; i < n; i++)
+		{
+			int children = voxels[i].children;
+			if (children < 0) continue;
+
+			if (children < 1 || (children - 1) % 8 != 0 || (unsigned int)children + 8 > n) return false;
+		}
+
+		for (unsigned int i = n; i < nVoxels; i++) voxels[i] = { 0, -1 };
+
+		cursor = n;
+		updated = true;
+		allDirty = true;
+
+		std::vector<bool> used((n + 7) / 8, false);
+		for (unsigned int i = 0; i < n; i++)
+		{
+			if (voxels[i].children > 0) used[(voxels[i].children - 1) / 8] = true;
+		}
+
+		freeBlocks.clear();
+		for (unsigned int b = 1; b + 8 <= n; b += 8)
+		{
+			if (!used[(b - 1) / 8]) FreeChildren(b);
+		}
+
+		return true;
+	}
+
+	/*---------------------------------------------------*/
+	/* Constructor										 */
+	/*---------------------------------------------------*/
+	/*
+		This function sets up an empty sparse voxel
+		octree. It gets filled in either by one of the
+		world generators (see generator.h) or by loading
+		a saved world (see journal.h).
 
 		Input:		Size of loaded area (width / height / depth).
 		Output:		None
 	*/
-	Octree::Octree(unsigned int size, Camera* camera)
+	Octree::Octree(unsigned int size)
 	{
-		srand(time(NULL));
-
 		// First, we set up some preliminary variables.
-		this->camera = camera;
+		this->journal = nullptr;
 
 		this->changed = false;
 		this->updated = false;
+		this->allDirty = false;
 		this->size = size;
 		this->nVoxels = 0;
 		this->nLayers = 1 + log2(size);
 		this->cursor = 1;
-		this->ssbo = 0;
+		this->buffered = false;
 
-		double h = (size - 0.5) / 2.0;
+		float h = (size - 0.5f) / 2.0f;
 		this->center = { h, h, h };
 
 		// Now we figure out the maximum number of voxels
 		// we might have.
-		for (int i = 1; i <= size; i *= 2)
+		for (unsigned int i = 1; i <= size; i *= 2)
 		{
 			nVoxels += (i * i * i);
 		}
@@ -388,52 +617,21 @@ namespace Winedark
 		// We'll check to see malloc worked fine.
 		if (voxels == NULL) return;
 
-		for (int i = 0; i < nVoxels; i++) voxels[i] = { 0, -1 };
+		for (unsigned int i = 0; i < nVoxels; i++) voxels[i] = { 0, -1 };
 
 		// And for utility purposes we're gonna store
 		// some values for later.
 		offsets =
 		{
 			{ -0.25, -0.25, -0.25 },
-			{ -0.25, -0.25, 0.25 },
-			{ -0.25, 0.25, -0.25 },
-			{ -0.25, 0.25, 0.25 },
 			{ 0.25, -0.25, -0.25 },
-			{ 0.25, -0.25, 0.25 },
+			{ -0.25, 0.25, -0.25 },
 			{ 0.25, 0.25, -0.25 },
+			{ -0.25, -0.25, 0.25 },
+			{ 0.25, -0.25, 0.25 },
+			{ -0.25, 0.25, 0.25 },
 			{ 0.25, 0.25, 0.25 },
 		};
-
-		/*---------------------------------------------------*/
-		/* TEMPORARY TEMPORARY TEMPORARY TEMPORARY TEMPORARY */
-		/*---------------------------------------------------*/
-		for (int x = 0; x < size; x++)
-		{
-			for (int y = 0; y < size; y++)
-			{
-				for (int z = 0; z < size; z++)
-				{
-					int r = rand() % 100 + 1;
-
-					if (r > 50)
-					{
-						AddVoxel(x, y, z, 1);
-					}
-				}
-			}
-		}
-		/*---------------------------------------------------*/
-		/* TEMPORARY TEMPORARY TEMPORARY TEMPORARY TEMPORARY */
-		/*---------------------------------------------------*/
-
-		// And finally, we should set up our buffer.
-		ssbo = 0;
-		glGenBuffers(1, &ssbo);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(BufferData) + (nVoxels * sizeof(Voxel)), nullptr, GL_DYNAMIC_COPY);
-		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, ssbo);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 	}
 
 	/*---------------------------------------------------*/
@@ -448,7 +646,6 @@ namespace Winedark
 	*/
 	Octree::~Octree()
 	{
-		glDeleteBuffers(1, &ssbo);
 		free(voxels);
 	}
 }
\ No newline at end of file
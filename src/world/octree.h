@@ -4,12 +4,13 @@
 #include <vector>
 #include <cstdint>
 #include <glm/vec3.hpp>
-#include <glad/glad.h>
 
-#include "../rendering/camera.h"
+#include "../util/geometry.h"
 
 namespace Winedark
 {
+	class EditJournal;
+
 	/*----------------------------------------------------------------------------------------------*/
 	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
 	/* Sparse Voxel Octree																			*/
@@ -39,25 +40,19 @@ namespace Winedark
 	};
 
 	/*-----------------------------------------------------------------------*/
-	/* Buffer Data															 */
+	/* Voxel Edit															 */
 	/*-----------------------------------------------------------------------*/
 	/*
-		Because certain information is necessary to perform the raycasts
-		in the compute shader, we have a neat little struct here to bundle
-		that up and make sending it to the GPU easier.
+		An edit to be applied to the octree's buffer on the GPU (see
+		VoxelEditor). A type of 0 clears the voxel. Laid out exactly as
+		the Edit struct in edit.comp.
 	*/
-	struct BufferData
+	struct VoxelEdit
 	{
-		unsigned int	size;
-		unsigned int	viewWidth;
-		unsigned int	viewHeight;
-		unsigned int	padding;
-
-		glm::vec4		cameraPosition;
-		glm::vec4		cameraRight;
-		glm::vec4		cameraUp;
-		glm::vec4		cameraForward;
-		glm::vec4		centerPosition;
+		unsigned int	x;
+		unsigned int	y;
+		unsigned int	z;
+		unsigned int	type;
 	};
 
 	/*-----------------------------------------------------------------------*/
@@ -82,14 +77,30 @@ namespace Winedark
 
 		It is important that each voxel is situated exactly like so in
 		memory so that we can easily traverse the tree.
+
+		EditVoxel queues an edit for the GPU instead of changing the tree
+		here, so editing doesn't mean uploading the voxels again. Once a
+		VoxelEditor has applied them, the voxels (our mirror of the
+		buffer) are behind, and we only catch up by replaying the edits
+		when something asks for them (SyncMirror). The GPU allocates
+		blocks exactly as we do, so replaying them leaves the mirror the
+		same as the buffer, bit for bit. The allocator's state (the
+		cursor and the free list) goes up with the voxels on a full
+		upload.
+
+		None of that happens here, though: the buffer is an
+		OctreeBuffer's, on the rendering side, and all the octree knows
+		is whether there is one (SetBuffered). Without one, EditVoxel
+		just edits the tree, so the octree works the same with no GL at
+		all (a server, say).
 	*/
 	class Octree
 	{
 	private:
 		/*-----------------------------------------------------*/
-		/* Camera											   */
+		/* Journal											   */
 		/*-----------------------------------------------------*/
-		Camera*					camera;
+		EditJournal*			journal;
 
 		/*-----------------------------------------------------*/
 		/* Flags											   */
@@ -99,7 +110,7 @@ namespace Winedark
 		/*-----------------------------------------------------*/
 		/* Buffer											   */
 		/*-----------------------------------------------------*/
-		GLuint					ssbo;
+		bool					buffered;
 
 		/*-----------------------------------------------------*/
 		/* Voxels											   */
@@ -111,6 +122,19 @@ namespace Winedark
 		unsigned int			nVoxels;
 		unsigned int			cursor;
 		bool					updated;
+		std::vector<unsigned int>	freeBlocks;
+
+		/*-----------------------------------------------------*/
+		/* GPU Edits										   */
+		/*-----------------------------------------------------*/
+		std::vector<VoxelEdit>	queuedEdits;
+		std::vector<VoxelEdit>	unsyncedEdits;
+
+		/*-----------------------------------------------------*/
+		/* Dirty Boxes										   */
+		/*-----------------------------------------------------*/
+		std::vector<Box>		dirtyBoxes;
+		bool					allDirty;
 
 		/*-----------------------------------------------------*/
 		/* Utility											   */
@@ -119,26 +143,39 @@ namespace Winedark
 		std::vector<glm::vec3>	offsets;
 
 		/*-----------------------------------------------------*/
-		/* Buffer Functions	1								   */
+		/* Allocation Functions								   */
 		/*-----------------------------------------------------*/
-		void					WriteBuffer();
+		int						AllocateChildren();
+		void					FreeChildren(unsigned int block);
+
+		/*-----------------------------------------------------*/
+		/* Tree Functions									   */
+		/*-----------------------------------------------------*/
+		void					SetVoxel(unsigned int x, unsigned int y, unsigned int z, unsigned int t);
+		void					ClearVoxel(unsigned int x, unsigned int y, unsigned int z);
+
+		/*-----------------------------------------------------*/
+		/* Dirty Box Functions 1							   */
+		/*-----------------------------------------------------*/
+		void					MarkDirty(unsigned int x, unsigned int y, unsigned int z);
 
 	public:
 		/*-----------------------------------------------------*/
 		/* General Functions								   */
 		/*-----------------------------------------------------*/
-		void					Update();
-		GLuint					GetSSBO() { return ssbo; }
+		bool					CheckUpdated();
+		void					SetBuffered(bool buffered) { this->buffered = buffered; }
 
 		/*-----------------------------------------------------*/
 		/* Flag Functions									   */
 		/*-----------------------------------------------------*/
 		bool					CheckChanged();
+		bool					IsChanged() { return changed; }
 
 		/*-----------------------------------------------------*/
-		/* Buffer Functions 2								   */
+		/* Dirty Box Functions 2							   */
 		/*-----------------------------------------------------*/
-		void					OverwriteBufferData();
+		bool					TakeDirtyBoxes(std::vector<Box>& boxes);
 
 		/*-----------------------------------------------------*/
 		/* Voxel Functions									   */
@@ -147,10 +184,28 @@ namespace Winedark
 		void					RemoveVoxel(unsigned int x, unsigned int y, unsigned int z);
 		unsigned int			CountTypedVoxels();
 
+		/*-----------------------------------------------------*/
+		/* GPU Edit Functions								   */
+		/*-----------------------------------------------------*/
+		void					EditVoxel(unsigned int x, unsigned int y, unsigned int z, uint16_t t);
+		bool					TakeEdits(std::vector<VoxelEdit>& edits);
+		void					SyncMirror();
+
+		/*-----------------------------------------------------*/
+		/* Storage Functions								   */
+		/*-----------------------------------------------------*/
+		unsigned int			GetSize() { return size; }
+		unsigned int			GetCursor() { SyncMirror(); return cursor; }
+		unsigned int			GetCapacity() { return nVoxels; }
+		Voxel*					GetVoxels() { SyncMirror(); return voxels; }
+		const std::vector<unsigned int>&	GetFreeBlocks() { SyncMirror(); return freeBlocks; }
+		bool					Rebuild(unsigned int n);
+		void					SetJournal(EditJournal* journal) { this->journal = journal; }
+
 		/*-----------------------------------------------------*/
 		/* Constructor & Deconstructor						   */
 		/*-----------------------------------------------------*/
-		Octree(unsigned int size, Camera* camera);
+		Octree(unsigned int size);
 		~Octree();
 	};
 }
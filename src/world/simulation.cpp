@@ -0,0 +1,65 @@
+#include "simulation.h"
+
+#include "../util/profiler.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Simulation																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*---------------------------------------------------*/
+	/* Edit Functions									 */
+	/*---------------------------------------------------*/
+	/* QueueEdit ----------------------------------------*/
+	/*
+		Queues an edit for the next tick. Anything outside
+		the world is dropped here rather than there.
+
+		Input: (Global) Coordinates & Type (0 clears)
+		Output: None
+	*/
+	void Simulation::QueueEdit(unsigned int x, unsigned int y, unsigned int z, uint16_t t)
+	{
+		unsigned int size = octree->GetSize();
+		if (x >= size || y >= size || z >= size) return;
+
+		queuedEdits.push_back({ x, y, z, t });
+	}
+
+	/*---------------------------------------------------*/
+	/* Tick Functions									 */
+	/*---------------------------------------------------*/
+	/* Tick ---------------------------------------------*/
+	/*
+		Moves the world on by one tick.
+
+		Input: None
+		Output: None
+	*/
+	void Simulation::Tick()
+	{
+		PROFILE_SCOPE("Simulation::Tick");
+
+		for (VoxelEdit& edit : queuedEdits) octree->EditVoxel(edit.x, edit.y, edit.z, edit.type);
+
+		edits += queuedEdits.size();
+		queuedEdits.clear();
+
+		entities.Update();
+		if (journal != nullptr) journal->Update(octree);
+		ticks++;
+	}
+
+	/*-----------------------------------------------------*/
+	/* Constructor										   */
+	/*-----------------------------------------------------*/
+	Simulation::Simulation(Octree* octree, EditJournal* journal)
+	{
+		this->octree = octree;
+		this->journal = journal;
+		this->ticks = 0;
+		this->edits = 0;
+	}
+}
\ No newline at end of file
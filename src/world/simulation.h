@@ -0,0 +1,83 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <vector>
+#include <cstdint>
+
+#include "octree.h"
+#include "journal.h"
+#include "entitytree.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Simulation																					*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Simulation															 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Everything that happens to the world from one tick to the next,
+		whether or not anyone's drawing it. Edits (from input, or from
+		whoever's connected to a server) are queued as they come in and
+		made in order on the next Tick, which then lets the journal
+		flush or checkpoint if it's time.
+
+		Edits go through Octree::EditVoxel, so with a renderer's buffer
+		about they're applied on the GPU and without one (winedark_server)
+		they're made on the CPU. Either way the octree ends up the same.
+
+		Whatever moves about in the world (ships, creatures) is indexed
+		in an EntityTree, which each Tick gives the chance to swap in a
+		rebuild or start one.
+	*/
+	class Simulation
+	{
+	private:
+		/*-----------------------------------------------------*/
+		/* World											   */
+		/*-----------------------------------------------------*/
+		Octree*					octree;
+		EditJournal*			journal;
+
+		/*-----------------------------------------------------*/
+		/* Edits											   */
+		/*-----------------------------------------------------*/
+		std::vector<VoxelEdit>	queuedEdits;
+
+		/*-----------------------------------------------------*/
+		/* Entities											   */
+		/*-----------------------------------------------------*/
+		EntityTree				entities;
+
+		/*-----------------------------------------------------*/
+		/* Counters											   */
+		/*-----------------------------------------------------*/
+		unsigned long long		ticks;
+		unsigned long long		edits;
+
+	public:
+		/*-----------------------------------------------------*/
+		/* Edit Functions									   */
+		/*-----------------------------------------------------*/
+		void					QueueEdit(unsigned int x, unsigned int y, unsigned int z, uint16_t t);
+
+		/*-----------------------------------------------------*/
+		/* Tick Functions									   */
+		/*-----------------------------------------------------*/
+		void					Tick();
+		unsigned long long		GetTicks() { return ticks; }
+		unsigned long long		GetEdits() { return edits; }
+		Octree*					GetOctree() { return octree; }
+		EntityTree*				GetEntities() { return &entities; }
+
+		/*-----------------------------------------------------*/
+		/* Constructor										   */
+		/*-----------------------------------------------------*/
+		Simulation(Octree* octree, EditJournal* journal = nullptr);
+	};
+}
+
+#endif
\ No newline at end of file
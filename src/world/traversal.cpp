@@ -0,0 +1,216 @@
+#include "traversal.h"
+
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Ray Traversal																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Shared Traversal														 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		traverse.glsl, compiled as C++. Every GLSL built-in it uses is in
+		glm under the same name, and it reads the voxels through a member
+		of the same name as the shader's voxel buffer. Its functions end
+		up as members of Traversal, and its macros (NO_HIT and the like)
+		stay in this file.
+	*/
+	namespace GLSL
+	{
+		using namespace glm;
+
+		struct Traversal
+		{
+			const Voxel*	voxels;
+
+			#include "../../assets/shaders/traverse.glsl"
+		};
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Helper Functions														 */
+	/*-----------------------------------------------------------------------*/
+	/* LookUp -----------------------------------------------*/
+	/*
+		LookUp() walks down from the root to the leaf holding
+		the given voxel and returns its type.
+
+		Input: Voxels, octree size & coordinates
+		Output: Type
+	*/
+	static unsigned int LookUp(const Voxel* voxels, unsigned int size, const int cell[3])
+	{
+		int index = 0;
+		int corner[3] = { 0, 0, 0 };
+		int s = (int)size;
+
+		while (voxels[index].children >= 0)
+		{
+			s /= 2;
+
+			int octant = 0;
+			for (int i = 0; i < 3; i++)
+			{
+				if (cell[i] >= corner[i] + s)
+				{
+					octant |= 1 << i;
+					corner[i] += s;
+				}
+			}
+
+			index = voxels[index].children + octant;
+		}
+
+		return voxels[index].type;
+	}
+
+	/*-----------------------------------------------------------------------*/
+	/* Traversal Functions													 */
+	/*-----------------------------------------------------------------------*/
+	/* TraceRay ---------------------------------------------*/
+	/*
+		TraceRay() runs the compute shader's traversal on the
+		CPU.
+
+		Input: Voxels, octree size, ray & where to start along it
+		Output: Hit
+	*/
+	RayHit TraceRay(const Voxel* voxels, unsigned int size, glm::vec3 origin, glm::vec3 direction, float tStart)
+	{
+		GLSL::Traversal traversal;
+		traversal.voxels = voxels;
+
+		unsigned int steps = 0;
+		GLSL::Traversal::Hit hit = traversal.Trace(origin, direction, size, tStart, steps);
+
+		return { hit.t, hit.type, hit.face };
+	}
+
+	/* MarchRay ---------------------------------------------*/
+	/*
+		MarchRay() steps through the grid one voxel at a time
+		(Amanatides & Woo's DDA), from where the ray comes
+		into the octree, and returns the first solid voxel.
+
+		Input: Voxels, octree size & ray
+		Output: Hit
+	*/
+	RayHit MarchRay(const Voxel* voxels, unsigned int size, glm::vec3 origin, glm::vec3 direction)
+	{
+		RayHit hit = { RAY_MISS, 0, 0 };
+		float half = size * 0.5f;
+
+		/*
+			We nudge the ray off the axes exactly as the trace
+			does, so the two are tracing the same ray.
+		*/
+		for (int i = 0; i < 3; i++)
+		{
+			if (std::abs(direction[i]) < 1e-6f) direction[i] = (direction[i] < 0.0f) ? -1e-6f : 1e-6f;
+		}
+
+		/*
+			First, where the ray comes into the grid and through
+			which face. Ties go to x, then y, as in the trace.
+		*/
+		float tNear = -RAY_MISS;
+		float tFar = RAY_MISS;
+		unsigned int face = 0;
+
+		for (int i = 0; i < 3; i++)
+		{
+			float t0 = (-half - origin[i]) / direction[i];
+			float t1 = (half - origin[i]) / direction[i];
+			if (t0 > t1) std::swap(t0, t1);
+
+			if (t0 > tNear)
+			{
+				tNear = t0;
+				face = i;
+			}
+			if (t1 < tFar) tFar = t1;
+		}
+
+		if (tNear >= tFar) return hit;
+
+		/*
+			Then we step from voxel to voxel, always across
+			whichever of the next planes is nearest, until we
+			either find a solid one or leave the grid.
+		*/
+		glm::vec3 p = origin + direction * tNear;
+		int cell[3];
+		int step[3];
+
+		for (int i = 0; i < 3; i++)
+		{
+			cell[i] = std::min(std::max((int)std::floor(p[i] + half), 0), (int)size - 1);
+			step[i] = (direction[i] > 0.0f) ? 1 : -1;
+		}
+
+		float t = tNear;
+		while (true)
+		{
+			unsigned int type = LookUp(voxels, size, cell);
+			if (type != 0)
+			{
+				hit = { t, type, face };
+				return hit;
+			}
+
+			/*
+				A ray straight through an edge or a corner only
+				touches the voxels around it, so like the trace we
+				step across every plane it meets there at once.
+			*/
+			float tPlane[3];
+			float tNext = RAY_MISS;
+
+			for (int i = 0; i < 3; i++)
+			{
+				float plane = (float)(cell[i] + ((step[i] > 0) ? 1 : 0)) - half;
+				tPlane[i] = (plane - origin[i]) / direction[i];
+				if (tPlane[i] < tNext) tNext = tPlane[i];
+			}
+
+			t = tNext;
+			face = 3;
+
+			for (int i = 0; i < 3; i++)
+			{
+				if (tPlane[i] > tNext) continue;
+				if (face == 3) face = i;
+
+				cell[i] += step[i];
+				if (cell[i] < 0 || cell[i] >= (int)size) return hit;
+			}
+		}
+	}
+
+	/* PackHit ----------------------------------------------*/
+	/*
+		PackHit() packs a hit for the G-buffer, with the same
+		code as the compute shader.
+
+		Input: Hit
+		Output: Packed hit
+	*/
+	unsigned int PackHit(RayHit hit)
+	{
+		GLSL::Traversal traversal;
+		traversal.voxels = nullptr;
+
+		GLSL::Traversal::Hit packed;
+		packed.t = hit.t;
+		packed.type = hit.type;
+		packed.face = hit.face;
+
+		return traversal.Pack(packed);
+	}
+}
\ No newline at end of file
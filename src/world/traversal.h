@@ -0,0 +1,53 @@
+#ifndef TRAVERSAL_H
+#define TRAVERSAL_H
+
+#include <glm/vec3.hpp>
+
+#include "octree.h"
+
+namespace Winedark
+{
+	/*----------------------------------------------------------------------------------------------*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/* Ray Traversal																				*/
+	/* -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- */
+	/*----------------------------------------------------------------------------------------------*/
+	/*-----------------------------------------------------------------------*/
+	/* Ray Hit																 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		The first solid voxel along a ray: how far along the ray it is,
+		its type and the axis the ray came into it through (0 for x, 1
+		for y and 2 for z). A miss is RAY_MISS away, with a type of 0.
+	*/
+	const float RAY_MISS = 1e30f;
+
+	struct RayHit
+	{
+		float			t;
+		unsigned int	type;
+		unsigned int	face;
+	};
+
+	/*-----------------------------------------------------------------------*/
+	/* Traversal Functions													 */
+	/*-----------------------------------------------------------------------*/
+	/*
+		Rays are in the octree's own space, as in the compute shader:
+		the octree is centered on the origin, so voxel (x, y, z) spans
+		(x, y, z) - size / 2 to one more than that.
+
+		TraceRay is the very same traversal the compute shader does,
+		built from traverse.glsl, so the two can't drift apart. MarchRay
+		is the reference we check both against: a plain DDA through
+		every voxel of the grid, looking each one up from the root. It's
+		slow, but simple enough to trust.
+
+		PackHit packs a hit the way the trace writes it to the G-buffer.
+	*/
+	RayHit			TraceRay(const Voxel* voxels, unsigned int size, glm::vec3 origin, glm::vec3 direction, float tStart = -RAY_MISS);
+	RayHit			MarchRay(const Voxel* voxels, unsigned int size, glm::vec3 origin, glm::vec3 direction);
+	unsigned int	PackHit(RayHit hit);
+}
+
+#endif
\ No newline at end of file